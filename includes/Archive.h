@@ -0,0 +1,237 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __ARCHIVE__
+#define __ARCHIVE__
+/*
+Binary archive of evaluated circuits.
+
+An archive is a single file holding the circuits of one number of units:
+a 64 byte header followed by fixed size records, appended in the order they are
+written. As every record has the same size, the record number is its index, and
+record k starts at byte 64 + k * record_size.
+
+Header (all integers little endian on the machines we use, the archive is not
+meant to be moved between machines of different byte order):
+    char[8]   magic, "GALENAAR"
+    uint32    version
+    uint32    num_units
+    uint32    record_size, in bytes
+    uint32    reserved
+    uint64    number of records, only updated once they have been written, so
+              a torn write at the end of the file is ignored
+    padding up to 64 bytes
+
+Record, for n units:
+    double    performance
+    double    gormanium[n + 2], flows into each unit, the concentrate and the tailings
+    double    waste[n + 2]
+    int32     run
+    int32     generation
+    uint16    flags, bit 0 set if the flows are stored
+    uint16    genes[2n + 1]
+    padding up to a multiple of 8 bytes
+*/
+
+// system includes
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// thrown if an archive cannot be opened, is not an archive or has a corrupt header, or is for
+// another number of units
+class BadArchive : public std::exception
+{
+public:
+    virtual const char *what() const throw()
+    {
+        return "Cannot open circuit archive";
+    }
+};
+
+/*
+Appends circuits to an archive. The records are gathered in memory and written in
+large blocks, so archiving a circuit costs a copy, not a system call. Append can be
+called from several threads at once.
+
+@param path: std::string, path of the archive, created if it does not exist. Records
+                are appended to an existing archive, which must be for the same number
+                of units
+@param num_units: int, number of units of the circuits
+@param buffer_records: int (optional), number of records gathered before a write, default to 4096
+*/
+class ArchiveWriter
+{
+public:
+    ArchiveWriter(const std::string &path, int num_units, int buffer_records = 4096);
+
+    // flushes the remaining records
+    ~ArchiveWriter();
+
+    /*
+    Add a circuit to the archive.
+
+    @param circuit: std::vector<int>, the circuit
+    @param performance: double, its performance
+    @param run: int, identifier of the run that produced it
+    @param generation: int, generation in which it was found
+    @param gormanium: std::vector<double> (optional), flows of gormanium, size num_units + 2,
+                        empty if not known
+    @param waste: std::vector<double> (optional), flows of waste, size num_units + 2,
+                        empty if not known
+    */
+    void Append(const std::vector<int> &circuit,
+                double performance,
+                int run,
+                int generation,
+                const std::vector<double> &gormanium = {},
+                const std::vector<double> &waste = {});
+
+    // write the gathered records and update the number of records of the header
+    void Flush();
+
+    // number of records in the archive, including the ones not written yet
+    std::uint64_t size() const;
+
+    int num_units() const { return num_units_; }
+
+private:
+    void Flush_Locked();
+
+    int num_units_;
+    std::size_t record_size_;
+    std::size_t buffer_records_;
+    std::fstream file_;
+    std::uint64_t written_{0};
+    std::vector<char> buffer_{};
+    mutable std::mutex lock_;
+};
+
+/*
+A record of an archive, read in place from the mapped file.
+*/
+class ArchiveRecord
+{
+public:
+    ArchiveRecord(const char *data, int num_units) : data_{data}, num_units_{num_units} {}
+
+    double performance() const { return Get<double>(0); }
+    // flow of gormanium into unit i, i = num_units for the concentrate, num_units + 1 for the tailings
+    double gormanium(int i) const { return Get<double>(8 * (1 + i)); }
+    double waste(int i) const { return Get<double>(8 * (1 + num_units_ + 2 + i)); }
+    int run() const { return Get<std::int32_t>(Fixed()); }
+    int generation() const { return Get<std::int32_t>(Fixed() + 4); }
+    bool has_flows() const { return Get<std::uint16_t>(Fixed() + 8) & 1; }
+    int gene(int i) const { return Get<std::uint16_t>(Fixed() + 10 + 2 * i); }
+
+    int num_units() const { return num_units_; }
+
+    // copies of the circuit and flows, for the functions that take vectors
+    std::vector<int> Circuit() const;
+    std::vector<double> Gormanium() const;
+    std::vector<double> Waste() const;
+
+private:
+    // offset of the fields after the flows
+    std::size_t Fixed() const { return 8 * (1 + 2 * (num_units_ + 2)); }
+
+    template <typename T>
+    T Get(std::size_t offset) const
+    {
+        T value;
+        std::memcpy(&value, data_ + offset, sizeof(T));
+        return value;
+    }
+
+    const char *data_;
+    int num_units_;
+};
+
+/*
+Reads an archive by mapping it in memory: opening an archive of millions of
+circuits is immediate and only the pages that are used are read from disk.
+Records written after the reader was opened are not seen.
+
+@param path: std::string, path of the archive
+*/
+class ArchiveReader
+{
+public:
+    ArchiveReader(const std::string &path);
+
+    ~ArchiveReader();
+
+    ArchiveReader(const ArchiveReader &) = delete;
+    ArchiveReader &operator=(const ArchiveReader &) = delete;
+
+    ArchiveRecord operator[](std::uint64_t i) const
+    {
+        return ArchiveRecord(data_ + HEADER_SIZE + i * record_size_, num_units_);
+    }
+
+    std::uint64_t size() const { return size_; }
+
+    int num_units() const { return num_units_; }
+
+    static constexpr std::size_t HEADER_SIZE = 64;
+
+private:
+    void Close();
+
+    const char *data_{nullptr};
+    std::size_t length_{0};
+    std::uint64_t size_{0};
+    int num_units_{0};
+    std::size_t record_size_{0};
+#ifdef _WIN32
+    void *file_{nullptr};
+    void *mapping_{nullptr};
+#endif
+};
+
+/*
+Convert records of an archive to text files in the format of data/Note, which can
+be drawn by visualisation.py. Each record is written by utils::Print_Circuit_To_File
+to circuit_[num_units]_[generation].txt, so later records of the same generation
+replace earlier ones: select a single run to keep one file per generation.
+
+@param archive_path: std::string, path of the archive
+@param directory: std::string, folder to write the files to
+@param run: int (optional), only convert the records of this run, -1 for all, default to -1
+
+@return converted: int, number of records converted
+*/
+int Archive_To_Text(const std::string &archive_path, const std::string &directory, int run = -1);
+
+/*
+Write records of an archive to a single Graphviz DOT file, one graph per record named
+run_[run]_generation_[generation], with utils::Append_Dot. `dot -Tpng -O file.dot` renders
+them all.
+
+@param archive_path: std::string, path of the archive
+@param dot_path: std::string, path of the DOT file
+@param run: int (optional), only convert the records of this run, -1 for all, default to -1
+
+@return converted: int, number of records converted
+*/
+int Archive_To_Dot(const std::string &archive_path, const std::string &dot_path, int run = -1);
+
+#endif // !__ARCHIVE__
@@ -0,0 +1,312 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __BACKGROUND_WRITER__
+#define __BACKGROUND_WRITER__
+/*
+Output of the solver written by a background thread.
+References:
+D. Vyukov, "Bounded MPMC queue", 1024cores.net, 2010.
+*/
+
+// system includes
+// local includes
+#include "Unit_Fractions.h"
+
+// system includes
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+Bounded multi-producer multi-consumer queue. Push and Pop never lock: each cell
+carries a sequence number telling whether it is free for the producer of a given
+position or full for its consumer, and threads claim positions with a compare and
+swap on the enqueue or dequeue counter.
+
+@param capacity: std::size_t, maximum number of elements, rounded up to a power of two
+*/
+template <typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+        mask_ = size - 1;
+        cells_.reset(new Cell[size]);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    // move value into the queue, false (and value untouched) if the queue is full
+    bool Push(T &value)
+    {
+        std::size_t position = enqueue_.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &cells_[position & mask_];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+            if (difference == 0)
+            {
+                if (enqueue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = enqueue_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // move the oldest element into value, false if the queue is empty
+    bool Pop(T &value)
+    {
+        std::size_t position = dequeue_.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &cells_[position & mask_];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(position + 1);
+            if (difference == 0)
+            {
+                if (dequeue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = dequeue_.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->data);
+        cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // approximate number of elements, exact when no other thread uses the queue
+    std::size_t size() const
+    {
+        std::size_t enqueued = enqueue_.load(std::memory_order_relaxed);
+        std::size_t dequeued = dequeue_.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_;
+    // on separate cache lines, producers and consumers do not slow each other down
+    alignas(64) std::atomic<std::size_t> enqueue_{0};
+    alignas(64) std::atomic<std::size_t> dequeue_{0};
+};
+
+/*
+A file to write, handed from the compute threads to the writer thread.
+
+@member kind: Kind, a circuit in the data/Note format, a line appended to a file, or a
+                circuit appended to a file as a line of JSON
+@member path: std::string, folder of the circuit file, or the file the line is appended to
+@member schematic, gormanium, waste, iteration, performance, fractions: circuit, as for
+                                            utils::Print_Circuit_To_File
+@member run: int, run identifier of a JSON circuit
+@member line: std::string, line to append, without its new line
+*/
+struct OutputRequest
+{
+    enum class Kind
+    {
+        Circuit,
+        Line,
+        Json
+    };
+    Kind kind{Kind::Circuit};
+    std::string path{};
+    std::vector<int> schematic{};
+    std::vector<double> gormanium{};
+    std::vector<double> waste{};
+    int iteration{0};
+    double performance{-1e9};
+    UnitFractions fractions{};
+    int run{0};
+    std::string line{};
+};
+
+/*
+Counters of a BackgroundWriter, to tell whether the writer keeps up.
+
+@member submitted: number of requests handed to the writer
+@member written: number of requests written
+@member batches: number of times the writer thread woke up and emptied the queue
+@member full_waits: number of requests that found the queue full, and made their
+                    thread wait for the writer (back pressure)
+@member max_depth: largest number of requests seen waiting in the queue
+*/
+struct WriterStats
+{
+    std::uint64_t submitted{0};
+    std::uint64_t written{0};
+    std::uint64_t batches{0};
+    std::uint64_t full_waits{0};
+    std::uint64_t max_depth{0};
+};
+
+/*
+Writes files on a background thread, so that the compute threads only pay for
+copying their data into a lock-free queue. The writer thread drains the queue in
+batches, formats the numbers with std::to_chars and keeps the files it appends
+lines to open for the whole batch. If the queue is full, the submitting thread
+waits for the writer. Destroying the writer (or calling Flush) writes everything
+submitted before.
+
+@param capacity: std::size_t (optional), number of requests the queue can hold, default to 4096
+*/
+class BackgroundWriter
+{
+public:
+    BackgroundWriter(std::size_t capacity = 4096);
+
+    // flushes and stops the writer thread
+    ~BackgroundWriter();
+
+    BackgroundWriter(const BackgroundWriter &) = delete;
+    BackgroundWriter &operator=(const BackgroundWriter &) = delete;
+
+    /*
+    Write a circuit file, with the same name and contents as utils::Print_Circuit_To_File.
+
+    @param path: std::string, path of the folder the data file should be stored in
+    @param schematic: std::vector<int>, circuit to be exported
+    @param gormanium: std::vector<double> (optional), flow volumes of gormanium into each cell
+    @param waste: std::vector<double> (optional), flow volumes of waste into each cell
+    @param iter: int (optional), the current generation, default to 0
+    @param performance: double (optional), the performance of the circuit, default to -1e9
+    @param fractions: UnitFractions (optional), concentrate fractions of the units, default to uniform
+    */
+    void Write_Circuit(const std::string &path,
+                       const std::vector<int> &schematic,
+                       const std::vector<double> &gormanium = {},
+                       const std::vector<double> &waste = {},
+                       int iter = 0,
+                       double performance = -1e9,
+                       const UnitFractions &fractions = UnitFractions());
+
+    /*
+    Append a line to a file, creating it if needed.
+
+    @param path: std::string, path of the file
+    @param line: std::string, the line, a new line is added after it
+    */
+    void Append_Line(const std::string &path, std::string line);
+
+    /*
+    Append a circuit to a file as one line of JSON:
+    {"run": 0, "generation": 12, "performance": 123.4, "circuit": [...], "gormanium": [...], "waste": [...]}
+    The flows are left out if they are empty.
+
+    @param path: std::string, path of the file
+    @param run: int, identifier of the run
+    @param generation: int, generation of the circuit
+    @param schematic: std::vector<int>, the circuit
+    @param gormanium: std::vector<double>, flow volumes of gormanium into each cell
+    @param waste: std::vector<double>, flow volumes of waste into each cell
+    @param performance: double, the performance of the circuit
+    */
+    void Log_Circuit(const std::string &path,
+                     int run,
+                     int generation,
+                     const std::vector<int> &schematic,
+                     const std::vector<double> &gormanium,
+                     const std::vector<double> &waste,
+                     double performance);
+
+    // hand over a request
+    void Submit(OutputRequest &request);
+
+    // wait until every request submitted so far is written
+    void Flush();
+
+    WriterStats Stats() const;
+
+private:
+    void Run();
+    void Write(std::vector<OutputRequest> &batch);
+
+    BoundedQueue<OutputRequest> queue_;
+    std::atomic<std::uint64_t> submitted_{0};
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> batches_{0};
+    std::atomic<std::uint64_t> full_waits_{0};
+    std::atomic<std::uint64_t> max_depth_{0};
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> sleeping_{false};
+    // only used to sleep and wake up, the queue itself is lock-free
+    std::mutex lock_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::thread thread_;
+};
+
+/*
+The writer shared by the whole program, started on first use and flushed when the
+program exits.
+
+@return writer: BackgroundWriter, the shared writer
+*/
+BackgroundWriter &Output_Writer();
+
+#endif // !__BACKGROUND_WRITER__
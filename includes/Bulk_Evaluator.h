@@ -0,0 +1,111 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __BULK_EVALUATOR__
+#define __BULK_EVALUATOR__
+
+// system includes
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+/*
+Options of Bulk_Evaluate.
+
+@member binary_input: bool, whether the circuits are binary records (a uint16 number of units n,
+                        then the 2n+1 uint16 genes, little-endian) rather than text
+@member binary_output: bool, whether the results are binary records (an int32 validity code, then
+                        the performance and the gormanium and waste flows into the concentrate as
+                        doubles, NaN for an invalid circuit) rather than comma separated text
+@member header: bool, whether the text output starts with the names of the columns
+@member flow_rate_gormanium, flow_rate_waste: double, feed of the circuits [kg/s]
+@member price_gormanium, cost_waste: double, prices [GBP/kg]
+@member tolerance, max_iterations: double, int, convergence of the flows, see Evaluate_Flows
+@member chunk_size: int, number of circuits read, evaluated and written at a time
+*/
+struct BulkOptions
+{
+    bool binary_input{false};
+    bool binary_output{false};
+    bool header{true};
+    double flow_rate_gormanium{10.0};
+    double flow_rate_waste{100.0};
+    double price_gormanium{100.0};
+    double cost_waste{500.0};
+    double tolerance{1e-4};
+    int max_iterations{1000};
+    int chunk_size{1 << 16};
+};
+
+/*
+Counts of a bulk evaluation.
+
+@member circuits: std::uint64_t, number of circuits read
+@member valid: std::uint64_t, number of valid circuits
+*/
+struct BulkStats
+{
+    std::uint64_t circuits{0};
+    std::uint64_t valid{0};
+};
+
+/*
+Validate and evaluate one circuit, given as an array of genes. This is what
+Bulk_Evaluate does for every circuit, see there for the validity codes.
+
+@param genes: const int *, the genes of the circuit
+@param size: size_t, number of genes, 2 * num_units + 1
+@param options: BulkOptions, the problem (the formats and chunk size are not used)
+@param performance: double, set to the performance, NaN if not scored
+@param concentrate_gormanium, concentrate_waste: double, set to the flows into the
+                        concentrate [kg/s], NaN if not scored
+
+@return code: int, the validity code
+*/
+int Bulk_Evaluate_Circuit(const int *genes, std::size_t size, const BulkOptions &options,
+                          double &performance, double &concentrate_gormanium, double &concentrate_waste);
+
+/*
+Stream circuits through validation and evaluation: one result per circuit, in the
+order of the input. The circuits are handled in chunks: a chunk is evaluated in
+parallel (utils::Parallel_For) while the next one is read, then written, so the
+memory used does not depend on the size of the input.
+
+The text input is the format of the files of `data/` (see data/Note), one after
+the other: a line of comma or space separated genes is a circuit, and the optional
+lines of flows, performance and unit fractions after it are skipped (a line of integers only is
+always a circuit, so circuits of different sizes may follow one another). Empty lines and lines starting
+with # are ignored. Any other line counts as a malformed circuit, so that the
+results stay aligned with the circuits.
+
+The validity code is that of utils::Check_Validity, -1 for a malformed circuit
+(genes out of range, or a line that is not a circuit), 3 if the flows did not
+converge, which are scored like Evaluate_Circuit does (no gormanium and all the
+waste in the concentrate), and 4 if the flows failed the mass balance. Only the
+circuits of code 0 and 3 have a performance and flows.
+
+@param in: std::istream, the circuits
+@param out: std::ostream, the results
+@param options: BulkOptions, formats, problem and chunk size
+
+@return stats: BulkStats, number of circuits read and of valid ones
+*/
+BulkStats Bulk_Evaluate(std::istream &in, std::ostream &out, const BulkOptions &options = BulkOptions());
+
+#endif // !__BULK_EVALUATOR__
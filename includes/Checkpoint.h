@@ -0,0 +1,99 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __CHECKPOINT__
+#define __CHECKPOINT__
+
+// system includes
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+Everything Genetic_Optimization needs to carry on from the start of a generation
+exactly as if it had never stopped. The performances of the population are not
+stored: evaluating a circuit is deterministic, so they are recomputed when the run
+resumes.
+
+@member num_units: int, number of units of the circuits
+@member problem: vector<double>, numbers that define the problem the run solves (see
+                    Genetic_Optimization), a checkpoint is only resumed by a run of the same problem
+@member generation: int, index of the generation the population belongs to
+@member count_for_threshold: int, number of generations without improvement
+@member old_best_performance: double, best performance of the previous generation
+@member finished: bool, whether the run has terminated, in which case best_circuit is its result
+@member adaptive_rate: vector<double>, adaptive crossover and mutation rates
+@member population: vector<vector<int>>, circuits of the generation, not evaluated yet
+@member best_circuit: vector<int>, best circuit of the previous generation, which is the
+                        result of the run once finished
+@member rng: std::mt19937, state of the random number generator of the run
+*/
+struct GeneticCheckpoint
+{
+    int num_units{0};
+    std::vector<double> problem{};
+    int generation{0};
+    int count_for_threshold{1};
+    double old_best_performance{0.0};
+    bool finished{false};
+    std::vector<double> adaptive_rate{};
+    std::vector<std::vector<int>> population{};
+    std::vector<int> best_circuit{};
+    std::mt19937 rng{};
+};
+
+/*
+Write a checkpoint to a binary file.
+
+The genes are stored as 16 bit integers and the random number generator as its raw
+state words, so the checkpoint of a population of 200 circuits of 10 units is about
+11 kB. The file is first written next to its destination and then renamed over it,
+so a run killed while writing always leaves the previous checkpoint intact. The
+file uses the byte order of the machine.
+
+@param path: string, path of the checkpoint file
+@param checkpoint: GeneticCheckpoint, the state to write
+
+@return success: bool, whether the checkpoint was written
+*/
+bool Save_Checkpoint(const std::string &path, const GeneticCheckpoint &checkpoint);
+
+/*
+Read a checkpoint written by Save_Checkpoint, if it belongs to a run of the given problem.
+The header is checked against the run before anything is allocated, so a damaged file
+cannot ask for more memory than the population of the run.
+
+@param path: string, path of the checkpoint file
+@param checkpoint: GeneticCheckpoint, structure to store the state in
+@param num_units: int, number of units of the circuits of the run
+@param population_size: int, number of circuits of the population of the run
+@param problem: vector<double>, numbers that define the problem of the run, see GeneticCheckpoint
+
+@return success: bool, false if the file does not exist, is truncated, is not a checkpoint,
+                 belongs to another problem, number of units or population size, or holds
+                 a circuit that is not valid for its number of units
+*/
+bool Load_Checkpoint(
+    const std::string &path,
+    GeneticCheckpoint &checkpoint,
+    int num_units,
+    int population_size,
+    const std::vector<double> &problem
+);
+
+#endif // !__CHECKPOINT__
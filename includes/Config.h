@@ -0,0 +1,133 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __CONFIG__
+#define __CONFIG__
+
+// local includes
+#include "Genetic_Algorithm.h"
+
+// system includes
+#include <string>
+#include <vector>
+
+/*
+Parameters of the solver executable, read from a configuration file and the command line.
+
+The feed rates, prices, costs and numbers of units are lists: a single value for the
+ga, steady, pareto and exhaustive modes, and the values of each axis of the grid in
+sweep mode.
+
+@member mode: std::string, "ga" (default), "steady", "pareto", "exhaustive", "sweep" or "serve"
+@member population_size: int, the size of each generation
+@member max_iterations: int, maximum number of generations
+@member threshold: int, number of generations without improvement after which a run stops
+@member runs: int, number of runs of the solver (per grid point in sweep mode)
+@member num_units, flow_rate_gormanium, flow_rate_waste, price_gormanium, cost_waste: the problem
+@member adaptive_rate: std::vector<double>, adaptive crossover and mutation rates
+@member options: GeneticOptions, optional features of the Genetic Algorithm
+@member hall_of_fame_injection: int, generations without improvement after which a run takes the
+                                best circuit of all the runs, -1 for a third of threshold, 0 never
+@member sensitivity: bool, whether to print the gradient of the performance of the best circuit of the
+                    ga and steady modes with respect to the operating parameters (see Performance_Sensitivity)
+@member top_k: int, number of circuits reported by the exhaustive search
+@member checkpoint_directory: std::string, folder for the checkpoints of the runs, empty for none
+@member archive: std::string, path of the archive of the best circuit of every generation, empty for none
+@member design_index: std::string, path of the index of the best circuits of past problems used to
+                        start the runs (see Design_Index.h), empty for none
+@member evaluation_database: std::string, path of the persistent database of evaluated circuits shared
+                            by all the jobs (see Evaluation_Database.h), empty for none. In sweep mode
+                            with several numbers of units, one file per number of units is used, named
+                            after the path with the number of units appended
+@member socket: std::string, path of the socket of the server, in serve mode
+@member output: std::string, path of the table of results (sweep and pareto modes)
+*/
+struct SolverConfig
+{
+    std::string mode{"ga"};
+    int population_size{200};
+    int max_iterations{10000};
+    int threshold{300};
+    int runs{20};
+    std::vector<int> num_units{10};
+    std::vector<double> flow_rate_gormanium{10.0};
+    std::vector<double> flow_rate_waste{100.0};
+    std::vector<double> price_gormanium{100.0};
+    std::vector<double> cost_waste{500.0};
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    GeneticOptions options{};
+    int hall_of_fame_injection{-1};
+    bool sensitivity{false};
+    int top_k{10};
+    std::string checkpoint_directory{};
+    std::string archive{};
+    std::string design_index{};
+    std::string evaluation_database{};
+    std::string socket{"galena.sock"};
+    std::string output{"results.csv"};
+};
+
+/*
+Set one parameter from its text value. Lists are separated by commas, and
+start:stop:step stands for the values from start to stop (included) by step.
+
+Keys: mode, population_size, max_iterations, threshold, runs, num_units,
+flow_rate_gormanium, flow_rate_waste, price_gormanium, cost_waste, adaptive_rate,
+seed, selection (roulette, alias, sus or tournament), tournament_size,
+local_search_elites, local_search_budget, local_search_pair_swap, canonical_labels,
+fractions_gormanium and fractions_waste (the concentrate fractions of each unit, see
+UnitFractions), scenarios, robust_objective (expected or worst), feed_spread, fraction_spread and
+scenario_seed (the robust evaluation, see RobustOptions), single_precision (screening of the
+scenarios in float, see GeneticOptions), hall_of_fame_injection, sensitivity, top_k, warm_start, checkpoint, log, archive, design_index,
+evaluation_database, socket, output
+
+@param config: SolverConfig, the configuration to update
+@param key: std::string, name of the parameter
+@param value: std::string, its value
+
+@throw std::invalid_argument if the key is unknown or the value cannot be read
+*/
+void Set_Config_Value(SolverConfig &config, const std::string &key, const std::string &value);
+
+/*
+Read a configuration file: one `key = value` per line, `#` starts a comment.
+
+@param path: std::string, path of the file
+@param config: SolverConfig, the configuration to update
+
+@throw std::invalid_argument if the file cannot be read or has a bad line
+*/
+void Read_Config_File(const std::string &path, SolverConfig &config);
+
+/*
+Read the command line: `--config FILE` reads a configuration file, and `--key value`
+(or `--key=value`) sets any key of Set_Config_Value. The arguments are applied in
+order, so the command line can override values of the file.
+
+@param argc: int, number of arguments
+@param argv: char*[], the arguments
+@param config: SolverConfig, the configuration to update
+
+@throw std::invalid_argument if an argument is not understood
+*/
+void Parse_Arguments(int argc, char *argv[], SolverConfig &config);
+
+// description of the command line, for error messages
+std::string Config_Usage(const std::string &program);
+
+#endif // !__CONFIG__
@@ -0,0 +1,143 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __DESIGN_INDEX__
+#define __DESIGN_INDEX__
+
+// system includes
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+Index of the best circuits found for past problems, to start new runs from them.
+
+The flows are proportional to the feed and the performance to the prices, so the
+best circuit of a problem only depends on its number of units, on the ratio of the
+price of gormanium to the cost of waste, and on the ratio of the gormanium to the
+waste fed. The circuits are stored under these three values, keeping the
+per_key best of each, and problems are near when their ratios are close.
+
+The index is kept in a text file, one circuit per line, read at construction and
+written by Save (and by the destructor if anything was added).
+
+@param path: std::string (optional), file of the index, read if it exists, empty for an
+                index kept in memory only
+@param per_key: int (optional), number of circuits kept per problem, default to 5
+*/
+class DesignIndex
+{
+public:
+    DesignIndex(const std::string &path = "", int per_key = 5);
+
+    ~DesignIndex();
+
+    DesignIndex(const DesignIndex &) = delete;
+    DesignIndex &operator=(const DesignIndex &) = delete;
+
+    /*
+    Add a circuit found for a problem, unless per_key better ones are already stored.
+    Can be called from several threads at once.
+
+    @param circuit: std::vector<int>, the circuit
+    @param performance: double, its performance for the problem
+    @param flow_rate_gormanium, flow_rate_waste: double, feed of the problem [kg/s]
+    @param price_gormanium, cost_waste: double, prices of the problem [GBP/kg]
+    */
+    void Add(const std::vector<int> &circuit,
+             double performance,
+             double flow_rate_gormanium,
+             double flow_rate_waste,
+             double price_gormanium,
+             double cost_waste);
+
+    /*
+    Circuits of num_units units stored for the problems nearest to the given one, the
+    nearest problem first, and the best circuits of each problem first.
+
+    @param num_units: int, number of units of the circuits
+    @param flow_rate_gormanium, flow_rate_waste, price_gormanium, cost_waste: double, the problem
+    @param count: int, maximum number of circuits returned
+
+    @return circuits: std::vector<std::vector<int>>, distinct circuits
+    */
+    std::vector<std::vector<int>> Nearest(int num_units,
+                                          double flow_rate_gormanium,
+                                          double flow_rate_waste,
+                                          double price_gormanium,
+                                          double cost_waste,
+                                          int count) const;
+
+    // write the index to its file, true if there is no file
+    bool Save();
+
+    // number of circuits stored
+    std::size_t size() const;
+
+private:
+    struct Entry
+    {
+        int num_units;
+        double price_ratio;
+        double feed_ratio;
+        // performance divided by the cost of the waste fed, the same for all the
+        // problems of the same ratios
+        double relative_performance;
+        std::vector<int> circuit;
+    };
+
+    std::string path_;
+    int per_key_;
+    std::vector<Entry> entries_{};
+    bool modified_{false};
+    mutable std::mutex lock_;
+};
+
+/*
+All the valid circuits of one more unit obtained by inserting a new unit on one
+stream of a circuit: the stream (the feed, or a concentrate or tailings) goes to the
+new unit, one output of the new unit goes where the stream went, and the other
+anywhere else. The new unit is the last unit of the circuit.
+
+@param circuit: std::vector<int>, a circuit of n units
+
+@return grown: std::vector<std::vector<int>>, distinct valid circuits of n + 1 units
+*/
+std::vector<std::vector<int>> Grow_Circuit(const std::vector<int> &circuit);
+
+/*
+Best starting circuits for a problem: the circuits of num_units units of the nearest
+problems of the index, and the circuits of num_units - 1 units of the nearest problems
+grown by one unit, ranked by their performance for the problem.
+
+@param index: DesignIndex, the index
+@param count: int, number of circuits wanted
+@param num_units: int, number of units of the problem
+@param flow_rate_gormanium, flow_rate_waste, price_gormanium, cost_waste: double, the problem
+
+@return circuits: std::vector<std::vector<int>>, at most count circuits, best first
+*/
+std::vector<std::vector<int>> Warm_Start_Circuits(const DesignIndex &index,
+                                                  int count,
+                                                  int num_units,
+                                                  double flow_rate_gormanium,
+                                                  double flow_rate_waste,
+                                                  double price_gormanium,
+                                                  double cost_waste);
+
+#endif // !__DESIGN_INDEX__
@@ -0,0 +1,171 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __EVALUATION_DATABASE__
+#define __EVALUATION_DATABASE__
+
+// system includes
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+
+/*
+Thrown when a file cannot be opened as an evaluation database, or holds one for
+another number of units or another tolerance of the flow solver.
+*/
+class BadEvaluationDatabase : public std::exception
+{
+public:
+    virtual const char *what() const throw()
+    {
+        return "Cannot open evaluation database";
+    }
+};
+
+/*
+Converged flows leaving a circuit, which do not depend on the price of gormanium or
+on the cost of waste.
+
+A circuit that did not converge is stored with converged false, no gormanium and
+all the waste in the concentrate, like in PopulationFlows.
+
+@member conc_gormanium, conc_waste: double, flows into the final concentrate [kg/s]
+@member tail_gormanium, tail_waste: double, flows into the final tailings [kg/s]
+@member converged: bool, whether the flow solver converged
+*/
+struct CircuitFlows
+{
+    double conc_gormanium{0.0};
+    double conc_waste{0.0};
+    double tail_gormanium{0.0};
+    double tail_waste{0.0};
+    bool converged{false};
+};
+
+/*
+Persistent table of the flows of evaluated circuits, keyed by the gene, the feed
+rates and the concentrate fractions of the units, so that it stays valid when the
+prices change and every later job with the same number of units starts with the
+circuits evaluated by the previous ones.
+
+The file is an open-addressing hash table mapped in memory and shared by all the
+processes and threads that open it. Entries are added without locks: a slot is
+claimed with a compare-and-swap of its tag, filled, then published by storing the
+hash in the tag, so a reader never sees a half-written entry. Entries are never
+modified or removed. The file is only locked while it is created. When three
+quarters of the slots are used, new circuits are no longer added.
+
+@param path: std::string, path of the database, created if it does not exist
+@param num_units: int, number of units of the circuits
+@param capacity: std::uint64_t (optional), number of slots of a new database, rounded up
+                    to a power of two, default to 2^20. Ignored if the file exists
+@param tolerance: double (optional), tolerance of the flow solver of the stored flows,
+                    default to 1e-4
+@param max_iterations: int (optional), iterations of the flow solver of the stored flows,
+                        default to 1000
+
+@throw BadEvaluationDatabase if the file cannot be created or mapped, or holds a
+        database of another number of units, tolerance or number of iterations
+*/
+class EvaluationDatabase
+{
+public:
+    EvaluationDatabase(const std::string &path,
+                       int num_units,
+                       std::uint64_t capacity = 1 << 20,
+                       double tolerance = 1e-4,
+                       int max_iterations = 1000);
+
+    ~EvaluationDatabase();
+
+    EvaluationDatabase(const EvaluationDatabase &) = delete;
+    EvaluationDatabase &operator=(const EvaluationDatabase &) = delete;
+
+    /*
+    Find the flows of a circuit.
+
+    @param circuit: std::vector<int>, gene of the circuit
+    @param input_gormanium, input_waste: double, feed rates of the circuit [kg/s]
+    @param fraction_gormanium, fraction_waste: double, fractions of the feed of a unit
+                                                sent to its concentrate
+    @param flows: CircuitFlows, set to the stored flows if found
+
+    @return found: bool, whether the circuit is in the database
+    */
+    bool Lookup(const std::vector<int> &circuit,
+                double input_gormanium,
+                double input_waste,
+                double fraction_gormanium,
+                double fraction_waste,
+                CircuitFlows &flows) const;
+
+    /*
+    Add the flows of a circuit, same parameters as Lookup.
+
+    @return stored: bool, false if the database is full or the circuit is not one of
+                    num_units units. A circuit already stored is left as it is
+    */
+    bool Insert(const std::vector<int> &circuit,
+                double input_gormanium,
+                double input_waste,
+                double fraction_gormanium,
+                double fraction_waste,
+                const CircuitFlows &flows);
+
+    // number of circuits stored, by all the processes
+    std::uint64_t size() const;
+
+    std::uint64_t capacity() const { return capacity_; }
+
+    int num_units() const { return num_units_; }
+
+    double tolerance() const { return tolerance_; }
+
+    int max_iterations() const { return max_iterations_; }
+
+    // number of lookups of this object that found, and did not find, their circuit
+    std::uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    std::uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+    static constexpr std::size_t HEADER_SIZE = 64;
+
+private:
+    std::uint64_t Hash(const std::vector<int> &circuit, const double key[4]) const;
+    bool Matches(const char *slot, const std::vector<int> &circuit, const double key[4]) const;
+    std::atomic<std::uint64_t> &Tag(std::uint64_t slot) const;
+    std::atomic<std::uint64_t> &Count() const;
+    void Close();
+
+    int num_units_;
+    std::uint64_t capacity_{0};
+    double tolerance_;
+    int max_iterations_;
+    std::size_t slot_size_;
+    char *data_{nullptr};
+    std::size_t length_{0};
+    mutable std::atomic<std::uint64_t> hits_{0};
+    mutable std::atomic<std::uint64_t> misses_{0};
+#ifdef _WIN32
+    void *file_{nullptr};
+    void *mapping_{nullptr};
+#endif
+};
+
+#endif // !__EVALUATION_DATABASE__
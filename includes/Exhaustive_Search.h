@@ -0,0 +1,73 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __EXHAUSTIVE_SEARCH__
+#define __EXHAUSTIVE_SEARCH__
+
+// local includes
+#include "Genetic_Algorithm.h"
+
+// system includes
+#include <vector>
+
+/*
+Exact solver for small circuits.
+
+Relabelling the units of a circuit does not change its performance, so only one
+labelling of every circuit needs to be evaluated. We enumerate the circuits whose
+labels follow the order in which a breadth first traversal from the feed discovers
+the units (looking at the concentrate before the tailings of each unit): the feed
+goes to unit 0, and the destination of every pipe is either an already discovered
+unit, an output, or the next unused label. These are the circuits left unchanged by
+utils::Canonical_Circuit, and every circuit whose units are all reachable from the feed
+has exactly one such labelling, so the enumeration is complete.
+
+Partial circuits are pruned as soon as a unit is not reachable, a unit recycles to
+itself or sends both streams to the same place, or the remaining pipes are too few to
+reach every unit. The remaining circuits go through Check_Validity and are evaluated
+in parallel, each thread keeping its own top-K list.
+
+The number of circuits grows very quickly with the number of units, this is meant
+for circuits of up to about 6 units.
+
+@param num_units: int, number of units in a circuit
+@param top_k: int, number of best circuits to return, at least 1
+@param top_performance: std::vector<double>, vector to store the performance of the returned circuits
+@param evaluated: long long, set to the number of valid circuits evaluated
+@param flow_rate_gormanium: double (optional), kg/s gormanium flowing into the circuit, default to 10
+@param flow_rate_waste: double (optional), kg/s waste flowing into the circuit, default to 100
+@param price_gormanium: double (optional), £/kg of gormanium in the concentrate, default to 100
+@param cost_waste: double (optional), £/kg of waste in the concentrate, default to 500
+
+@return top_circuits: vector<vector<int>>, the top_k best circuits by decreasing performance,
+                        the first one being the global optimum
+
+Throws std::invalid_argument if top_k is less than 1
+*/
+std::vector<std::vector<int>> Exhaustive_Optimization(
+    int num_units,
+    int top_k,
+    std::vector<double> &top_performance,
+    long long &evaluated,
+    double flow_rate_gormanium = 10.0,
+    double flow_rate_waste = 100.0,
+    double price_gormanium = 100.0,
+    double cost_waste = 500.0
+);
+
+#endif // !__EXHAUSTIVE_SEARCH__
@@ -28,7 +28,15 @@ Group members:
 #include <chrono>
 #include "utils.h"
 #include "CUnit.h"
-#endif
+#include "Selection.h"
+#include "Hall_Of_Fame.h"
+#include "Checkpoint.h"
+#include "Archive.h"
+#include "Background_Writer.h"
+#include "Evaluation_Database.h"
+#include "Design_Index.h"
+#include "Unit_Fractions.h"
+#include "Robust.h"
 
 /*
 This function calculates the mass flow rates in the circuit. We make use
@@ -59,6 +67,9 @@ performance calculation, if the user decides so.
                         default to 10kg/s
 @param input_waste: double (optional), mass flow rate of waste fed into circuit [kg/s],
                         default to 100kg/s
+@param fractions: UnitFractions (optional), concentrate fractions of each unit, default to
+                        FRACTION_GORMANIUM and FRACTION_WASTE for every unit. Throws
+                        std::invalid_argument if they are not valid for the circuit
 */
 void Evaluate_Flows(
     std::vector<double> &new_feed_gormanium,
@@ -69,7 +80,8 @@ void Evaluate_Flows(
     double gormanium_price = 100.0,
     double waste_cost = 500.0,
     double input_gormanium = 10.0,
-    double input_waste = 100.0);
+    double input_waste = 100.0,
+    const UnitFractions &fractions = UnitFractions());
 
 /*
 This function calculates the performance of the circuit as the difference
@@ -84,7 +96,8 @@ disposal in the concentrate.
 @param circuit_vector: std::vector<int>, integer vector representing the circuit
                         of size 2*No.Units+1
 @param write_to_file: bool (optional), whether to store the circuit in evaluation into
-                        a data file, default to false
+                        a data file, default to false. The file is written in the background
+                        by Output_Writer(), call its Flush() before reading it
 @param current_it: int (optional), current generation, default to 0
 @param tolerance: double (optional), maximum relative error allowed for convergence,
                     default to 1e-4
@@ -99,6 +112,8 @@ disposal in the concentrate.
                         default to 10kg/s
 @param input_waste: double (optional), mass flow rate of waste feed into circuit [kg/s],
                         default to 100kg/s
+@param fractions: UnitFractions (optional), concentrate fractions of each unit, written
+                        to the data file when they are not uniform, see Evaluate_Flows
 
 @return performance: double, earnings from the gormanium in output -
                             cost to dispose waste in output
@@ -112,7 +127,143 @@ double Evaluate_Circuit(
     double gormanium_price = 100.0,
     double waste_cost = 500.0,
     double input_gormanium = 10.0,
-    double input_waste = 100.0);
+    double input_waste = 100.0,
+    const UnitFractions &fractions = UnitFractions());
+
+/*
+Price-independent summary of the converged flows of a batch of circuits.
+
+The steady-state flows do not depend on the price of gormanium or on the
+cost of waste, which only enter the final dot product of the performance.
+Storing the two concentrate flows per circuit is therefore enough to re-score
+the batch for any economic scenario without re-running the flow solver.
+
+A circuit that did not converge is stored as if all the waste fed into the
+circuit and no gormanium reached the concentrate, so that re-pricing it
+reproduces the penalty returned by Evaluate_Circuit.
+
+@member conc_gormanium: std::vector<double>, gormanium flow into the final concentrate [kg/s]
+@member conc_waste: std::vector<double>, waste flow into the final concentrate [kg/s]
+@member converged: std::vector<char>, 1 if the flows of the circuit converged, 0 otherwise
+*/
+struct PopulationFlows
+{
+    std::vector<double> conc_gormanium{};
+    std::vector<double> conc_waste{};
+    std::vector<char> converged{};
+};
+
+/*
+Evaluate the converged concentrate flows of a whole population once, so that it
+can later be re-priced with Reprice_Population. The circuits are evaluated in parallel.
+
+@param population: vector<vector<int>>, the circuits to evaluate
+@param flows: PopulationFlows, structure to store the concentrate flows, resized to
+                the size of the population
+@param tolerance: double (optional), maximum relative error allowed for convergence,
+                    default to 1e-4
+@param max_iterations: int (optional), number of iterations of the algorithm within which
+                        convergence is expected, default to 1000
+@param input_gormanium: double (optional), mass flow rate of gormanium fed into circuit [kg/s],
+                        default to 10kg/s
+@param input_waste: double (optional), mass flow rate of waste feed into circuit [kg/s],
+                        default to 100kg/s
+@param database: EvaluationDatabase* (optional), persistent flows of circuits already evaluated,
+                    looked up before solving and given the flows of the new circuits, used only
+                    if it was created for the same tolerance and max_iterations and the fractions
+                    are uniform (its key holds a single pair of fractions), default to none
+@param fractions: UnitFractions (optional), concentrate fractions of each unit, see Evaluate_Flows
+*/
+void Evaluate_Population_Flows(
+    const std::vector<std::vector<int>> &population,
+    PopulationFlows &flows,
+    double tolerance = 1e-4,
+    int max_iterations = 1000,
+    double input_gormanium = 10.0,
+    double input_waste = 100.0,
+    EvaluationDatabase *database = nullptr,
+    const UnitFractions &fractions = UnitFractions());
+
+/*
+Score a population of evaluated flows for any number of economic scenarios.
+
+Scenario s uses gormanium_prices[s] and waste_costs[s]. The result is laid out
+scenario by scenario, the performance of circuit i under scenario s being
+performance[s * population_size + i]. The values are identical to those that
+Evaluate_Circuit would return for the same parameters.
+
+@param flows: PopulationFlows, flows obtained from Evaluate_Population_Flows
+@param gormanium_prices: std::vector<double>, price of gormanium of each scenario [GBP/kg]
+@param waste_costs: std::vector<double>, cost of waste of each scenario [GBP/kg],
+                    same size as gormanium_prices
+@param performance: std::vector<double>, vector to store the performances, resized to
+                    number of scenarios * population size
+*/
+void Reprice_Population(
+    const PopulationFlows &flows,
+    const std::vector<double> &gormanium_prices,
+    const std::vector<double> &waste_costs,
+    std::vector<double> &performance);
+
+/*
+Largest amount by which the screening in single precision is expected to underestimate the
+performance of a circuit in double precision. Both solvers stop when the flows change by less
+than the tolerance, but not always at the same iteration, which moves the concentrate by a
+fraction of the tolerance (at most 0.31 times over 20000 random circuits of 10 and 20 units
+under 32 scenarios): the margin is ten times the tolerance of the largest possible income and
+waste charge. A scenario that converges in float only, which Evaluate_Scenario_Flows cannot
+tell, is overestimated, see Screen_Robust_Population.
+
+@param tolerance: double, maximum relative error allowed for convergence
+@param price_gormanium: double, £/kg of gormanium in the concentrate
+@param cost_waste: double, £/kg of waste in the concentrate
+@param flow_rate_gormanium: double, kg/s gormanium flowing into the circuit
+@param flow_rate_waste: double, kg/s waste flowing into the circuit
+
+@return margin: double, in £
+*/
+double Screening_Margin(
+    double tolerance,
+    double price_gormanium,
+    double cost_waste,
+    double flow_rate_gormanium,
+    double flow_rate_waste);
+
+/*
+Circuits of a population screened in single precision that must be evaluated again in double
+precision: the `elites` best ones, and every one whose screened performance is within `margin`
+of the best.
+
+@param performance: std::vector<double>, screened performance of each circuit
+@param elites: int, number of best circuits always refined
+@param margin: double, see Screening_Margin
+
+@return candidates: std::vector<int>, indices of the circuits to refine, best screened first
+*/
+std::vector<int> Refinement_Candidates(const std::vector<double> &performance, int elites, double margin);
+
+/*
+Robust performance of a population, screened with the scenario kernel in single precision and
+evaluated again in double precision where it matters (see Refinement_Candidates). A screening can
+overestimate a circuit by far when one of its scenarios converges in float only, so the refinement
+is repeated until the best circuit is a refined one: as the screening underestimates by less than
+the margin, no circuit left with its screened performance can then be better than the best circuit.
+
+@param population: std::vector<std::vector<int>>, the circuits
+@param scenarios, price_gormanium, cost_waste, objective: see Robust_Population_Performance
+@param performance: std::vector<double>, robust performance of each circuit, resized
+@param margin: double, see Screening_Margin
+
+@return refined: int, number of circuits evaluated again in double precision
+*/
+int Screen_Robust_Population(
+    const std::vector<std::vector<int>> &population,
+    const ScenarioSet &scenarios,
+    double price_gormanium,
+    double cost_waste,
+    RobustObjective objective,
+    std::vector<double> &performance,
+    double margin);
 
 /*
 Generate the initial population to start the Genetic Algorithm.
@@ -127,11 +278,23 @@ we put them into the initial population.
 */
 void Generate_Initial(int population_size, std::vector<std::vector<int>> &parents, int num_units = 10);
 
+/*
+Generate the initial population, drawing the random numbers from rng so that the
+population only depends on the state of the generator.
+
+@param population_size: int, the number of genes in each generation
+@param parents: vector<vector<int>>, vector of vectors to store the initial spopulation
+@param num_units: int, number of units in a circuit
+@param rng: std::mt19937, random number generator
+*/
+void Generate_Initial(int population_size, std::vector<std::vector<int>> &parents, int num_units, std::mt19937 &rng);
+
 /*
 This function calculates the performance vector for all the circuits.
 
 We loop over every circuit and make use of the Evaluate_Circuit function written before
 to get each individual performance. Then put all the performances together into a vector.
+The circuits are evaluated in parallel with utils::Parallel_For.
 
 @param population_size: int, the size of population
 @param population: vector<vector<int>>, all genes in the current generation
@@ -141,6 +304,7 @@ to get each individual performance. Then put all the performances together into
 @param flow_rate_waste: double, kg/s wasteflowing into the circuit
 @param price_gormanium: double, £/kg of gormanium in the concentrate
 @param cost_waste: double, £/kg of waste in the concentrate
+@param fractions: UnitFractions (optional), concentrate fractions of each unit, default to uniform
 */
 void Performance(
     int population_size,
@@ -149,7 +313,8 @@ void Performance(
     double flow_rate_gormanium = 10.0,
     double flow_rate_waste = 100.0,
     double price_gormanium = 100.0,
-    double cost_waste = 500.0
+    double cost_waste = 500.0,
+    const UnitFractions &fractions = UnitFractions()
 );
 
 /*
@@ -165,20 +330,6 @@ where c is our estimated maximum, here is 50000.
 */
 void Fitness(int population_size, std::vector<double> &performance, std::vector<double> &fitness);
 
-/*
-This function creates a probability vector for a generation.
-
-We first calculate the sum of performance of every circuit. Then use
-the roulette method: probability of each circuit is calculated as a ratio of
-individual performance to the sum performance.
-
-@param population_size: int, the size of population
-@param performance: vector<double>, performances of every circuit in the current generation
-@param probability: vector<double>, vector to record the probabilities of all circuits
-                    in this generation
-*/
-void Probability(int population_size, const std::vector<double> &fitness, std::vector<double> &probability);
-
 /*
 This function finds a highest value in a vector of doubles.
 
@@ -217,6 +368,7 @@ fitness is defined by performance + 50000
 @param flow_rate_waste: double, kg/s wasteflowing into the circuit
 @param price_gormanium: double, £/kg of gormanium in the concentrate
 @param cost_waste: double, £/kg of waste in the concentrate
+@param fractions: UnitFractions (optional), concentrate fractions of each unit, default to uniform
 
 @return f_self: double, fitness of the circuit
 */
@@ -225,7 +377,8 @@ double Calculate_Self_Fitness(
     double flow_rate_gormanium = 10.0,
     double flow_rate_waste = 100.0,
     double price_gormanium = 100.0,
-    double cost_waste = 500.0
+    double cost_waste = 500.0,
+    const UnitFractions &fractions = UnitFractions()
 );
 
 /*
@@ -244,24 +397,28 @@ corresponding circuit.
 std::vector<int> Find_Best_Gen(const std::vector<std::vector<int>> &parents, const std::vector<double> &performance, double max_performance);
 
 /*
-This function randomly selects a pair of parents for crossover.
-
-We look into the probability vector. Select a random
-number first. Then use the binary search method to
-get the position of that number.
+Mutation function for selected gene.
 
-@param probability: vector<double>, chosen probabilities of each gene
-                    in the current population
+Randomly select a number. If this number is smaller
+than the mutation rate, do the mutation.
 
-@return mid: int, index of the chosen gene
+@param f_self: double,
+@param f_max: double,
+@param f_avg: double,
+@param f: double,
+@param son: vector<int>, the gene to be mutated
+@param num_units: int, number of units in a circuit
 */
-int Choose_Cross(const std::vector<double> &probability);
+void Mutation(double f_self, double f_max, double f_avg, double f, std::vector<double> &adaptive_rate, std::vector<int> &gene, int num_units);
 
 /*
-Mutation function for selected gene.
+Mutation function for selected gene, drawing its random numbers from rng.
 
-Randomly select a number. If this number is smaller
-than the mutation rate, do the mutation.
+Every gene position still mutates independently with the adaptive mutation rate,
+but instead of drawing one number per position we draw the gaps between mutated
+positions from a geometric distribution (so the number of mutations follows the
+same binomial distribution). The cost is proportional to the number of mutations
+rather than to the length of the gene.
 
 @param f_self: double,
 @param f_max: double,
@@ -269,8 +426,9 @@ than the mutation rate, do the mutation.
 @param f: double,
 @param son: vector<int>, the gene to be mutated
 @param num_units: int, number of units in a circuit
+@param rng: std::mt19937, random number generator
 */
-void Mutation(double f_self, double f_max, double f_avg, double f, std::vector<double> &adaptive_rate, std::vector<int> &gene, int num_units);
+void Mutation(double f_self, double f_max, double f_avg, double f, std::vector<double> &adaptive_rate, std::vector<int> &gene, int num_units, std::mt19937 &rng);
 
 /*
 Cross over function for selected parent genes.
@@ -293,6 +451,187 @@ void Crossover(
     int num_units
 );
 
+/*
+Cross over function for selected parent genes, drawing its random numbers from rng.
+
+@param crossover_rate: double, the probability of doing crossover
+@param father: vector<int>, parent gene 1
+@param mother: vector<int>, parent gene 2
+@param num_units: int, number of units in a circuit
+@param rng: std::mt19937, random number generator
+*/
+void Crossover(
+    double f_max,
+    double f_avg,
+    double f, std::vector<double> &adaptive_rate,
+    std::vector<int> &father,
+    std::vector<int> &mother,
+    int num_units,
+    std::mt19937 &rng
+);
+
+/*
+Hill climb a circuit to a local optimum of its single-gene neighbourhood.
+
+Every valid circuit that differs from the current one by a single gene (and
+optionally by swapping two of its output genes) is evaluated as one batch,
+and the circuit moves to the best improving neighbour. This repeats until no
+neighbour improves the performance or the evaluation budget is exhausted.
+
+@param circuit_vector: std::vector<int>, circuit to improve, replaced by the local optimum
+@param performance: double, performance of circuit_vector, updated with the new performance
+@param budget: int, maximum number of neighbours to evaluate
+@param pair_swap: bool, whether to also consider swapping pairs of genes
+@param flow_rate_gormanium: double (optional), kg/s gormanium flowing into the circuit
+@param flow_rate_waste: double (optional), kg/s wasteflowing into the circuit
+@param price_gormanium: double (optional), £/kg of gormanium in the concentrate
+@param cost_waste: double (optional), £/kg of waste in the concentrate
+@param fractions: UnitFractions (optional), concentrate fractions of each unit, default to uniform
+@param rng: std::mt19937* (optional), when the budget left is smaller than the neighbourhood, the
+            neighbours evaluated are drawn at random with it, default to the first ones in gene order
+
+@return evaluations: int, number of neighbours evaluated
+*/
+int Local_Search(
+    std::vector<int> &circuit_vector,
+    double &performance,
+    int budget,
+    bool pair_swap = false,
+    double flow_rate_gormanium = 10.0,
+    double flow_rate_waste = 100.0,
+    double price_gormanium = 100.0,
+    double cost_waste = 500.0,
+    const UnitFractions &fractions = UnitFractions(),
+    std::mt19937 *rng = nullptr
+);
+
+/*
+Optional features of Genetic_Optimization. The default values reproduce the
+plain adaptive Genetic Algorithm.
+
+@member local_search_elites: int, number of best circuits of every generation improved with
+                                Local_Search before selection, 0 disables the local search
+@member local_search_budget: int, number of neighbour evaluations per generation, shared
+                                equally between the elites, with at least one each
+@member local_search_pair_swap: bool, whether the local search also swaps pairs of genes
+@member canonical_labels: bool, whether to relabel every circuit with utils::Canonical_Circuit
+                            after crossover and mutation, so that circuits that only differ
+                            by the numbering of their units are represented by the same gene
+@member selection: SelectionMethod, how parents are selected for crossover, default to an
+                    exact roulette wheel sampled with an alias table
+@member tournament_size: int, number of circuits in each tournament of SelectionMethod::Tournament
+@member seed: unsigned, seed of the random number generators of the run, 0 draws a random seed
+@member replace_worst: bool, whether Steady_State_Optimization replaces the worst circuit of the
+                        population, or the loser of a tournament of tournament_size circuits
+@member hall_of_fame: HallOfFame*, hall of fame shared by concurrent runs with the same prices and
+                        flow rates, the best circuit of every generation is submitted to it,
+                        nullptr disables it
+@member hall_of_fame_injection: int, after every this number of generations without improvement,
+                                the best circuit of the hall of fame is added to the next generation
+                                as an elite if it is better than the best of the run, 0 disables it
+@member checkpoint_path: string, file where the state of the run is saved (see Checkpoint.h), empty
+                            disables checkpoints. If the file holds a checkpoint of a run with the
+                            same number of units, population size, flow rates, price, cost, fractions,
+                            robust options, max_iterations and threshold, the run resumes from it, and
+                            continues exactly as it would have without the interruption (as long as
+                            no hall of fame is injected). A finished run returns its result at once.
+@member checkpoint_interval: double, minimum number of seconds between two checkpoints, a checkpoint is
+                            also written when the run ends
+@member archive: ArchiveWriter*, archive where the best circuit of every generation is stored with
+                    its flows, nullptr disables it
+@member run_id: int, run identifier stored with the archived and logged circuits
+@member archive_population: bool, whether every circuit of every generation is archived (without
+                            its flows), rather than only the best one
+@member generation_log: string, file to which the best circuit of a generation is appended as a line
+                        of JSON, with its flows and performance, whenever it differs from the best
+                        circuit of the previous generation. Written by Output_Writer(), several
+                        runs can share the file. Empty disables the log
+@member initial_circuits: vector<vector<int>>, circuits put in the initial population in place of
+                            random ones (warm start), those that are not valid circuits of num_units
+                            units are skipped, and at most population_size are used
+@member evaluation_database: EvaluationDatabase*, persistent flows of the circuits evaluated by this
+                                and previous runs, each generation is evaluated through it, nullptr
+                                evaluates every circuit
+@member design_index: DesignIndex*, best circuits of past problems. Up to a fraction warm_start of the
+                        initial population (initial_circuits included) is taken from the circuits
+                        of the nearest problems (see Warm_Start_Circuits), and the result of the run
+                        is added to it. nullptr disables it
+@member warm_start: double, fraction of the initial population taken from the design index
+@member time_limit: double, number of seconds after which the run returns the best circuit of its last
+                    generation, checked at the start of every generation, 0 for no limit. A run stopped
+                    by its time limit can be resumed from its checkpoint
+@member fractions: UnitFractions, concentrate fractions of each of the num_units units, uniform by
+                    default. With other fractions the units are not interchangeable, so canonical_labels
+                    is ignored, and the evaluation database and design index (which only know the
+                    uniform fractions) are not used. Throws std::invalid_argument if they are not valid
+@member robust: RobustOptions, with robust.scenarios > 0 every circuit is scored by its expected or
+                worst-case performance (see Robust_Performance) under scenarios sampled around the
+                flow rates and fractions of the run, rather than under these conditions only. The
+                local search, evaluation database, design index and canonical labels, which all
+                assume the nominal conditions, are then not used. The archive and the generation log
+                keep the flows under the nominal conditions, with the robust performance
+@member single_precision: bool, whether every generation (and every child of Steady_State_Optimization)
+                            of a robust run is screened with the scenario kernel in single precision,
+                            and only the circuits that may be the best (see Refinement_Candidates) are
+                            evaluated again in double precision. The best circuit of every generation,
+                            and so the result, always has its double precision performance. Ignored
+                            without scenarios, as the per-circuit solver is no faster in float
+*/
+struct GeneticOptions
+{
+    int local_search_elites{0};
+    int local_search_budget{2000};
+    bool local_search_pair_swap{false};
+    bool canonical_labels{false};
+    SelectionMethod selection{SelectionMethod::Alias};
+    int tournament_size{2};
+    unsigned seed{0};
+    bool replace_worst{true};
+    HallOfFame *hall_of_fame{nullptr};
+    int hall_of_fame_injection{0};
+    std::string checkpoint_path{};
+    double checkpoint_interval{5.0};
+    ArchiveWriter *archive{nullptr};
+    int run_id{0};
+    bool archive_population{false};
+    std::string generation_log{};
+    std::vector<std::vector<int>> initial_circuits{};
+    EvaluationDatabase *evaluation_database{nullptr};
+    DesignIndex *design_index{nullptr};
+    double warm_start{0.25};
+    double time_limit{0.0};
+    UnitFractions fractions{};
+    RobustOptions robust{};
+    bool single_precision{false};
+};
+
+/*
+The numbers that define the problem solved by a call to Genetic_Optimization, stored in
+its checkpoints so that a checkpoint is never resumed by a run of another problem, or
+of the same problem with other limits.
+
+@param max_iterations: int, the max iterations of the run
+@param threshold: int, number of generations without improvement after which the run stops
+@param num_units: int, number of units in a circuit
+@param flow_rate_gormanium: double, kg/s gormanium flowing into the circuit
+@param flow_rate_waste: double, kg/s wasteflowing into the circuit
+@param price_gormanium: double, £/kg of gormanium in the concentrate
+@param cost_waste: double, £/kg of waste in the concentrate
+@param options: GeneticOptions, options of the run, of which the fractions and robust options count
+
+@return problem: vector<double>, see GeneticCheckpoint::problem
+*/
+std::vector<double> Checkpoint_Problem(
+    int max_iterations,
+    int threshold,
+    int num_units,
+    double flow_rate_gormanium,
+    double flow_rate_waste,
+    double price_gormanium,
+    double cost_waste,
+    const GeneticOptions &options
+);
+
 /*
 Solver function of the Genetic Algorithm.
 We get the performance, probability, best performance and best generations from
@@ -314,6 +653,7 @@ the best results for each reproduction.
 @param flow_rate_waste: double, kg/s wasteflowing into the circuit
 @param price_gormanium: double, £/kg of gormanium in the concentrate
 @param cost_waste: double, £/kg of waste in the concentrate
+@param options: GeneticOptions (optional), optional features of the algorithm
 */
 std::vector<int> Genetic_Optimization(
     int population_size,
@@ -324,5 +664,8 @@ std::vector<int> Genetic_Optimization(
     double flow_rate_gormanium = 10.0,
     double flow_rate_waste = 100.0,
     double price_gormanium = 100.0,
-    double cost_waste = 500.0
+    double cost_waste = 500.0,
+    const GeneticOptions &options = GeneticOptions()
 );
+
+#endif // !Genetic_Algorithm
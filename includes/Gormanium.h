@@ -0,0 +1,159 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __GORMANIUM__
+#define __GORMANIUM__
+/*
+C interface of the solver, built as the shared library libgormanium (`make libgormanium`),
+to be used from C or from other languages (Python through ctypes, see python/gormanium.py).
+
+Only plain C types cross the interface and no exception escapes it: every function
+reports errors through its return value. Circuits are arrays of 2 * num_units + 1 int
+genes, and the batch functions take a count of circuits stored one after the other in
+a single caller-owned array (row-major, as a C-contiguous NumPy array of shape
+(count, 2 * num_units + 1) and dtype int32), writing their results to caller-owned
+double and int arrays, so that nothing is copied across the interface.
+
+The functions can be called from several threads at once. The batch functions use
+all the OpenMP threads.
+*/
+
+#ifdef _WIN32
+#ifdef GORMANIUM_BUILD
+#define GORMANIUM_API __declspec(dllexport)
+#else
+#define GORMANIUM_API __declspec(dllimport)
+#endif
+#else
+#define GORMANIUM_API __attribute__((visibility("default")))
+#endif
+
+/* version of the interface, changed whenever a signature changes */
+#define GORMANIUM_ABI_VERSION 1
+
+/* return codes besides the validity codes of utils::Check_Validity */
+#define GORMANIUM_OK 0
+#define GORMANIUM_MALFORMED -1
+#define GORMANIUM_NOT_CONVERGED 3
+#define GORMANIUM_MASS_BALANCE 4
+#define GORMANIUM_BAD_ARGUMENT -2
+#define GORMANIUM_FAILED -3
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /*
+    @return version: int, GORMANIUM_ABI_VERSION of the library, to check against the header
+    */
+    GORMANIUM_API int gormanium_abi_version(void);
+
+    /*
+    Validity of a circuit, see utils::Check_Validity.
+
+    @param circuit: const int *, the 2 * num_units + 1 genes
+    @param num_units: int, number of units
+
+    @return code: int, 0 if valid, the code of utils::Check_Validity, or GORMANIUM_MALFORMED
+                    if a gene is out of range
+    */
+    GORMANIUM_API int gormanium_check_validity(const int *circuit, int num_units);
+
+    /*
+    Flows of a circuit, see Evaluate_Flows. The circuit must be valid.
+
+    @param circuit: const int *, the 2 * num_units + 1 genes
+    @param num_units: int, number of units
+    @param tolerance: double, relative change of the flows at convergence
+    @param max_iterations: int, iterations before giving up
+    @param feed_gormanium, feed_waste: double, flows fed to the circuit [kg/s]
+    @param gormanium, waste: double *, arrays of num_units + 2 flows, set to the flows
+                    into each unit, then into the concentrate and into the tailings
+
+    @return code: int, GORMANIUM_OK, GORMANIUM_NOT_CONVERGED, GORMANIUM_MASS_BALANCE,
+                    GORMANIUM_MALFORMED or GORMANIUM_BAD_ARGUMENT
+    */
+    GORMANIUM_API int gormanium_evaluate_flows(const int *circuit, int num_units, double tolerance, int max_iterations,
+                                               double feed_gormanium, double feed_waste,
+                                               double *gormanium, double *waste);
+
+    /*
+    Performance of a circuit, see Evaluate_Circuit. The circuit must be valid.
+
+    @param circuit: const int *, the 2 * num_units + 1 genes
+    @param num_units: int, number of units
+    @param tolerance: double, relative change of the flows at convergence
+    @param max_iterations: int, iterations before giving up
+    @param price_gormanium, cost_waste: double, prices [GBP/kg]
+    @param feed_gormanium, feed_waste: double, flows fed to the circuit [kg/s]
+
+    @return performance: double, the performance [GBP/s], NaN if the genes are out of range
+    */
+    GORMANIUM_API double gormanium_evaluate_circuit(const int *circuit, int num_units, double tolerance,
+                                                    int max_iterations, double price_gormanium, double cost_waste,
+                                                    double feed_gormanium, double feed_waste);
+
+    /*
+    Validate and evaluate a batch of circuits of the same size in parallel, like
+    Bulk_Evaluate: invalid circuits are not evaluated and get NaN results, circuits
+    whose flows do not converge are scored like Evaluate_Circuit does.
+
+    @param circuits: const int *, count * (2 * num_units + 1) genes
+    @param count: int, number of circuits
+    @param num_units: int, number of units of every circuit
+    @param tolerance: double, relative change of the flows at convergence
+    @param max_iterations: int, iterations before giving up
+    @param price_gormanium, cost_waste: double, prices [GBP/kg]
+    @param feed_gormanium, feed_waste: double, flows fed to the circuits [kg/s]
+    @param validity: int *, count codes (0 if valid, see gormanium_check_validity), or NULL
+    @param performance: double *, count performances, or NULL
+    @param concentrate_gormanium, concentrate_waste: double *, count flows into the
+                    concentrate [kg/s], or NULL
+
+    @return number of valid circuits, or GORMANIUM_BAD_ARGUMENT
+    */
+    GORMANIUM_API int gormanium_evaluate_batch(const int *circuits, int count, int num_units, double tolerance,
+                                               int max_iterations, double price_gormanium, double cost_waste,
+                                               double feed_gormanium, double feed_waste, int *validity,
+                                               double *performance, double *concentrate_gormanium,
+                                               double *concentrate_waste);
+
+    /*
+    Best circuit found by Genetic_Optimization, with the default options and adaptive rates.
+
+    @param population_size, max_iterations, threshold: int, see Genetic_Optimization
+    @param num_units: int, number of units
+    @param feed_gormanium, feed_waste: double, flows fed to the circuit [kg/s]
+    @param price_gormanium, cost_waste: double, prices [GBP/kg]
+    @param seed: unsigned, seed of the random numbers, 0 for a random seed
+    @param best_circuit: int *, array of 2 * num_units + 1 genes set to the best circuit
+    @param performance: double *, set to its performance, or NULL
+
+    @return code: int, GORMANIUM_OK, GORMANIUM_BAD_ARGUMENT or GORMANIUM_FAILED
+    */
+    GORMANIUM_API int gormanium_genetic_optimization(int population_size, int max_iterations, int threshold,
+                                                     int num_units, double feed_gormanium, double feed_waste,
+                                                     double price_gormanium, double cost_waste, unsigned seed,
+                                                     int *best_circuit, double *performance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !__GORMANIUM__ */
@@ -0,0 +1,94 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __HALL_OF_FAME__
+#define __HALL_OF_FAME__
+
+// system includes
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/*
+The best distinct circuits found by all the runs of the solver, shared between
+threads.
+
+Almost every candidate submitted is worse than the worst circuit already in the
+hall of fame, so Submit rejects those with a single atomic load and no lock. Only
+candidates that would enter the hall of fame take the lock, which is rare once the
+runs have found good circuits. The best performance and a version counter, bumped
+on every change, can also be read without the lock, so that runs can cheaply check
+whether there is anything new before copying the best circuit.
+
+@param capacity: int, number of circuits kept
+*/
+class HallOfFame
+{
+public:
+    HallOfFame(int capacity);
+
+    ~HallOfFame() = default;
+
+    /*
+    Offer a circuit to the hall of fame.
+
+    @param circuit: std::vector<int>, the circuit
+    @param performance: double, its performance
+
+    @return entered: bool, whether the circuit was added (false if it is not better than
+                    the worst circuit kept, or is already in the hall of fame)
+    */
+    bool Submit(const std::vector<int> &circuit, double performance);
+
+    /*
+    Copy the best circuit.
+
+    @param circuit: std::vector<int>, vector to store the best circuit, left unchanged if
+                    the hall of fame is empty
+
+    @return performance: double, performance of the best circuit, Empty() if there is none
+    */
+    double Best(std::vector<int> &circuit) const;
+
+    // performance of the best circuit, without locking
+    double Best_Performance() const { return best_.load(std::memory_order_acquire); }
+
+    // number of changes so far, without locking
+    unsigned long Version() const { return version_.load(std::memory_order_acquire); }
+
+    // the circuits and their performances, best first
+    std::vector<std::pair<double, std::vector<int>>> Entries() const;
+
+    int capacity() const { return capacity_; }
+
+    // performance reported while the hall of fame is empty
+    static double Empty();
+
+private:
+    int capacity_;
+    // entries sorted best first, only accessed while holding lock_
+    std::vector<std::pair<double, std::vector<int>>> entries_{};
+    mutable std::mutex lock_;
+    // performance a candidate must beat to enter, the worst entry once full
+    std::atomic<double> threshold_;
+    std::atomic<double> best_;
+    std::atomic<unsigned long> version_{0};
+};
+
+#endif // !__HALL_OF_FAME__
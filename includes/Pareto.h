@@ -0,0 +1,122 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __PARETO__
+#define __PARETO__
+/*
+Multi-objective (NSGA-II style) mode of the Genetic Algorithm.
+References:
+K. Deb, A. Pratap, S. Agarwal and T. Meyarivan, "A fast and elitist multiobjective
+genetic algorithm: NSGA-II," IEEE Transactions on Evolutionary Computation, vol. 6,
+no. 2, pp. 182-197, 2002, doi: 10.1109/4235.996017.
+*/
+
+// local includes
+#include "Genetic_Algorithm.h"
+
+// system includes
+#include <random>
+#include <vector>
+
+/*
+Check whether circuit a dominates circuit b, i.e. it sends at least as much
+gormanium and at most as much waste to the concentrate, and is strictly
+better in one of the two.
+
+@param gormanium_a: double, gormanium flow into the concentrate of circuit a [kg/s]
+@param waste_a: double, waste flow into the concentrate of circuit a [kg/s]
+@param gormanium_b: double, gormanium flow into the concentrate of circuit b [kg/s]
+@param waste_b: double, waste flow into the concentrate of circuit b [kg/s]
+
+@return dominates: bool, true if a dominates b
+*/
+bool Dominates(double gormanium_a, double waste_a, double gormanium_b, double waste_b);
+
+/*
+Fast non-dominated sorting of a population.
+
+The population is split into successive fronts, front 0 being the circuits that
+no other circuit dominates, front 1 those only dominated by circuits of front 0, etc.
+
+@param flows: PopulationFlows, concentrate flows of the population
+@param rank: std::vector<int>, vector to store the front index of each circuit
+@param fronts: std::vector<std::vector<int>>, vector to store the indices of the circuits in each front
+*/
+void Non_Dominated_Sort(const PopulationFlows &flows, std::vector<int> &rank, std::vector<std::vector<int>> &fronts);
+
+/*
+Crowding distance of the circuits in a single front, i.e. the size of the cuboid
+enclosing each circuit in objective space formed by its nearest neighbours.
+The two extreme circuits of the front get an infinite distance.
+
+@param flows: PopulationFlows, concentrate flows of the population
+@param front: std::vector<int>, indices of the circuits in the front
+@param distance: std::vector<double>, crowding distance of each circuit of the population,
+                    must be of population size, only the entries of the front are written
+*/
+void Crowding_Distance(const PopulationFlows &flows, const std::vector<int> &front, std::vector<double> &distance);
+
+/*
+Binary tournament using the crowded comparison operator: the circuit of lower rank
+wins, and between circuits of equal rank the one in the less crowded region wins.
+
+@param rank: std::vector<int>, front index of each circuit
+@param distance: std::vector<double>, crowding distance of each circuit
+@param rng: std::mt19937, random number generator of the run
+
+@return index: int, index of the chosen circuit
+*/
+int Crowded_Tournament(const std::vector<int> &rank, const std::vector<double> &distance, std::mt19937 &rng);
+
+/*
+Solver function of the multi-objective Genetic Algorithm.
+
+Instead of a single performance for fixed prices, the algorithm maximises the
+gormanium and minimises the waste reaching the concentrate at the same time.
+Parents and children are merged every generation and the next generation is
+filled front by front, breaking ties on the last front by crowding distance.
+
+The optimum circuit for any positive price of gormanium and cost of waste is on
+the returned front, so it can be extracted with Reprice_Population without
+running the optimisation again.
+
+@param population_size: int, the size of each generation
+@param max_iterations: int, the number of generations
+@param adaptive_rate: vector<double>, adaptive rates of the single objective algorithm,
+                        only the below-average crossover (k3) and mutation (k4) rates are used
+@param front_flows: PopulationFlows, structure to store the concentrate flows of the front
+@param num_units: int (optional), number of units in a circuit, default to 10
+@param flow_rate_gormanium: double (optional), kg/s gormanium flowing into the circuit, default to 10
+@param flow_rate_waste: double (optional), kg/s waste flowing into the circuit, default to 100
+@param seed: unsigned (optional), seed of the random number generator of the run, 0 (the default)
+                draws a random seed
+
+@return front: vector<vector<int>>, circuits of the Pareto front, by increasing gormanium recovery
+*/
+std::vector<std::vector<int>> Pareto_Optimization(
+    int population_size,
+    int max_iterations,
+    std::vector<double> &adaptive_rate,
+    PopulationFlows &front_flows,
+    int num_units = 10,
+    double flow_rate_gormanium = 10.0,
+    double flow_rate_waste = 100.0,
+    unsigned seed = 0
+);
+
+#endif // !__PARETO__
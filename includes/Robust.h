@@ -0,0 +1,216 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __ROBUST__
+#define __ROBUST__
+
+// local includes
+#include "Unit_Fractions.h"
+
+// system includes
+#include <vector>
+
+/*
+How the performances of a circuit under the different scenarios are combined.
+
+Expected: the mean performance over the scenarios
+Worst_Case: the lowest performance of any scenario
+*/
+enum class RobustObjective
+{
+    Expected,
+    Worst_Case
+};
+
+/*
+Operating conditions of a circuit, sampled around the nominal feed rates and
+concentrate fractions, under which the circuits are scored by Robust_Performance.
+
+The values are stored scenario-fastest so that the flow solver updates the same
+unit in all the scenarios with one vectorised loop.
+
+@member num_units: int, number of units of the circuits
+@member count: int, number of scenarios
+@member feed_gormanium: vector<double>, kg/s gormanium fed into the circuit, one per scenario
+@member feed_waste: vector<double>, kg/s waste fed into the circuit, one per scenario
+@member fraction_gormanium: vector<double>, fraction of the gormanium fed to unit i that goes to
+                            its concentrate in scenario k, at index i * count + k
+@member fraction_waste: vector<double>, same for the waste
+*/
+struct ScenarioSet
+{
+    int num_units{0};
+    int count{0};
+    std::vector<double> feed_gormanium{};
+    std::vector<double> feed_waste{};
+    std::vector<double> fraction_gormanium{};
+    std::vector<double> fraction_waste{};
+
+    // concentrate fractions of the units in scenario k, for Evaluate_Flows
+    UnitFractions fractions_of(int k) const;
+};
+
+/*
+Parameters of the robust evaluation of GeneticOptions.
+
+@member scenarios: int, number of sampled scenarios, 0 scores the circuits under the nominal
+                    conditions only
+@member objective: RobustObjective, expected or worst-case performance
+@member feed_spread: double, standard deviation of the logarithm of the feed rates
+@member fraction_spread: double, standard deviation of the logit of the concentrate fractions
+@member seed: unsigned, seed of the scenarios. Every run with the same seed and problem scores
+                its circuits under the same scenarios, so that their performances compare
+*/
+struct RobustOptions
+{
+    int scenarios{0};
+    RobustObjective objective{RobustObjective::Expected};
+    double feed_spread{0.1};
+    double fraction_spread{0.1};
+    unsigned seed{1};
+};
+
+/*
+Sample scenarios around nominal operating conditions. The feed rates of gormanium and waste are
+drawn independently from log-normal distributions with the nominal rates as medians, and every
+concentrate fraction of every unit from a logit-normal distribution centred on the nominal
+fraction, which keeps it between 0 and 1.
+
+@param num_units: int, number of units of the circuits
+@param count: int, number of scenarios
+@param flow_rate_gormanium: double, nominal kg/s gormanium flowing into the circuit
+@param flow_rate_waste: double, nominal kg/s waste flowing into the circuit
+@param fractions: UnitFractions, nominal concentrate fractions of each unit
+@param feed_spread: double, standard deviation of the logarithm of the feed rates
+@param fraction_spread: double, standard deviation of the logit of the fractions
+@param seed: unsigned, seed of the random numbers
+
+@return scenarios: ScenarioSet, the sampled scenarios
+*/
+ScenarioSet Sample_Scenarios(
+    int num_units,
+    int count,
+    double flow_rate_gormanium,
+    double flow_rate_waste,
+    const UnitFractions &fractions,
+    double feed_spread,
+    double fraction_spread,
+    unsigned seed
+);
+
+/*
+Sample the scenarios of the robust evaluation of a problem, see GeneticOptions::robust.
+
+@param num_units: int, number of units of the circuits
+@param flow_rate_gormanium: double, nominal kg/s gormanium flowing into the circuit
+@param flow_rate_waste: double, nominal kg/s waste flowing into the circuit
+@param fractions: UnitFractions, nominal concentrate fractions of each unit
+@param options: RobustOptions, number, spreads and seed of the scenarios
+
+@return scenarios: ScenarioSet, the sampled scenarios
+*/
+ScenarioSet Sample_Scenarios(
+    int num_units,
+    double flow_rate_gormanium,
+    double flow_rate_waste,
+    const UnitFractions &fractions,
+    const RobustOptions &options
+);
+
+/*
+Converged concentrate flows of one circuit under every scenario of a set. All the scenarios
+are solved together by the successive substitution of Evaluate_Flows: the connectivity of the
+circuit is read once per unit and iteration, and the flows of that unit in all the scenarios
+are updated with one vectorised loop. A scenario keeps the flows of the iteration at which it
+converged, so the flows are the same as those of separate calls to Evaluate_Flows.
+
+A scenario that does not converge within max_iterations is stored as if all the waste fed into
+the circuit went to the concentrate, the penalty of Evaluate_Circuit.
+
+@param circuit_vector: std::vector<int>, gene of a circuit of scenarios.num_units units
+@param scenarios: ScenarioSet, the operating conditions
+@param conc_gormanium: std::vector<double>, kg/s gormanium in the concentrate per scenario, resized
+@param conc_waste: std::vector<double>, kg/s waste in the concentrate per scenario, resized
+@param converged: std::vector<char>, whether each scenario converged, resized
+@param tolerance: double (optional), maximum relative error allowed for convergence, default to 1e-4
+@param max_iterations: int (optional), maximum number of iterations, default to 1000
+@param single_precision: bool (optional), whether to solve the flows in float, twice as many
+                        scenarios per SIMD register, to screen circuits. The mass continuity check is
+                        still summed in double, and a scenario that does not converge after coming
+                        within the rounding of float of the tolerance is solved again in double, as
+                        it may converge there. The converged flags are then those of double precision,
+                        except for a scenario that converges in float only, default to false
+
+Throws 2 if the mass balance of a scenario fails, like Evaluate_Flows, and std::invalid_argument
+if the circuit does not have scenarios.num_units units
+*/
+void Evaluate_Scenario_Flows(
+    const std::vector<int> &circuit_vector,
+    const ScenarioSet &scenarios,
+    std::vector<double> &conc_gormanium,
+    std::vector<double> &conc_waste,
+    std::vector<char> &converged,
+    double tolerance = 1e-4,
+    int max_iterations = 1000,
+    bool single_precision = false
+);
+
+/*
+Robust performance of a circuit: its performance under each scenario (see Evaluate_Circuit),
+combined by the objective.
+
+@param circuit_vector: std::vector<int>, gene of a valid circuit of scenarios.num_units units
+@param scenarios: ScenarioSet, the operating conditions
+@param price_gormanium: double, £/kg of gormanium in the concentrate
+@param cost_waste: double, £/kg of waste in the concentrate
+@param objective: RobustObjective, expected or worst-case performance
+@param single_precision: bool (optional), whether to screen in float, see Evaluate_Scenario_Flows
+
+@return performance: double, the robust performance
+*/
+double Robust_Performance(
+    const std::vector<int> &circuit_vector,
+    const ScenarioSet &scenarios,
+    double price_gormanium,
+    double cost_waste,
+    RobustObjective objective,
+    bool single_precision = false
+);
+
+/*
+Robust performance of a population of valid circuits, evaluated in parallel.
+
+@param population: std::vector<std::vector<int>>, the circuits
+@param scenarios: ScenarioSet, the operating conditions
+@param price_gormanium: double, £/kg of gormanium in the concentrate
+@param cost_waste: double, £/kg of waste in the concentrate
+@param objective: RobustObjective, expected or worst-case performance
+@param performance: std::vector<double>, robust performance of each circuit, resized
+@param single_precision: bool (optional), whether to screen in float, see Evaluate_Scenario_Flows
+*/
+void Robust_Population_Performance(
+    const std::vector<std::vector<int>> &population,
+    const ScenarioSet &scenarios,
+    double price_gormanium,
+    double cost_waste,
+    RobustObjective objective,
+    std::vector<double> &performance,
+    bool single_precision = false
+);
+
+#endif // !__ROBUST__
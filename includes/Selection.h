@@ -0,0 +1,185 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __SELECTION__
+#define __SELECTION__
+/*
+Parent selection schemes of the Genetic Algorithm.
+References:
+M. D. Vose, "A linear algorithm for generating random numbers with a given distribution,"
+IEEE Transactions on Software Engineering, vol. 17, no. 9, pp. 972-975, 1991,
+doi: 10.1109/32.92917.
+J. E. Baker, "Reducing bias and inefficiency in the selection algorithm," Proceedings of
+the Second International Conference on Genetic Algorithms, 1987, pp. 14-21.
+*/
+
+// system includes
+#include <random>
+#include <vector>
+
+/*
+The different ways of choosing parents from a generation.
+
+Roulette: the original cumulative probability and binary search of Choose_Cross
+Alias: roulette wheel sampled exactly in O(1) per draw with a Walker alias table
+Stochastic_Universal: all the parents of a generation drawn in one pass with evenly
+                        spaced pointers, which minimises the spread of the number of
+                        copies of each circuit
+Tournament: the fittest of a few circuits drawn uniformly
+*/
+enum class SelectionMethod
+{
+    Roulette,
+    Alias,
+    Stochastic_Universal,
+    Tournament
+};
+
+/*
+This function creates a probability vector for a generation.
+
+We first calculate the sum of performance of every circuit. Then use
+the roulette method: probability of each circuit is calculated as a ratio of
+individual performance to the sum performance.
+
+@param population_size: int, the size of population
+@param performance: vector<double>, performances of every circuit in the current generation
+@param probability: vector<double>, vector to record the probabilities of all circuits
+                    in this generation
+*/
+void Probability(int population_size, const std::vector<double> &fitness, std::vector<double> &probability);
+
+/*
+This function randomly selects a pair of parents for crossover.
+
+We look into the probability vector. Select a random
+number first. Then use the binary search method to
+get the position of that number.
+
+@param probability: vector<double>, chosen probabilities of each gene
+                    in the current population
+
+@return mid: int, index of the chosen gene
+*/
+int Choose_Cross(const std::vector<double> &probability);
+
+/*
+Select a parent as Choose_Cross, drawing the random number from rng.
+
+@param probability: vector<double>, chosen probabilities of each gene
+                    in the current population
+@param rng: std::mt19937, random number generator
+
+@return mid: int, index of the chosen gene
+*/
+int Choose_Cross(const std::vector<double> &probability, std::mt19937 &rng);
+
+/*
+Select the parent of Choose_Cross for a given random number.
+
+@param probability: vector<double>, chosen probabilities of each gene
+                    in the current population
+@param num: double, random number in (0, 1]
+
+@return mid: int, index of the chosen gene
+*/
+int Choose_Cross(const std::vector<double> &probability, double num);
+
+/*
+Walker alias table, to draw indices with probabilities proportional to a vector of
+non-negative weights in constant time. Building the table is O(n).
+
+@param weights: std::vector<double>, weight of each index, negative weights are treated as 0.
+                If all the weights are 0 the indices are drawn uniformly.
+*/
+class AliasTable
+{
+public:
+    AliasTable(const std::vector<double> &weights);
+
+    ~AliasTable() = default;
+
+    // draw an index
+    int Sample(std::mt19937 &rng) const;
+
+    int size() const { return probability_.size(); }
+
+private:
+    // probability of keeping the index of the chosen column
+    std::vector<double> probability_{};
+    // index to return instead of the column otherwise
+    std::vector<int> alias_{};
+};
+
+/*
+Stochastic universal sampling: select `count` indices with probabilities proportional to
+the fitness, using a single random number and `count` evenly spaced pointers on the
+cumulative fitness. The selected indices are shuffled so that consecutive ones can be
+used as pairs of parents.
+
+@param fitness: std::vector<double>, fitness of each circuit, negative values are treated as 0
+@param count: int, number of indices to select
+@param selected: std::vector<int>, vector to store the selected indices
+@param rng: std::mt19937, random number generator
+*/
+void Stochastic_Universal_Sampling(const std::vector<double> &fitness, int count, std::vector<int> &selected, std::mt19937 &rng);
+
+/*
+Tournament selection: draw `size` circuits uniformly (with replacement) and return the fittest.
+
+@param fitness: std::vector<double>, fitness of each circuit
+@param size: int, number of circuits taking part in the tournament
+@param rng: std::mt19937, random number generator
+
+@return index: int, index of the winner
+*/
+int Tournament_Selection(const std::vector<double> &fitness, int size, std::mt19937 &rng);
+
+/*
+Draws the parents of one generation with the chosen selection method. Whatever
+preparation the method needs (probability vector, alias table, sampling pass) is
+done once at construction.
+
+@param fitness: std::vector<double>, fitness of each circuit of the generation,
+                must outlive the selector
+@param method: SelectionMethod, how to select the parents
+@param tournament_size: int (optional), number of circuits in each tournament, default to 2
+*/
+class ParentSelector
+{
+public:
+    ParentSelector(const std::vector<double> &fitness, SelectionMethod method, int tournament_size = 2);
+
+    ~ParentSelector() = default;
+
+    // draw the index of a parent
+    int Next(std::mt19937 &rng);
+
+private:
+    const std::vector<double> &fitness_;
+    SelectionMethod method_;
+    int tournament_size_;
+    // roulette
+    std::vector<double> probability_{};
+    // alias
+    AliasTable table_;
+    // stochastic universal sampling, consumed from the back
+    std::vector<int> sampled_{};
+};
+
+#endif // !__SELECTION__
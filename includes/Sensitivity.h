@@ -0,0 +1,107 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __SENSITIVITY__
+#define __SENSITIVITY__
+
+// local includes
+#include "Unit_Fractions.h"
+
+// system includes
+#include <vector>
+
+/*
+Gradient of the performance of a circuit with respect to its operating parameters.
+
+@member performance: double, performance of the circuit, as Evaluate_Circuit
+@member conc_gormanium: double, kg/s gormanium in the concentrate
+@member conc_waste: double, kg/s waste in the concentrate
+@member price_gormanium: double, d performance / d price of gormanium (= conc_gormanium)
+@member cost_waste: double, d performance / d cost of waste (= -conc_waste)
+@member feed_gormanium: double, d performance / d kg/s gormanium fed into the circuit
+@member feed_waste: double, d performance / d kg/s waste fed into the circuit
+@member fraction_gormanium: vector<double>, d performance / d concentrate fraction of gormanium of each unit
+@member fraction_waste: vector<double>, d performance / d concentrate fraction of waste of each unit
+@member recovery_gormanium: vector<double>, fraction of the gormanium fed into each unit that ends
+                            in the final concentrate (the adjoint of the gormanium flows)
+@member recovery_waste: vector<double>, same for the waste
+*/
+struct PerformanceSensitivity
+{
+    double performance{0.0};
+    double conc_gormanium{0.0};
+    double conc_waste{0.0};
+    double price_gormanium{0.0};
+    double cost_waste{0.0};
+    double feed_gormanium{0.0};
+    double feed_waste{0.0};
+    std::vector<double> fraction_gormanium{};
+    std::vector<double> fraction_waste{};
+    std::vector<double> recovery_gormanium{};
+    std::vector<double> recovery_waste{};
+};
+
+/*
+Performance of a circuit and its gradient with respect to the concentrate fractions of every
+unit, the two feed rates, the price of gormanium and the cost of waste, for about the cost of
+two evaluations whatever the number of units.
+
+The steady-state flows x into the units solve x = A x + b, and the concentrate is a linear
+function c.x of them. Rather than solving the flows again for every perturbed parameter, one
+transposed (adjoint) solve gives the recovery r of every unit, the fraction of what is fed into
+it that reaches the final concentrate:
+
+    r[i] = f[i] r[concentrate of i] + (1 - f[i]) r[tailings of i],  r[concentrate] = 1, r[tailings] = 0
+
+iterated by successive substitution like the flows. The derivative of the concentrate with
+respect to the fraction f[i] is then x[i] (r[concentrate of i] - r[tailings of i]), and with
+respect to the feed rate the recovery of the entry unit. The flows are those of Evaluate_Flows,
+so the gradient is accurate to about the tolerance.
+
+@param circuit_vector: std::vector<int>, gene of a valid circuit
+@param sensitivity: PerformanceSensitivity, the performance and its gradient, overwritten
+@param tolerance: double (optional), maximum relative error allowed for convergence of both
+                    solves, default to 1e-4
+@param max_iterations: int (optional), maximum number of iterations of each solve, default to 1000
+@param gormanium_price: double (optional), price of gormanium in the concentrate [GBP/kg],
+                        default to £100/kg
+@param waste_cost: double (optional), cost of waste disposal in the concentrate [GBP/kg],
+                        default to £500/kg
+@param input_gormanium: double (optional), mass flow rate of gormanium fed into circuit [kg/s],
+                        default to 10kg/s
+@param input_waste: double (optional), mass flow rate of waste fed into circuit [kg/s],
+                        default to 100kg/s
+@param fractions: UnitFractions (optional), concentrate fractions of each unit, see Evaluate_Flows
+
+Throws the error codes of Evaluate_Flows: 1 if either solve does not converge (the gradient of
+the penalty would be meaningless), 2 if the mass balance fails, and std::invalid_argument if the
+fractions are not valid for the circuit
+*/
+void Performance_Sensitivity(
+    const std::vector<int> &circuit_vector,
+    PerformanceSensitivity &sensitivity,
+    double tolerance = 1e-4,
+    int max_iterations = 1000,
+    double gormanium_price = 100.0,
+    double waste_cost = 500.0,
+    double input_gormanium = 10.0,
+    double input_waste = 100.0,
+    const UnitFractions &fractions = UnitFractions()
+);
+
+#endif // !__SENSITIVITY__
@@ -0,0 +1,157 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __SERVER__
+#define __SERVER__
+
+// local includes
+#include "Config.h"
+
+// system includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+Counters of a CircuitServer.
+
+@member requests: std::uint64_t, number of requests answered
+@member evaluations: std::uint64_t, number of circuits evaluated
+@member batches: std::uint64_t, number of batches the evaluations were grouped in
+*/
+struct ServerStats
+{
+    std::uint64_t requests{0};
+    std::uint64_t evaluations{0};
+    std::uint64_t batches{0};
+};
+
+/*
+Long-running server answering requests over a local (Unix domain) socket, so that
+the tools calling the solver many times pay for the process start-up, the opening
+of the evaluation database and design index and the creation of the threads once.
+
+The protocol is JSON lines: each request is a JSON object on one line, answered by
+one line, in order, on the same connection. Every request may carry an "id", copied
+to its answer, and has a "type":
+
+    {"type": "evaluate", "circuits": [[0, 1, 2, ...], ...]}
+        -> {"performance": [...], "concentrate_gormanium": [...], "concentrate_waste": [...]}
+    {"type": "validate", "circuits": [[...], ...]}
+        -> {"valid": [...]}, the codes of utils::Check_Validity, -1 for a malformed gene
+    {"type": "optimise", "num_units": 10, "seconds": 2.0}
+        -> {"circuit": [...], "performance": ...}, one run of Genetic_Optimization
+            stopped after the given time (GeneticOptions::time_limit)
+
+The feed ("flow_rate_gormanium", "flow_rate_waste") and prices ("price_gormanium",
+"cost_waste") default to the first values of the configuration, and "optimise" also
+accepts "population_size" (at least 2), "max_iterations", "threshold" (positive) and
+"seed", all integers. A request that cannot be answered gets {"error": "..."}, as does a
+line longer than 64 MiB or nested more than 32 levels deep.
+
+The circuits of the evaluation requests of all the connections are queued and
+evaluated together, by a single thread, as batches of Evaluate_Population_Flows
+(through the evaluation database of the configuration, for its number of units).
+
+Only available where Unix domain sockets are (Linux, macOS).
+
+@param socket_path: std::string, path of the socket, replaced if it exists
+@param config: SolverConfig, default problem, parameters of the optimisations, and
+                paths of the evaluation database and design index
+*/
+class CircuitServer
+{
+public:
+    CircuitServer(const std::string &socket_path, const SolverConfig &config);
+
+    // stops the server and waits for its threads
+    ~CircuitServer();
+
+    CircuitServer(const CircuitServer &) = delete;
+    CircuitServer &operator=(const CircuitServer &) = delete;
+
+    /*
+    Accept connections until Stop is called, serving each one in its own thread.
+
+    @throw std::runtime_error if the socket cannot be created
+    */
+    void Run();
+
+    // make Run return, can be called from a signal handler
+    void Stop() { stop_.store(true); }
+
+    /*
+    Answer one request line, without the end of line. Used by the connections, and
+    can be called directly from several threads at once.
+
+    @param request: std::string, the JSON request
+
+    @return answer: std::string, the JSON answer
+    */
+    std::string Handle(const std::string &request);
+
+    ServerStats Stats() const;
+
+private:
+    // evaluation requests waiting for the batching thread
+    struct PendingEvaluation
+    {
+        const std::vector<std::vector<int>> *circuits;
+        double flow_rate_gormanium;
+        double flow_rate_waste;
+        std::vector<double> conc_gormanium{};
+        std::vector<double> conc_waste{};
+        bool done{false};
+        std::string error{};
+    };
+
+    void Evaluate(PendingEvaluation &pending);
+    void Evaluation_Loop();
+    void Serve_Connection(int client);
+
+    std::string socket_path_;
+    SolverConfig config_;
+    std::unique_ptr<EvaluationDatabase> database_;
+    std::unique_ptr<DesignIndex> design_index_;
+
+    std::atomic<bool> stop_{false};
+    std::atomic<std::uint64_t> requests_{0};
+    std::atomic<std::uint64_t> evaluations_{0};
+    std::atomic<std::uint64_t> batches_{0};
+
+    std::mutex queue_lock_;
+    std::condition_variable queue_ready_;
+    std::condition_variable evaluated_;
+    std::deque<PendingEvaluation *> queue_{};
+    bool closing_{false};
+    std::thread evaluator_;
+
+    std::mutex clients_lock_;
+    std::map<int, std::thread> clients_{};
+    // connections closed by their client, joined by Run
+    std::vector<int> finished_{};
+};
+
+#endif // !__SERVER__
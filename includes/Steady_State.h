@@ -0,0 +1,72 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __STEADY_STATE__
+#define __STEADY_STATE__
+
+// local includes
+#include "Genetic_Algorithm.h"
+
+// system includes
+#include <vector>
+
+/*
+Steady-state (asynchronous) solver function of the Genetic Algorithm.
+
+There are no generations: every worker thread repeatedly picks two parents from
+the shared population by tournament, breeds and evaluates their children, and
+inserts each valid child straight away in place of the worst circuit of the
+population (or of the loser of a tournament, see GeneticOptions::replace_worst)
+if the child is fitter and not already in the population. The population lock is
+only held to copy the parents and to insert the children, so the threads never
+wait for the slowest evaluation of a generation.
+
+As there is no evaluation of the children before mutation, the adaptive mutation
+rate uses the fitness of the better parent in place of the fitness of the child.
+
+@param population_size: int, the size of the population
+@param max_evaluations: int, the maximum number of children evaluated
+@param threshold: int, the algorithm terminates if the best performance has not
+                    improved for this number of evaluations
+@param adaptive_rate: vector<double>, adaptive crossover and mutation rates
+@param num_units: int (optional), number of units in a circuit, default to 10
+@param flow_rate_gormanium: double (optional), kg/s gormanium flowing into the circuit
+@param flow_rate_waste: double (optional), kg/s waste flowing into the circuit
+@param price_gormanium: double (optional), £/kg of gormanium in the concentrate
+@param cost_waste: double (optional), £/kg of waste in the concentrate
+@param options: GeneticOptions (optional), the tournament size, replacement policy,
+                canonical labelling, seed, unit fractions, robust evaluation and single
+                precision screening are used, and the evaluation database for the initial
+                population
+
+@return best_circuit: vector<int>, the best circuit found
+*/
+std::vector<int> Steady_State_Optimization(
+    int population_size,
+    int max_evaluations,
+    int threshold,
+    std::vector<double> &adaptive_rate,
+    int num_units = 10,
+    double flow_rate_gormanium = 10.0,
+    double flow_rate_waste = 100.0,
+    double price_gormanium = 100.0,
+    double cost_waste = 500.0,
+    const GeneticOptions &options = GeneticOptions()
+);
+
+#endif // !__STEADY_STATE__
@@ -0,0 +1,104 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __SWEEP__
+#define __SWEEP__
+
+// local includes
+#include "Config.h"
+
+// system includes
+#include <string>
+#include <vector>
+
+/*
+One problem of a parameter sweep.
+*/
+struct SweepPoint
+{
+    int num_units{10};
+    double flow_rate_gormanium{10.0};
+    double flow_rate_waste{100.0};
+    double price_gormanium{100.0};
+    double cost_waste{500.0};
+};
+
+/*
+Solution of one problem of a parameter sweep.
+
+@member point: SweepPoint, the problem
+@member circuit: std::vector<int>, best circuit found
+@member performance: double, its performance
+@member recovery: double, fraction of the gormanium fed that ends in the concentrate
+@member grade: double, fraction of gormanium in the concentrate
+@member warm_started: int, number of circuits of the initial populations taken from neighbouring points
+@member best_circuits: std::vector<std::vector<int>>, best distinct circuits found, best first
+*/
+struct SweepResult
+{
+    SweepPoint point{};
+    std::vector<int> circuit{};
+    double performance{0.0};
+    double recovery{0.0};
+    double grade{0.0};
+    int warm_started{0};
+    std::vector<std::vector<int>> best_circuits{};
+};
+
+/*
+The grid of a sweep: every combination of the values of num_units, flow_rate_gormanium,
+flow_rate_waste, price_gormanium and cost_waste of the configuration, the last one
+varying fastest.
+
+@param config: SolverConfig, the configuration
+
+@return grid: std::vector<SweepPoint>, the points of the grid
+*/
+std::vector<SweepPoint> Sweep_Grid(const SolverConfig &config);
+
+/*
+Solve every point of the grid of the configuration with config.runs runs of
+Genetic_Optimization each.
+
+The points are solved in waves: a point of grid indices (i1, ..., i5) belongs to wave
+i1 + ... + i5, so all the points whose indices are one less in one direction are solved
+in the previous wave. The points of a wave, and the runs of each point, are tasks of
+one OpenMP team (utils::Parallel_For), and the runs of a point share a HallOfFame. A
+fraction config.options.warm_start of the initial population of every run is taken from the
+best circuits of those neighbouring points with the same number of units, since the
+best designs change little from one point to the next.
+
+@param config: SolverConfig, the configuration
+
+@return results: std::vector<SweepResult>, results in the order of Sweep_Grid
+*/
+std::vector<SweepResult> Sweep_Optimization(const SolverConfig &config);
+
+/*
+Write the results of a sweep to a comma-separated table with one line per point:
+num_units, flow_rate_gormanium, flow_rate_waste, price_gormanium, cost_waste,
+performance, recovery, grade, warm_started, circuit (genes separated by spaces).
+
+@param path: std::string, path of the table
+@param results: std::vector<SweepResult>, the results
+
+@return success: bool, whether the table was written
+*/
+bool Write_Sweep_Table(const std::string &path, const std::vector<SweepResult> &results);
+
+#endif // !__SWEEP__
@@ -0,0 +1,80 @@
+/*
+ACSE-4 Group 4.2 - Galena
+First Created: 2021-03-23
+
+Imperial College London
+Department of Earth Science and Engineering
+
+Group members:
+    Iñigo Basterretxea Jacob
+    Gordon Cheung
+    Nina Kahr
+    Miguel Pereira
+    Ranran Tao
+    Suyan Shi
+    Jihao Xin
+    Jie Zhu
+*/
+
+#ifndef __UNIT_FRACTIONS__
+#define __UNIT_FRACTIONS__
+
+// system includes
+#include <vector>
+
+// fractions of the gormanium and of the waste fed into a unit that go to its concentrate
+const double FRACTION_GORMANIUM = 0.2;
+const double FRACTION_WASTE = 0.05;
+
+/*
+Concentrate fractions of each unit of a circuit, for plants whose units do not
+all separate equally well. Unit i sends a fraction gormanium[i] of the gormanium
+and a fraction waste[i] of the waste fed into it to its concentrate, the rest to
+its tailings. The fractions are kept as two arrays indexed by unit, like the
+connectivity in the gene, so that the flow kernel reads them in order.
+
+Empty arrays mean that every unit has FRACTION_GORMANIUM and FRACTION_WASTE, the
+model of the original problem, which the flow kernel evaluates with the
+fractions as compile time constants.
+
+As the units are no longer interchangeable, relabelling the units of a circuit
+(utils::Canonical_Circuit) changes its performance: it is not done when the
+fractions are not uniform.
+
+@member gormanium: std::vector<double>, fraction of gormanium to the concentrate of each unit
+@member waste: std::vector<double>, fraction of waste to the concentrate of each unit
+*/
+struct UnitFractions
+{
+    std::vector<double> gormanium{};
+    std::vector<double> waste{};
+
+    // every unit has FRACTION_GORMANIUM and FRACTION_WASTE
+    bool uniform() const { return gormanium.empty() && waste.empty(); }
+
+    // fractions given for exactly num_units units, each strictly between 0 and 1
+    bool valid(int num_units) const
+    {
+        if (uniform())
+        {
+            return true;
+        }
+        if ((int)gormanium.size() != num_units || (int)waste.size() != num_units)
+        {
+            return false;
+        }
+        for (int i = 0; i < num_units; i++)
+        {
+            if (!(gormanium[i] > 0.0 && gormanium[i] < 1.0 && waste[i] > 0.0 && waste[i] < 1.0))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double gormanium_of(int unit) const { return uniform() ? FRACTION_GORMANIUM : gormanium[unit]; }
+    double waste_of(int unit) const { return uniform() ? FRACTION_WASTE : waste[unit]; }
+};
+
+#endif // !__UNIT_FRACTIONS__
@@ -30,10 +30,13 @@ using modified BFS algorithm," 2014 Science and Information Conference, London,
 
 // local includes
 #include "CUnit.h"
+#include "Unit_Fractions.h"
 
 // system includes
+#include <exception>
 #include <string>
 #include <vector>
+#include <omp.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -62,13 +65,69 @@ namespace utils
                         default to an empty vector
     @param iter: int (optional), the current generation, default to -1
     @param performance: double (optional), the performance of the circuit, default to -1e9
+    @param fractions: UnitFractions (optional), concentrate fractions of the units, written as two
+                        more lines after the performance when they are not uniform
     */
     void Print_Circuit_To_File(std::string path,
                                const std::vector<int> schematic,
                                const std::vector<double> gormanium = {},
                                const std::vector<double> waste = {},
                                const int iter = 0,
-                               const double performance = -1e9);
+                               const double performance = -1e9,
+                               const UnitFractions &fractions = UnitFractions());
+
+    /*
+    Append a Graphviz DOT description of the circuit to a string, with the same style
+    as visualisation.py: units, concentrate and tailings as boxes, concentrate streams
+    in blue and tailings streams dashed in red. If the flows are given, the streams are
+    labelled with their flows of gormanium and waste, coloured by their grade and get
+    a width proportional to their flow, and the graph is labelled with the generation
+    and performance. Render with `dot -Tpng -O file.dot`.
+
+    @param dot: std::string, string the graph is appended to
+    @param schematic: std::vector<int>, circuit to be exported
+    @param gormanium: std::vector<double> (optional), flow volumes of gormanium into each cell,
+                        as for Print_Circuit_To_File, default to an empty vector
+    @param waste: std::vector<double> (optional), flow volumes of waste into each cell,
+                        as for Print_Circuit_To_File, default to an empty vector
+    @param iter: int (optional), the current generation, default to 0
+    @param performance: double (optional), the performance of the circuit, default to -1e9
+    @param name: std::string (optional), name of the graph, default to "circuit"
+    @param input_gormanium: double (optional), kg/s gormanium flowing into the circuit, default to 10
+    @param input_waste: double (optional), kg/s waste flowing into the circuit, default to 100
+    @param fractions: UnitFractions (optional), concentrate fractions of the units, default to uniform
+    */
+    void Append_Dot(std::string &dot,
+                    const std::vector<int> &schematic,
+                    const std::vector<double> &gormanium = {},
+                    const std::vector<double> &waste = {},
+                    int iter = 0,
+                    double performance = -1e9,
+                    const std::string &name = "circuit",
+                    double input_gormanium = 10.0,
+                    double input_waste = 100.0,
+                    const UnitFractions &fractions = UnitFractions());
+
+    /*
+    Write many circuits to a single DOT file, one graph after the other, which
+    `dot -Tpng -O file.dot` renders to file.dot.png, file.dot.2.png, ...
+    The graphs are named circuit_[num_units]_[iteration], as the data files.
+
+    @param filename: std::string, path of the DOT file
+    @param schematics: std::vector<std::vector<int>>, circuits to be exported
+    @param gormanium: std::vector<std::vector<double>> (optional), flows of gormanium of each
+                        circuit, empty if not known, default to an empty vector
+    @param waste: std::vector<std::vector<double>> (optional), flows of waste of each circuit,
+                        empty if not known, default to an empty vector
+    @param iters: std::vector<int> (optional), generation of each circuit, default to 0
+    @param performances: std::vector<double> (optional), performance of each circuit
+    */
+    void Print_Circuits_To_Dot(std::string filename,
+                               const std::vector<std::vector<int>> &schematics,
+                               const std::vector<std::vector<double>> &gormanium = {},
+                               const std::vector<std::vector<double>> &waste = {},
+                               const std::vector<int> &iters = {},
+                               const std::vector<double> &performances = {});
 
     /*
     Helper function for handling the different file separators in different systems
@@ -84,6 +143,77 @@ namespace utils
     */
     std::string Get_Exe_Path();
 
+    /*
+    Run body(i) for every i in [begin, end) in parallel, through the single OpenMP task
+    scheduler shared by the whole program.
+
+    When called from inside a parallel region (for example from one of the concurrent runs
+    of the Genetic Algorithm in `main.cpp`), the iterations become tasks of the existing team,
+    so idle threads pick them up instead of a nested team being forked on top of the busy
+    threads. Otherwise, a team of one thread per place is started for the loop, spread over
+    the places given by OMP_PLACES (e.g. OMP_PLACES=cores pins one thread per core). Each
+    iteration should allocate its own working memory, so that it is first touched, and thus
+    placed, on the NUMA node of the thread running it.
+
+    Exceptions can't leave an OpenMP task, so the first exception thrown by body is caught
+    and re-thrown once all the iterations are done.
+
+    @param begin: int, first index
+    @param end: int, one past the last index
+    @param body: callable taking an int, the work of a single iteration
+    @param grainsize: int (optional), number of consecutive iterations per task, default to 1
+    */
+    template <typename Body>
+    void Parallel_For(int begin, int end, Body body, int grainsize = 1)
+    {
+        std::exception_ptr error{};
+        auto guarded = [&](int i) {
+            try
+            {
+                body(i);
+            }
+            catch (...)
+            {
+#pragma omp critical(utils_parallel_for)
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        };
+#if defined(_OPENMP) && _OPENMP >= 201511
+        if (omp_in_parallel())
+        {
+#pragma omp taskloop grainsize(grainsize) default(shared)
+            for (int i = begin; i < end; i++)
+            {
+                guarded(i);
+            }
+        }
+        else
+        {
+#pragma omp parallel proc_bind(spread)
+#pragma omp single
+#pragma omp taskloop grainsize(grainsize) default(shared)
+            for (int i = begin; i < end; i++)
+            {
+                guarded(i);
+            }
+        }
+#else
+        // compilers without OpenMP tasks (e.g. MSVC) fall back to a dynamic parallel loop
+#pragma omp parallel for schedule(dynamic, grainsize)
+        for (int i = begin; i < end; i++)
+        {
+            guarded(i);
+        }
+#endif
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
     /*
     Algorithm which determines whether or not the given input schematic is valid.
     
@@ -99,6 +229,34 @@ namespace utils
     */
     int Check_Validity(const std::vector<int> &schematic);
 
+    /*
+    Validity of a circuit whose units have their own concentrate fractions: as above, and
+    also 2 if the fractions are not given for every unit, or are not strictly between 0
+    and 1 (a unit sending everything to one output does not separate anything).
+
+    @param schematic: std::vector<int>, the schematic specified in the coded vector form.
+    @param fractions: UnitFractions, concentrate fractions of the units, uniform is always valid
+
+    @return status: int, the codes above
+    */
+    int Check_Validity(const std::vector<int> &schematic, const UnitFractions &fractions);
+
+    /*
+    Relabel the units of a circuit in a deterministic order, so that all the circuits that
+    only differ by a permutation of the unit indices (and therefore perform identically)
+    share the same gene.
+
+    The feed unit becomes unit 0, and the other units are numbered in the order in which a
+    breadth first traversal from the feed discovers them, looking at the concentrate before
+    the tailings of each unit. Units that can't be reached from the feed keep their relative
+    order after the reachable ones. The outputs of the circuit are left unchanged.
+
+    @param schematic: std::vector<int>, the schematic specified in the coded vector form.
+
+    @return canonical: std::vector<int>, the relabelled schematic
+    */
+    std::vector<int> Canonical_Circuit(const std::vector<int> &schematic);
+
     /*
     Conducts single BFS search of a circuit defined as a vector of SeparationUnits.
     Do not call this directly unless you know what you're doing.
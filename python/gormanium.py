@@ -0,0 +1,152 @@
+"""
+Python driver of libgormanium, the C interface of the solver (includes/Gormanium.h).
+
+Build the library with `make libgormanium`, then from this folder
+
+    python gormanium.py
+
+or from a notebook
+
+    import numpy as np
+    import gormanium
+    circuits = np.array([[0, 1, 2, 2, 0, 3, 4], [0, 1, 1, 0, 0, 3, 4]], dtype=np.int32)
+    result = gormanium.evaluate_batch(circuits)
+    result["performance"]
+
+The NumPy arrays are handed to the library as pointers, without copies: the batch of
+circuits must be a C-contiguous int32 array of shape (count, 2 * num_units + 1), which
+np.ascontiguousarray(..., dtype=np.int32) returns unchanged when it already is one.
+"""
+
+import ctypes
+import os
+
+import numpy as np
+
+ABI_VERSION = 1
+
+_int_p = ctypes.POINTER(ctypes.c_int)
+_double_p = ctypes.POINTER(ctypes.c_double)
+
+
+def _load(path=None):
+    if path is None:
+        path = os.environ.get(
+            "GORMANIUM_LIBRARY",
+            os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "bin", "libgormanium.so"))
+    lib = ctypes.CDLL(path)
+    lib.gormanium_abi_version.restype = ctypes.c_int
+    lib.gormanium_check_validity.argtypes = [_int_p, ctypes.c_int]
+    lib.gormanium_check_validity.restype = ctypes.c_int
+    lib.gormanium_evaluate_flows.argtypes = [_int_p, ctypes.c_int, ctypes.c_double, ctypes.c_int,
+                                             ctypes.c_double, ctypes.c_double, _double_p, _double_p]
+    lib.gormanium_evaluate_flows.restype = ctypes.c_int
+    lib.gormanium_evaluate_circuit.argtypes = [_int_p, ctypes.c_int, ctypes.c_double, ctypes.c_int,
+                                               ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double]
+    lib.gormanium_evaluate_circuit.restype = ctypes.c_double
+    lib.gormanium_evaluate_batch.argtypes = [_int_p, ctypes.c_int, ctypes.c_int, ctypes.c_double, ctypes.c_int,
+                                             ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double,
+                                             _int_p, _double_p, _double_p, _double_p]
+    lib.gormanium_evaluate_batch.restype = ctypes.c_int
+    lib.gormanium_genetic_optimization.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int,
+                                                   ctypes.c_double, ctypes.c_double, ctypes.c_double,
+                                                   ctypes.c_double, ctypes.c_uint, _int_p, _double_p]
+    lib.gormanium_genetic_optimization.restype = ctypes.c_int
+    if lib.gormanium_abi_version() != ABI_VERSION:
+        raise RuntimeError("libgormanium has ABI version %d, expected %d"
+                           % (lib.gormanium_abi_version(), ABI_VERSION))
+    return lib
+
+
+_lib = _load()
+
+
+def _circuit(circuit):
+    circuit = np.ascontiguousarray(circuit, dtype=np.int32)
+    return circuit, (circuit.shape[-1] - 1) // 2
+
+
+def check_validity(circuit):
+    """0 if the circuit is valid, the code of utils::Check_Validity otherwise"""
+    circuit, num_units = _circuit(circuit)
+    return _lib.gormanium_check_validity(circuit.ctypes.data_as(_int_p), num_units)
+
+
+def evaluate_circuit(circuit, price_gormanium=100.0, cost_waste=500.0, feed_gormanium=10.0, feed_waste=100.0,
+                     tolerance=1e-4, max_iterations=1000):
+    """performance of a valid circuit"""
+    circuit, num_units = _circuit(circuit)
+    return _lib.gormanium_evaluate_circuit(circuit.ctypes.data_as(_int_p), num_units, tolerance, max_iterations,
+                                           price_gormanium, cost_waste, feed_gormanium, feed_waste)
+
+
+def evaluate_flows(circuit, feed_gormanium=10.0, feed_waste=100.0, tolerance=1e-4, max_iterations=1000):
+    """gormanium and waste flows into each unit, the concentrate and the tailings"""
+    circuit, num_units = _circuit(circuit)
+    gormanium = np.empty(num_units + 2)
+    waste = np.empty(num_units + 2)
+    code = _lib.gormanium_evaluate_flows(circuit.ctypes.data_as(_int_p), num_units, tolerance, max_iterations,
+                                         feed_gormanium, feed_waste, gormanium.ctypes.data_as(_double_p),
+                                         waste.ctypes.data_as(_double_p))
+    if code != 0:
+        raise ValueError("flows not evaluated, code %d" % code)
+    return gormanium, waste
+
+
+def evaluate_batch(circuits, price_gormanium=100.0, cost_waste=500.0, feed_gormanium=10.0, feed_waste=100.0,
+                   tolerance=1e-4, max_iterations=1000):
+    """
+    validity code, performance and concentrate flows of a (count, 2 * num_units + 1)
+    array of circuits, evaluated in parallel. Invalid circuits get NaN.
+    """
+    circuits, num_units = _circuit(circuits)
+    if circuits.ndim != 2:
+        raise ValueError("circuits must be a 2D array")
+    count = circuits.shape[0]
+    result = {
+        "validity": np.empty(count, dtype=np.int32),
+        "performance": np.empty(count),
+        "concentrate_gormanium": np.empty(count),
+        "concentrate_waste": np.empty(count),
+    }
+    valid = _lib.gormanium_evaluate_batch(
+        circuits.ctypes.data_as(_int_p), count, num_units, tolerance, max_iterations, price_gormanium, cost_waste,
+        feed_gormanium, feed_waste, result["validity"].ctypes.data_as(_int_p),
+        result["performance"].ctypes.data_as(_double_p), result["concentrate_gormanium"].ctypes.data_as(_double_p),
+        result["concentrate_waste"].ctypes.data_as(_double_p))
+    if valid < 0:
+        raise ValueError("batch not evaluated, code %d" % valid)
+    return result
+
+
+def genetic_optimization(num_units=10, population_size=100, max_iterations=1000, threshold=100, feed_gormanium=10.0,
+                         feed_waste=100.0, price_gormanium=100.0, cost_waste=500.0, seed=0):
+    """best circuit found by Genetic_Optimization and its performance"""
+    best = np.empty(2 * num_units + 1, dtype=np.int32)
+    performance = ctypes.c_double()
+    code = _lib.gormanium_genetic_optimization(population_size, max_iterations, threshold, num_units,
+                                               feed_gormanium, feed_waste, price_gormanium, cost_waste, seed,
+                                               best.ctypes.data_as(_int_p), ctypes.byref(performance))
+    if code != 0:
+        raise ValueError("optimisation failed, code %d" % code)
+    return best, performance.value
+
+
+if __name__ == "__main__":
+    import time
+
+    best, performance = genetic_optimization(num_units=10, seed=1)
+    print("best circuit", best.tolist(), "performance", performance)
+
+    # a million random circuits of 10 units, most of them invalid
+    rng = np.random.default_rng(0)
+    count, num_units = 1000000, 10
+    circuits = rng.integers(0, num_units + 2, size=(count, 2 * num_units + 1), dtype=np.int32)
+    circuits[:, 0] = rng.integers(0, num_units, size=count, dtype=np.int32)
+    circuits[0] = best
+    start = time.perf_counter()
+    result = evaluate_batch(circuits)
+    seconds = time.perf_counter() - start
+    valid = result["validity"] == 0
+    print("%d circuits, %d valid, in %.2f s" % (count, valid.sum(), seconds))
+    print("best random circuit", np.nanmax(result["performance"][1:]))
@@ -0,0 +1,331 @@
+#include "Archive.h"
+#include "utils.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    const char MAGIC[8] = {'G', 'A', 'L', 'E', 'N', 'A', 'A', 'R'};
+    const uint32_t VERSION = 1;
+    const size_t HEADER_SIZE = ArchiveReader::HEADER_SIZE;
+    // position of the number of records in the header
+    const size_t COUNT_OFFSET = 24;
+
+    size_t Record_Size(int num_units)
+    {
+        size_t size = 8 * (1 + 2 * (num_units + 2)) + 4 + 4 + 2 + 2 * (2 * num_units + 1);
+        return (size + 7) / 8 * 8;
+    }
+
+    template <typename T>
+    void Put(char *data, size_t offset, T value)
+    {
+        memcpy(data + offset, &value, sizeof(T));
+    }
+
+    template <typename T>
+    T Get(const char *data, size_t offset)
+    {
+        T value;
+        memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+}
+
+ArchiveWriter::ArchiveWriter(const string &path, int num_units, int buffer_records)
+    : num_units_{num_units},
+      record_size_{Record_Size(num_units)},
+      buffer_records_{(size_t)max(buffer_records, 1)}
+{
+    file_.open(path, ios::in | ios::out | ios::binary);
+    if (file_.is_open())
+    {
+        // existing archive: check it and drop any torn record after the last complete one
+        char header[HEADER_SIZE];
+        if (!file_.read(header, HEADER_SIZE) ||
+            memcmp(header, MAGIC, sizeof(MAGIC)) != 0 ||
+            Get<uint32_t>(header, 8) != VERSION ||
+            (int)Get<uint32_t>(header, 12) != num_units ||
+            Get<uint32_t>(header, 16) != record_size_)
+        {
+            throw BadArchive();
+        }
+        written_ = Get<uint64_t>(header, COUNT_OFFSET);
+        file_.seekp(HEADER_SIZE + written_ * record_size_);
+    }
+    else
+    {
+        file_.clear();
+        file_.open(path, ios::out | ios::binary | ios::trunc);
+        file_.close();
+        file_.open(path, ios::in | ios::out | ios::binary);
+        if (!file_.is_open())
+        {
+            throw BadArchive();
+        }
+        char header[HEADER_SIZE] = {};
+        memcpy(header, MAGIC, sizeof(MAGIC));
+        Put<uint32_t>(header, 8, VERSION);
+        Put<uint32_t>(header, 12, num_units);
+        Put<uint32_t>(header, 16, record_size_);
+        Put<uint64_t>(header, COUNT_OFFSET, 0);
+        file_.write(header, HEADER_SIZE);
+    }
+    buffer_.reserve(buffer_records_ * record_size_);
+}
+
+ArchiveWriter::~ArchiveWriter()
+{
+    Flush();
+}
+
+void ArchiveWriter::Append(const vector<int> &circuit,
+                           double performance,
+                           int run,
+                           int generation,
+                           const vector<double> &gormanium,
+                           const vector<double> &waste)
+{
+    lock_guard<mutex> guard(lock_);
+    size_t start = buffer_.size();
+    buffer_.resize(start + record_size_, 0);
+    char *record = buffer_.data() + start;
+    bool has_flows = (int)gormanium.size() == num_units_ + 2 && (int)waste.size() == num_units_ + 2;
+
+    Put<double>(record, 0, performance);
+    if (has_flows)
+    {
+        memcpy(record + 8, gormanium.data(), 8 * (num_units_ + 2));
+        memcpy(record + 8 * (1 + num_units_ + 2), waste.data(), 8 * (num_units_ + 2));
+    }
+    size_t fixed = 8 * (1 + 2 * (num_units_ + 2));
+    Put<int32_t>(record, fixed, run);
+    Put<int32_t>(record, fixed + 4, generation);
+    Put<uint16_t>(record, fixed + 8, has_flows ? 1 : 0);
+    for (int i = 0; i < 2 * num_units_ + 1 && i < (int)circuit.size(); i++)
+    {
+        Put<uint16_t>(record, fixed + 10 + 2 * i, circuit[i]);
+    }
+
+    if (buffer_.size() >= buffer_records_ * record_size_)
+    {
+        Flush_Locked();
+    }
+}
+
+void ArchiveWriter::Flush()
+{
+    lock_guard<mutex> guard(lock_);
+    Flush_Locked();
+}
+
+void ArchiveWriter::Flush_Locked()
+{
+    if (buffer_.empty())
+    {
+        return;
+    }
+    // the records first, then the count that makes them visible
+    file_.seekp(HEADER_SIZE + written_ * record_size_);
+    file_.write(buffer_.data(), buffer_.size());
+    file_.flush();
+    written_ += buffer_.size() / record_size_;
+    buffer_.clear();
+    file_.seekp(COUNT_OFFSET);
+    file_.write(reinterpret_cast<const char *>(&written_), sizeof(written_));
+    file_.flush();
+}
+
+uint64_t ArchiveWriter::size() const
+{
+    lock_guard<mutex> guard(lock_);
+    return written_ + buffer_.size() / record_size_;
+}
+
+vector<int> ArchiveRecord::Circuit() const
+{
+    vector<int> circuit(2 * num_units_ + 1);
+    for (size_t i = 0; i < circuit.size(); i++)
+    {
+        circuit[i] = gene(i);
+    }
+    return circuit;
+}
+
+vector<double> ArchiveRecord::Gormanium() const
+{
+    vector<double> flows(num_units_ + 2);
+    for (int i = 0; i < num_units_ + 2; i++)
+    {
+        flows[i] = gormanium(i);
+    }
+    return flows;
+}
+
+vector<double> ArchiveRecord::Waste() const
+{
+    vector<double> flows(num_units_ + 2);
+    for (int i = 0; i < num_units_ + 2; i++)
+    {
+        flows[i] = waste(i);
+    }
+    return flows;
+}
+
+ArchiveReader::ArchiveReader(const string &path)
+{
+#ifdef _WIN32
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_ == INVALID_HANDLE_VALUE)
+    {
+        file_ = nullptr;
+        throw BadArchive();
+    }
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file_, &file_size);
+    length_ = file_size.QuadPart;
+    if (length_ >= HEADER_SIZE)
+    {
+        mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping_ != nullptr)
+        {
+            data_ = static_cast<const char *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw BadArchive();
+    }
+    struct stat status;
+    if (fstat(fd, &status) == 0 && (size_t)status.st_size >= HEADER_SIZE)
+    {
+        length_ = status.st_size;
+        void *mapped = mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED)
+        {
+            data_ = static_cast<const char *>(mapped);
+            // records are mostly read in order
+            madvise(mapped, length_, MADV_SEQUENTIAL);
+        }
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+#endif
+    if (data_ == nullptr || memcmp(data_, MAGIC, sizeof(MAGIC)) != 0 || Get<uint32_t>(data_, 8) != VERSION)
+    {
+        Close();
+        throw BadArchive();
+    }
+    num_units_ = Get<uint32_t>(data_, 12);
+    record_size_ = Get<uint32_t>(data_, 16);
+    // the records are read with the layout of their number of units
+    if (num_units_ <= 0 || record_size_ != Record_Size(num_units_))
+    {
+        Close();
+        throw BadArchive();
+    }
+    // never trust the count beyond what is actually in the file
+    size_ = min<uint64_t>(Get<uint64_t>(data_, COUNT_OFFSET), (length_ - HEADER_SIZE) / record_size_);
+}
+
+ArchiveReader::~ArchiveReader()
+{
+    Close();
+}
+
+void ArchiveReader::Close()
+{
+#ifdef _WIN32
+    if (data_ != nullptr)
+    {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr)
+    {
+        CloseHandle(mapping_);
+    }
+    if (file_ != nullptr)
+    {
+        CloseHandle(file_);
+    }
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (data_ != nullptr)
+    {
+        munmap(const_cast<char *>(data_), length_);
+    }
+#endif
+    data_ = nullptr;
+}
+
+int Archive_To_Text(const string &archive_path, const string &directory, int run)
+{
+    ArchiveReader archive(archive_path);
+    int converted = 0;
+    for (uint64_t i = 0; i < archive.size(); i++)
+    {
+        ArchiveRecord record = archive[i];
+        if (run >= 0 && record.run() != run)
+        {
+            continue;
+        }
+        if (record.has_flows())
+        {
+            utils::Print_Circuit_To_File(directory, record.Circuit(), record.Gormanium(), record.Waste(),
+                                         record.generation(), record.performance());
+        }
+        else
+        {
+            utils::Print_Circuit_To_File(directory, record.Circuit(), {}, {}, record.generation());
+        }
+        converted++;
+    }
+    return converted;
+}
+
+int Archive_To_Dot(const string &archive_path, const string &dot_path, int run)
+{
+    ArchiveReader archive(archive_path);
+    ofstream out(dot_path, ofstream::out | ofstream::binary);
+    string dot;
+    int converted = 0;
+    for (uint64_t i = 0; i < archive.size(); i++)
+    {
+        ArchiveRecord record = archive[i];
+        if (run >= 0 && record.run() != run)
+        {
+            continue;
+        }
+        string name = "run_" + to_string(record.run()) + "_generation_" + to_string(record.generation());
+        if (record.has_flows())
+        {
+            utils::Append_Dot(dot, record.Circuit(), record.Gormanium(), record.Waste(),
+                              record.generation(), record.performance(), name);
+        }
+        else
+        {
+            utils::Append_Dot(dot, record.Circuit(), {}, {}, record.generation(), record.performance(), name);
+        }
+        converted++;
+        if (dot.size() > (1 << 20))
+        {
+            out.write(dot.data(), dot.size());
+            dot.clear();
+        }
+    }
+    out.write(dot.data(), dot.size());
+    return converted;
+}
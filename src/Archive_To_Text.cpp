@@ -0,0 +1,65 @@
+// local includes
+#include "Archive.h"
+#include "utils.h"
+// system includes
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+    const char *USAGE = " archive [directory | file.dot] [run]";
+
+    // the whole text must be the run id
+    int To_Run(const string &text)
+    {
+        try
+        {
+            size_t used;
+            int run = stoi(text, &used);
+            if (used == text.size())
+            {
+                return run;
+            }
+        }
+        catch (const logic_error &e)
+        {
+        }
+        throw invalid_argument("Bad run: " + text);
+    }
+}
+
+// Converts a circuit archive to the text files read by visualisation.py, or to a
+// single DOT file of all the circuits if the output ends with .dot
+// usage: Archive_To_Text archive [directory | file.dot] [run]
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cout << "usage: " << argv[0] << USAGE << endl;
+        return 1;
+    }
+    // by default, next to the files of the main executable in `data/`
+    string directory = argc > 2 ? argv[2] : utils::Get_Exe_Path() + utils::File_Sep() + ".." + utils::File_Sep() + "data";
+    try
+    {
+        int run = argc > 3 ? To_Run(argv[3]) : -1;
+        bool dot = directory.size() > 4 && directory.compare(directory.size() - 4, 4, ".dot") == 0;
+        int converted = dot ? Archive_To_Dot(argv[1], directory, run) : Archive_To_Text(argv[1], directory, run);
+        cout << converted << " circuits written to " << directory << endl;
+    }
+    catch (const BadArchive &e)
+    {
+        cout << e.what() << ": " << argv[1] << endl;
+        return 1;
+    }
+    catch (const invalid_argument &e)
+    {
+        cerr << e.what() << endl
+             << "usage: " << argv[0] << USAGE << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,291 @@
+#include "Background_Writer.h"
+#include "utils.h"
+
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <map>
+
+using namespace std;
+
+namespace
+{
+    // number of requests written at most per batch
+    const size_t BATCH_SIZE = 256;
+
+    template <typename T>
+    void Append_Number(string &out, T value)
+    {
+        char digits[32];
+        to_chars_result result = to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    template <typename T>
+    void Append_List(string &out, const vector<T> &values)
+    {
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            Append_Number(out, values[i]);
+            if (i != values.size() - 1)
+            {
+                out += ", ";
+            }
+        }
+    }
+
+    // the 6 significant digits an ostream writes by default
+    void Append_Printed(string &out, double value)
+    {
+        char digits[32];
+        to_chars_result result = to_chars(digits, digits + sizeof(digits), value, chars_format::general, 6);
+        out.append(digits, result.ptr);
+    }
+
+    void Append_Printed_List(string &out, const vector<double> &values)
+    {
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            Append_Printed(out, values[i]);
+            if (i != values.size() - 1)
+            {
+                out += ", ";
+            }
+        }
+    }
+
+    // same layout and digits as utils::Print_Circuit_To_File
+    void Format_Circuit(string &out, const OutputRequest &request)
+    {
+        Append_List(out, request.schematic);
+        out += '\n';
+        if (request.gormanium.size() != 0)
+        {
+            Append_Printed_List(out, request.gormanium);
+            out += '\n';
+            Append_Printed_List(out, request.waste);
+            out += '\n';
+            Append_Printed(out, request.performance);
+            if (!request.fractions.uniform())
+            {
+                out += '\n';
+                Append_Printed_List(out, request.fractions.gormanium);
+                out += '\n';
+                Append_Printed_List(out, request.fractions.waste);
+            }
+        }
+    }
+
+    void Format_Json(string &out, const OutputRequest &request)
+    {
+        out += "{\"run\": ";
+        Append_Number(out, request.run);
+        out += ", \"generation\": ";
+        Append_Number(out, request.iteration);
+        out += ", \"performance\": ";
+        Append_Number(out, request.performance);
+        out += ", \"circuit\": [";
+        Append_List(out, request.schematic);
+        out += "]";
+        if (request.gormanium.size() != 0)
+        {
+            out += ", \"gormanium\": [";
+            Append_List(out, request.gormanium);
+            out += "], \"waste\": [";
+            Append_List(out, request.waste);
+            out += "]";
+        }
+        out += "}\n";
+    }
+}
+
+BackgroundWriter::BackgroundWriter(size_t capacity) : queue_{capacity}
+{
+    thread_ = thread(&BackgroundWriter::Run, this);
+}
+
+BackgroundWriter::~BackgroundWriter()
+{
+    Flush();
+    stop_.store(true);
+    {
+        lock_guard<mutex> guard(lock_);
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+void BackgroundWriter::Write_Circuit(const string &path,
+                                     const vector<int> &schematic,
+                                     const vector<double> &gormanium,
+                                     const vector<double> &waste,
+                                     int iter,
+                                     double performance,
+                                     const UnitFractions &fractions)
+{
+    OutputRequest request;
+    request.kind = OutputRequest::Kind::Circuit;
+    request.path = path;
+    request.schematic = schematic;
+    request.gormanium = gormanium;
+    request.waste = waste;
+    request.iteration = iter;
+    request.performance = performance;
+    request.fractions = fractions;
+    Submit(request);
+}
+
+void BackgroundWriter::Append_Line(const string &path, string line)
+{
+    OutputRequest request;
+    request.kind = OutputRequest::Kind::Line;
+    request.path = path;
+    request.line = move(line);
+    Submit(request);
+}
+
+void BackgroundWriter::Log_Circuit(const string &path,
+                                   int run,
+                                   int generation,
+                                   const vector<int> &schematic,
+                                   const vector<double> &gormanium,
+                                   const vector<double> &waste,
+                                   double performance)
+{
+    OutputRequest request;
+    request.kind = OutputRequest::Kind::Json;
+    request.path = path;
+    request.run = run;
+    request.iteration = generation;
+    request.schematic = schematic;
+    request.gormanium = gormanium;
+    request.waste = waste;
+    request.performance = performance;
+    Submit(request);
+}
+
+void BackgroundWriter::Submit(OutputRequest &request)
+{
+    submitted_.fetch_add(1, memory_order_relaxed);
+    if (!queue_.Push(request))
+    {
+        // back pressure: wait for the writer to make room
+        full_waits_.fetch_add(1, memory_order_relaxed);
+        wake_.notify_one();
+        while (!queue_.Push(request))
+        {
+            this_thread::yield();
+        }
+    }
+    uint64_t depth = queue_.size();
+    uint64_t max_depth = max_depth_.load(memory_order_relaxed);
+    while (depth > max_depth && !max_depth_.compare_exchange_weak(max_depth, depth, memory_order_relaxed))
+    {
+    }
+    // only pay for a system call when the writer is asleep
+    if (sleeping_.load(memory_order_acquire))
+    {
+        wake_.notify_one();
+    }
+}
+
+void BackgroundWriter::Flush()
+{
+    uint64_t target = submitted_.load();
+    unique_lock<mutex> guard(lock_);
+    wake_.notify_one();
+    done_.wait(guard, [&] { return written_.load() >= target; });
+}
+
+WriterStats BackgroundWriter::Stats() const
+{
+    WriterStats stats;
+    stats.submitted = submitted_.load();
+    stats.written = written_.load();
+    stats.batches = batches_.load();
+    stats.full_waits = full_waits_.load();
+    stats.max_depth = max_depth_.load();
+    return stats;
+}
+
+void BackgroundWriter::Run()
+{
+    vector<OutputRequest> batch;
+    batch.reserve(BATCH_SIZE);
+    OutputRequest request;
+    while (true)
+    {
+        while (batch.size() < BATCH_SIZE && queue_.Pop(request))
+        {
+            batch.push_back(move(request));
+        }
+        if (!batch.empty())
+        {
+            Write(batch);
+            batches_.fetch_add(1, memory_order_relaxed);
+            {
+                lock_guard<mutex> guard(lock_);
+                written_.fetch_add(batch.size());
+            }
+            done_.notify_all();
+            batch.clear();
+            continue;
+        }
+        if (stop_.load())
+        {
+            break;
+        }
+        // nothing to do: sleep until woken up, with a timeout in case a wake up is missed
+        unique_lock<mutex> guard(lock_);
+        sleeping_.store(true, memory_order_release);
+        wake_.wait_for(guard, chrono::milliseconds(10), [&] { return stop_.load() || queue_.size() > 0; });
+        sleeping_.store(false, memory_order_release);
+    }
+}
+
+void BackgroundWriter::Write(vector<OutputRequest> &batch)
+{
+    // the files lines are appended to stay open for the whole batch
+    map<string, ofstream> appended;
+    string text;
+    for (OutputRequest &request : batch)
+    {
+        text.clear();
+        if (request.kind == OutputRequest::Kind::Line || request.kind == OutputRequest::Kind::Json)
+        {
+            ofstream &out = appended[request.path];
+            if (!out.is_open())
+            {
+                out.open(request.path, ofstream::out | ofstream::app);
+            }
+            if (request.kind == OutputRequest::Kind::Json)
+            {
+                Format_Json(text, request);
+            }
+            else
+            {
+                text = move(request.line);
+                text += '\n';
+            }
+            out.write(text.data(), text.size());
+        }
+        else
+        {
+            int n = (request.schematic.size() - 1) / 2;
+            string filename = request.path + utils::File_Sep() + "circuit_" +
+                              to_string(n) + "_" + to_string(request.iteration) + ".txt";
+            Format_Circuit(text, request);
+            ofstream out(filename, ofstream::out);
+            if (out.good())
+            {
+                out.write(text.data(), text.size());
+            }
+        }
+    }
+}
+
+BackgroundWriter &Output_Writer()
+{
+    static BackgroundWriter writer;
+    return writer;
+}
@@ -0,0 +1,122 @@
+// local includes
+#include "Bulk_Evaluator.h"
+// system includes
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+    const char *USAGE =
+        " [--input FILE] [--output FILE] [--binary_input] [--binary_output] [--no_header]\n"
+        "    [--flow_rate_gormanium X] [--flow_rate_waste X] [--price_gormanium X] [--cost_waste X] [--chunk N]\n"
+        "input and output default to the standard streams (also `-`)";
+}
+
+// Validates and evaluates every circuit of a (possibly huge) file, one result per circuit
+// usage: Bulk_Evaluate [--input FILE] [--output FILE] [options], see USAGE
+int main(int argc, char *argv[])
+{
+    BulkOptions options;
+    string input = "-", output = "-";
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            string flag = argv[i];
+            if (flag == "--binary_input")
+            {
+                options.binary_input = true;
+                continue;
+            }
+            if (flag == "--binary_output")
+            {
+                options.binary_output = true;
+                continue;
+            }
+            if (flag == "--no_header")
+            {
+                options.header = false;
+                continue;
+            }
+            if (i + 1 == argc)
+            {
+                throw invalid_argument("unknown flag or missing value: " + flag);
+            }
+            string value = argv[++i];
+            if (flag == "--input")
+            {
+                input = value;
+            }
+            else if (flag == "--output")
+            {
+                output = value;
+            }
+            else if (flag == "--flow_rate_gormanium")
+            {
+                options.flow_rate_gormanium = stod(value);
+            }
+            else if (flag == "--flow_rate_waste")
+            {
+                options.flow_rate_waste = stod(value);
+            }
+            else if (flag == "--price_gormanium")
+            {
+                options.price_gormanium = stod(value);
+            }
+            else if (flag == "--cost_waste")
+            {
+                options.cost_waste = stod(value);
+            }
+            else if (flag == "--chunk")
+            {
+                options.chunk_size = stoi(value);
+            }
+            else
+            {
+                throw invalid_argument("unknown flag: " + flag);
+            }
+        }
+    }
+    catch (const logic_error &e)
+    {
+        cerr << e.what() << "\nusage: " << argv[0] << USAGE << endl;
+        return 1;
+    }
+
+    ifstream input_file;
+    ofstream output_file;
+    if (input != "-")
+    {
+        input_file.open(input, ios::binary);
+        if (!input_file)
+        {
+            cerr << "cannot open " << input << endl;
+            return 1;
+        }
+    }
+    if (output != "-")
+    {
+        output_file.open(output, ios::binary);
+        if (!output_file)
+        {
+            cerr << "cannot open " << output << endl;
+            return 1;
+        }
+    }
+    istream &in = input != "-" ? input_file : cin;
+    ostream &out = output != "-" ? output_file : cout;
+    ios::sync_with_stdio(false);
+
+    auto start = chrono::steady_clock::now();
+    BulkStats stats = Bulk_Evaluate(in, out, options);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    // the summary goes to stderr, stdout may be the results
+    cerr << stats.circuits << " circuits, " << stats.valid << " valid, in " << seconds << " s ("
+         << stats.circuits / max(seconds, 1e-9) << " circuits/s)" << endl;
+    return out ? 0 : 1;
+}
@@ -0,0 +1,305 @@
+#include "Bulk_Evaluator.h"
+#include "Genetic_Algorithm.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <future>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const int MALFORMED = -1;
+    const int NOT_CONVERGED = 3;
+    const int MASS_BALANCE = 4;
+
+    bool Well_Formed(const int *genes, size_t size)
+    {
+        if (size < 3 || size % 2 == 0)
+        {
+            return false;
+        }
+        int n = (size - 1) / 2;
+        if (genes[0] < 0 || genes[0] >= n)
+        {
+            return false;
+        }
+        for (size_t i = 1; i < size; i++)
+        {
+            if (genes[i] < 0 || genes[i] > n + 1)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the circuits of a chunk, stored one after the other
+    struct Chunk
+    {
+        vector<int> genes{};
+        // circuit i is genes[offsets[i]] to genes[offsets[i + 1]], empty if not a list of integers
+        vector<size_t> offsets{0};
+        vector<int> code{};
+        vector<double> performance{};
+        vector<double> gormanium{};
+        vector<double> waste{};
+
+        size_t size() const { return offsets.size() - 1; }
+
+        void Add(const int *circuit, size_t size)
+        {
+            genes.insert(genes.end(), circuit, circuit + size);
+            offsets.push_back(genes.size());
+        }
+    };
+
+    class CircuitReader
+    {
+    public:
+        CircuitReader(istream &in, bool binary) : in_{in}, binary_{binary} {}
+
+        // read up to count circuits, false once the input is exhausted
+        bool Read(Chunk &chunk, size_t count)
+        {
+            chunk.genes.clear();
+            chunk.offsets.assign(1, 0);
+            while (chunk.size() < count && (binary_ ? Read_Binary(chunk) : Read_Text(chunk)))
+            {
+            }
+            return chunk.size() > 0;
+        }
+
+    private:
+        bool Read_Binary(Chunk &chunk)
+        {
+            uint16_t num_units;
+            if (!in_.read(reinterpret_cast<char *>(&num_units), sizeof(num_units)))
+            {
+                return false;
+            }
+            raw_.resize(2 * num_units + 1);
+            if (!in_.read(reinterpret_cast<char *>(raw_.data()), raw_.size() * sizeof(uint16_t)))
+            {
+                // a truncated last record is dropped
+                return false;
+            }
+            genes_.assign(raw_.begin(), raw_.end());
+            chunk.Add(genes_.data(), genes_.size());
+            return true;
+        }
+
+        bool Read_Text(Chunk &chunk)
+        {
+            while (getline(in_, line_))
+            {
+                // split on commas and spaces, noting whether every value is an integer
+                genes_.clear();
+                size_t values = 0;
+                bool integers = true;
+                const char *position = line_.data();
+                const char *end = position + line_.size();
+                while (position < end)
+                {
+                    while (position < end && (*position == ',' || isspace((unsigned char)*position)))
+                    {
+                        position++;
+                    }
+                    if (position == end)
+                    {
+                        break;
+                    }
+                    const char *token = position;
+                    while (position < end && *position != ',' && !isspace((unsigned char)*position))
+                    {
+                        position++;
+                    }
+                    values++;
+                    int gene;
+                    from_chars_result result = from_chars(token, position, gene);
+                    if (result.ec != errc() || result.ptr != position)
+                    {
+                        integers = false;
+                    }
+                    else
+                    {
+                        genes_.push_back(gene);
+                    }
+                }
+                if (values == 0 || line_[line_.find_first_not_of(" \t")] == '#')
+                {
+                    continue;
+                }
+                // the flows, the performance and the unit fractions written after a circuit; a line
+                // of integers is the next circuit, whatever its length
+                if (last_units_ > 0 && fraction_lines_ < 0 && flow_lines_ < 2 && !integers &&
+                    values == (size_t)last_units_ + 2)
+                {
+                    flow_lines_++;
+                    continue;
+                }
+                if (last_units_ > 0 && fraction_lines_ < 0 && values == 1)
+                {
+                    fraction_lines_ = 0;
+                    continue;
+                }
+                if (last_units_ > 0 && fraction_lines_ >= 0 && fraction_lines_ < 2 && !integers &&
+                    values == (size_t)last_units_)
+                {
+                    fraction_lines_++;
+                    continue;
+                }
+                chunk.Add(genes_.data(), integers ? genes_.size() : 0);
+                last_units_ = values % 2 == 1 ? (values - 1) / 2 : 0;
+                flow_lines_ = 0;
+                fraction_lines_ = -1;
+                return true;
+            }
+            return false;
+        }
+
+        istream &in_;
+        bool binary_;
+        string line_{};
+        vector<int> genes_{};
+        vector<uint16_t> raw_{};
+        // number of units of the last circuit, while its flows and performance may follow
+        int last_units_{0};
+        int flow_lines_{0};
+        // -1 until its performance is read
+        int fraction_lines_{-1};
+    };
+
+    void Evaluate_Chunk(Chunk &chunk, const BulkOptions &options)
+    {
+        size_t size = chunk.size();
+        chunk.code.resize(size);
+        chunk.performance.resize(size);
+        chunk.gormanium.resize(size);
+        chunk.waste.resize(size);
+        utils::Parallel_For(0, size, [&](int i) {
+            size_t begin = chunk.offsets[i];
+            chunk.code[i] = Bulk_Evaluate_Circuit(chunk.genes.data() + begin, chunk.offsets[i + 1] - begin, options,
+                                                  chunk.performance[i], chunk.gormanium[i], chunk.waste[i]);
+        }, 64);
+    }
+
+    template <typename T>
+    void Append_Number(string &out, T value)
+    {
+        char digits[32];
+        to_chars_result result = to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    template <typename T>
+    void Append_Binary(string &out, T value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void Write_Chunk(const Chunk &chunk, ostream &out, const BulkOptions &options, string &buffer)
+    {
+        buffer.clear();
+        for (size_t i = 0; i < chunk.size(); i++)
+        {
+            bool scored = chunk.code[i] == 0 || chunk.code[i] == NOT_CONVERGED;
+            if (options.binary_output)
+            {
+                Append_Binary<int32_t>(buffer, chunk.code[i]);
+                Append_Binary(buffer, chunk.performance[i]);
+                Append_Binary(buffer, chunk.gormanium[i]);
+                Append_Binary(buffer, chunk.waste[i]);
+                continue;
+            }
+            Append_Number(buffer, chunk.code[i]);
+            buffer += ',';
+            if (scored)
+            {
+                Append_Number(buffer, chunk.performance[i]);
+                buffer += ',';
+                Append_Number(buffer, chunk.gormanium[i]);
+                buffer += ',';
+                Append_Number(buffer, chunk.waste[i]);
+            }
+            else
+            {
+                buffer += ",,";
+            }
+            buffer += '\n';
+        }
+        out.write(buffer.data(), buffer.size());
+    }
+}
+
+int Bulk_Evaluate_Circuit(const int *genes, size_t size, const BulkOptions &options,
+                          double &performance, double &concentrate_gormanium, double &concentrate_waste)
+{
+    performance = concentrate_gormanium = concentrate_waste = numeric_limits<double>::quiet_NaN();
+    if (!Well_Formed(genes, size))
+    {
+        return MALFORMED;
+    }
+    vector<int> circuit(genes, genes + size);
+    int code = utils::Check_Validity(circuit);
+    if (code != 0)
+    {
+        return code;
+    }
+    int n = (size - 1) / 2;
+    // reused by the circuits evaluated on the same thread
+    thread_local vector<double> gormanium, waste;
+    gormanium.assign(n + 2, 0.0);
+    waste.assign(n + 2, 0.0);
+    try
+    {
+        Evaluate_Flows(gormanium, waste, circuit, options.tolerance, options.max_iterations, options.price_gormanium,
+                       options.cost_waste, options.flow_rate_gormanium, options.flow_rate_waste);
+        concentrate_gormanium = gormanium[n];
+        concentrate_waste = waste[n];
+    }
+    catch (const int error_code)
+    {
+        if (error_code != 1)
+        {
+            return MASS_BALANCE;
+        }
+        code = NOT_CONVERGED;
+        concentrate_gormanium = 0.0;
+        concentrate_waste = options.flow_rate_waste;
+    }
+    performance = concentrate_gormanium * options.price_gormanium - concentrate_waste * options.cost_waste;
+    return code;
+}
+
+BulkStats Bulk_Evaluate(istream &in, ostream &out, const BulkOptions &options)
+{
+    BulkStats stats;
+    CircuitReader reader(in, options.binary_input);
+    size_t chunk_size = max(options.chunk_size, 1);
+    if (options.header && !options.binary_output)
+    {
+        out << "valid,performance,concentrate_gormanium,concentrate_waste\n";
+    }
+
+    // two chunks: the next one is read while the current one is evaluated
+    Chunk current, next;
+    string buffer;
+    bool more = reader.Read(current, chunk_size);
+    while (more)
+    {
+        future<bool> reading = async(launch::async, [&reader, &next, chunk_size] { return reader.Read(next, chunk_size); });
+        Evaluate_Chunk(current, options);
+        Write_Chunk(current, out, options, buffer);
+        stats.circuits += current.size();
+        stats.valid += count(current.code.begin(), current.code.end(), 0);
+        more = reading.get();
+        swap(current, next);
+    }
+    out.flush();
+    return stats;
+}
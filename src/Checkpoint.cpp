@@ -0,0 +1,216 @@
+#include "Checkpoint.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace
+{
+    const char MAGIC[4] = {'G', 'A', 'C', 'K'};
+    const uint32_t VERSION = 2;
+    // crossover and mutation rates of Genetic_Optimization
+    const uint32_t NUM_RATES = 4;
+
+    template <typename T>
+    void Write(ofstream &out, T value)
+    {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool Read(ifstream &in, T &value)
+    {
+        return bool(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+    }
+
+    void Write_Genes(ofstream &out, const vector<int> &genes)
+    {
+        vector<uint16_t> packed(genes.begin(), genes.end());
+        out.write(reinterpret_cast<const char *>(packed.data()), packed.size() * sizeof(uint16_t));
+    }
+
+    bool Read_Genes(ifstream &in, vector<int> &genes, size_t length)
+    {
+        vector<uint16_t> packed(length);
+        if (!in.read(reinterpret_cast<char *>(packed.data()), length * sizeof(uint16_t)))
+        {
+            return false;
+        }
+        genes.assign(packed.begin(), packed.end());
+        return true;
+    }
+
+    // the genes of a checkpoint are used as indices into the units, so a damaged file
+    // must not get past the reader, as for the initial circuits of Genetic_Optimization
+    bool Valid_Circuit(const vector<int> &circuit, int num_units)
+    {
+        return circuit[0] < num_units &&
+               all_of(circuit.begin(), circuit.end(), [num_units](int gene) { return gene <= num_units + 1; }) &&
+               utils::Check_Validity(circuit) == 0;
+    }
+}
+
+bool Save_Checkpoint(const string &path, const GeneticCheckpoint &checkpoint)
+{
+    // the standard only gives access to the state of the generator through its text
+    // representation, which is turned back into words to keep the file small
+    vector<uint32_t> rng_state;
+    {
+        stringstream text;
+        text << checkpoint.rng;
+        uint32_t word;
+        while (text >> word)
+        {
+            rng_state.push_back(word);
+        }
+    }
+
+    string temporary = path + ".tmp";
+    {
+        ofstream out(temporary, ios::binary | ios::trunc);
+        if (!out.good())
+        {
+            return false;
+        }
+        int circuit_size = 2 * checkpoint.num_units + 1;
+        out.write(MAGIC, sizeof(MAGIC));
+        Write<uint32_t>(out, VERSION);
+        Write<int32_t>(out, checkpoint.num_units);
+        Write<int32_t>(out, checkpoint.population.size());
+        Write<uint32_t>(out, checkpoint.problem.size());
+        for (double number : checkpoint.problem)
+        {
+            Write<double>(out, number);
+        }
+        Write<int32_t>(out, checkpoint.generation);
+        Write<int32_t>(out, checkpoint.count_for_threshold);
+        Write<double>(out, checkpoint.old_best_performance);
+        Write<uint8_t>(out, checkpoint.finished);
+        Write<uint32_t>(out, checkpoint.adaptive_rate.size());
+        for (double rate : checkpoint.adaptive_rate)
+        {
+            Write<double>(out, rate);
+        }
+        for (const vector<int> &circuit : checkpoint.population)
+        {
+            Write_Genes(out, circuit);
+        }
+        Write<uint8_t>(out, (int)checkpoint.best_circuit.size() == circuit_size);
+        if ((int)checkpoint.best_circuit.size() == circuit_size)
+        {
+            Write_Genes(out, checkpoint.best_circuit);
+        }
+        Write<uint32_t>(out, rng_state.size());
+        out.write(reinterpret_cast<const char *>(rng_state.data()), rng_state.size() * sizeof(uint32_t));
+        // repeated at the end to detect truncated files
+        out.write(MAGIC, sizeof(MAGIC));
+        out.close();
+        if (!out.good())
+        {
+            return false;
+        }
+    }
+    error_code error;
+    filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+bool Load_Checkpoint(
+    const string &path,
+    GeneticCheckpoint &checkpoint,
+    int num_units,
+    int population_size,
+    const vector<double> &problem)
+{
+    ifstream in(path, ios::binary);
+    if (!in.good())
+    {
+        return false;
+    }
+    char magic[4];
+    uint32_t version;
+    if (!in.read(magic, sizeof(magic)) || !equal(magic, magic + 4, MAGIC) ||
+        !Read(in, version) || version != VERSION)
+    {
+        return false;
+    }
+
+    // the sizes of the file must be those of the run before they are used
+    GeneticCheckpoint loaded;
+    int32_t file_units, file_population, generation, count_for_threshold;
+    uint8_t finished, has_best;
+    uint32_t num_numbers, num_rates, num_words;
+    if (!Read(in, file_units) || !Read(in, file_population) || file_units != num_units ||
+        file_population != population_size || !Read(in, num_numbers) || num_numbers != problem.size())
+    {
+        return false;
+    }
+    loaded.problem.resize(num_numbers);
+    for (double &number : loaded.problem)
+    {
+        if (!Read(in, number))
+        {
+            return false;
+        }
+    }
+    if (loaded.problem != problem || !Read(in, generation) || !Read(in, count_for_threshold) ||
+        !Read(in, loaded.old_best_performance) || !Read(in, finished) || !Read(in, num_rates) ||
+        num_rates != NUM_RATES)
+    {
+        return false;
+    }
+    loaded.num_units = num_units;
+    loaded.generation = generation;
+    loaded.count_for_threshold = count_for_threshold;
+    loaded.finished = finished != 0;
+    loaded.adaptive_rate.resize(num_rates);
+    for (double &rate : loaded.adaptive_rate)
+    {
+        if (!Read(in, rate))
+        {
+            return false;
+        }
+    }
+    int circuit_size = 2 * num_units + 1;
+    loaded.population.resize(population_size);
+    for (vector<int> &circuit : loaded.population)
+    {
+        if (!Read_Genes(in, circuit, circuit_size) || !Valid_Circuit(circuit, num_units))
+        {
+            return false;
+        }
+    }
+    if (!Read(in, has_best) ||
+        (has_best && (!Read_Genes(in, loaded.best_circuit, circuit_size) || !Valid_Circuit(loaded.best_circuit, num_units))))
+    {
+        return false;
+    }
+    if (!Read(in, num_words) || num_words > 10000)
+    {
+        return false;
+    }
+    vector<uint32_t> rng_state(num_words);
+    if (!in.read(reinterpret_cast<char *>(rng_state.data()), num_words * sizeof(uint32_t)) ||
+        !in.read(magic, sizeof(magic)) || !equal(magic, magic + 4, MAGIC))
+    {
+        return false;
+    }
+    stringstream text;
+    for (uint32_t word : rng_state)
+    {
+        text << word << ' ';
+    }
+    text >> loaded.rng;
+    if (text.fail())
+    {
+        return false;
+    }
+
+    checkpoint = move(loaded);
+    return true;
+}
@@ -0,0 +1,310 @@
+#include "Config.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+    string Trim(const string &text)
+    {
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if (first == string::npos)
+        {
+            return "";
+        }
+        size_t last = text.find_last_not_of(" \t\r\n");
+        return text.substr(first, last - first + 1);
+    }
+
+    double To_Double(const string &key, const string &text)
+    {
+        try
+        {
+            size_t used;
+            double value = stod(text, &used);
+            if (Trim(text.substr(used)).empty())
+            {
+                return value;
+            }
+        }
+        catch (const logic_error &e)
+        {
+        }
+        throw invalid_argument("Bad value for " + key + ": " + text);
+    }
+
+    int To_Int(const string &key, const string &text)
+    {
+        double value = To_Double(key, text);
+        if (value != (int)value)
+        {
+            throw invalid_argument("Bad value for " + key + ": " + text);
+        }
+        return (int)value;
+    }
+
+    bool To_Bool(const string &key, const string &text)
+    {
+        if (text == "true" || text == "1" || text == "yes")
+        {
+            return true;
+        }
+        if (text == "false" || text == "0" || text == "no")
+        {
+            return false;
+        }
+        throw invalid_argument("Bad value for " + key + ": " + text);
+    }
+
+    // comma separated values, each either a number or start:stop:step
+    vector<double> To_List(const string &key, const string &text)
+    {
+        vector<double> values;
+        stringstream items(text);
+        string item;
+        while (getline(items, item, ','))
+        {
+            item = Trim(item);
+            size_t colon = item.find(':');
+            if (colon == string::npos)
+            {
+                values.push_back(To_Double(key, item));
+                continue;
+            }
+            size_t second = item.find(':', colon + 1);
+            if (second == string::npos)
+            {
+                throw invalid_argument("Bad range for " + key + ": " + item);
+            }
+            double start = To_Double(key, item.substr(0, colon));
+            double stop = To_Double(key, item.substr(colon + 1, second - colon - 1));
+            double step = To_Double(key, item.substr(second + 1));
+            if (step <= 0.0 || stop < start)
+            {
+                throw invalid_argument("Bad range for " + key + ": " + item);
+            }
+            // counted rather than accumulated, so that rounding does not lose the last value
+            int count = (int)((stop - start) / step + 1e-9) + 1;
+            for (int k = 0; k < count; k++)
+            {
+                values.push_back(start + k * step);
+            }
+        }
+        if (values.empty())
+        {
+            throw invalid_argument("No value for " + key);
+        }
+        return values;
+    }
+}
+
+void Set_Config_Value(SolverConfig &config, const string &key, const string &raw_value)
+{
+    string value = Trim(raw_value);
+    GeneticOptions &options = config.options;
+    if (key == "mode")
+    {
+        if (value != "ga" && value != "steady" && value != "pareto" && value != "exhaustive" && value != "sweep" &&
+            value != "serve")
+        {
+            throw invalid_argument("Unknown mode: " + value);
+        }
+        config.mode = value;
+    }
+    else if (key == "population_size")
+        config.population_size = To_Int(key, value);
+    else if (key == "max_iterations")
+        config.max_iterations = To_Int(key, value);
+    else if (key == "threshold")
+        config.threshold = To_Int(key, value);
+    else if (key == "runs")
+        config.runs = To_Int(key, value);
+    else if (key == "num_units")
+    {
+        config.num_units.clear();
+        for (double units : To_List(key, value))
+        {
+            if (units != (int)units || units < 1)
+            {
+                throw invalid_argument("Bad value for " + key + ": " + value);
+            }
+            config.num_units.push_back((int)units);
+        }
+    }
+    else if (key == "flow_rate_gormanium")
+        config.flow_rate_gormanium = To_List(key, value);
+    else if (key == "flow_rate_waste")
+        config.flow_rate_waste = To_List(key, value);
+    else if (key == "price_gormanium")
+        config.price_gormanium = To_List(key, value);
+    else if (key == "cost_waste")
+        config.cost_waste = To_List(key, value);
+    else if (key == "adaptive_rate")
+    {
+        config.adaptive_rate = To_List(key, value);
+        if (config.adaptive_rate.size() != 4)
+        {
+            throw invalid_argument("adaptive_rate needs 4 values: " + value);
+        }
+    }
+    else if (key == "seed")
+        options.seed = To_Int(key, value);
+    else if (key == "selection")
+    {
+        if (value == "roulette")
+            options.selection = SelectionMethod::Roulette;
+        else if (value == "alias")
+            options.selection = SelectionMethod::Alias;
+        else if (value == "sus")
+            options.selection = SelectionMethod::Stochastic_Universal;
+        else if (value == "tournament")
+            options.selection = SelectionMethod::Tournament;
+        else
+            throw invalid_argument("Unknown selection: " + value);
+    }
+    else if (key == "tournament_size")
+        options.tournament_size = To_Int(key, value);
+    else if (key == "local_search_elites")
+        options.local_search_elites = To_Int(key, value);
+    else if (key == "local_search_budget")
+        options.local_search_budget = To_Int(key, value);
+    else if (key == "local_search_pair_swap")
+        options.local_search_pair_swap = To_Bool(key, value);
+    else if (key == "canonical_labels")
+        options.canonical_labels = To_Bool(key, value);
+    else if (key == "fractions_gormanium")
+        options.fractions.gormanium = To_List(key, value);
+    else if (key == "fractions_waste")
+        options.fractions.waste = To_List(key, value);
+    else if (key == "single_precision")
+        options.single_precision = To_Bool(key, value);
+    else if (key == "scenarios")
+        options.robust.scenarios = To_Int(key, value);
+    else if (key == "robust_objective")
+    {
+        if (value == "expected")
+            options.robust.objective = RobustObjective::Expected;
+        else if (value == "worst")
+            options.robust.objective = RobustObjective::Worst_Case;
+        else
+            throw invalid_argument("Unknown robust objective: " + value);
+    }
+    else if (key == "feed_spread")
+        options.robust.feed_spread = To_Double(key, value);
+    else if (key == "fraction_spread")
+        options.robust.fraction_spread = To_Double(key, value);
+    else if (key == "scenario_seed")
+        options.robust.seed = To_Int(key, value);
+    else if (key == "hall_of_fame_injection")
+        config.hall_of_fame_injection = To_Int(key, value);
+    else if (key == "sensitivity")
+        config.sensitivity = To_Bool(key, value);
+    else if (key == "top_k")
+    {
+        config.top_k = To_Int(key, value);
+        if (config.top_k < 1)
+        {
+            throw invalid_argument("Bad value for " + key + ": " + value);
+        }
+    }
+    else if (key == "warm_start")
+        options.warm_start = To_Double(key, value);
+    else if (key == "checkpoint")
+        config.checkpoint_directory = value;
+    else if (key == "log")
+        options.generation_log = value;
+    else if (key == "archive")
+        config.archive = value;
+    else if (key == "design_index")
+        config.design_index = value;
+    else if (key == "evaluation_database")
+        config.evaluation_database = value;
+    else if (key == "socket")
+        config.socket = value;
+    else if (key == "output")
+        config.output = value;
+    else
+        throw invalid_argument("Unknown parameter: " + key);
+}
+
+void Read_Config_File(const string &path, SolverConfig &config)
+{
+    ifstream in(path);
+    if (!in.good())
+    {
+        throw invalid_argument("Cannot read configuration file " + path);
+    }
+    string line;
+    int number = 0;
+    while (getline(in, line))
+    {
+        number++;
+        line = Trim(line.substr(0, line.find('#')));
+        if (line.empty())
+        {
+            continue;
+        }
+        size_t equals = line.find('=');
+        if (equals == string::npos)
+        {
+            throw invalid_argument(path + ":" + to_string(number) + ": expected key = value");
+        }
+        Set_Config_Value(config, Trim(line.substr(0, equals)), line.substr(equals + 1));
+    }
+}
+
+void Parse_Arguments(int argc, char *argv[], SolverConfig &config)
+{
+    for (int a = 1; a < argc; a++)
+    {
+        string argument = argv[a];
+        if (argument.rfind("--", 0) != 0)
+        {
+            throw invalid_argument("Unexpected argument: " + argument);
+        }
+        string key = argument.substr(2);
+        string value;
+        size_t equals = key.find('=');
+        if (equals != string::npos)
+        {
+            value = key.substr(equals + 1);
+            key = key.substr(0, equals);
+        }
+        else if (a + 1 < argc)
+        {
+            value = argv[++a];
+        }
+        else
+        {
+            throw invalid_argument("No value for " + argument);
+        }
+        if (key == "config")
+        {
+            Read_Config_File(value, config);
+        }
+        else
+        {
+            Set_Config_Value(config, key, value);
+        }
+    }
+}
+
+string Config_Usage(const string &program)
+{
+    return "usage: " + program + " [--config FILE] [--key value ...]\n"
+           "  --mode ga|steady|pareto|exhaustive|sweep|serve\n"
+           "  --population_size N --max_iterations N --threshold N --runs N --seed N\n"
+           "  --num_units LIST --flow_rate_gormanium LIST --flow_rate_waste LIST\n"
+           "  --price_gormanium LIST --cost_waste LIST   (LIST: a,b,c or start:stop:step)\n"
+           "  --adaptive_rate k1,k2,k3,k4 --selection roulette|alias|sus|tournament\n"
+           "  --tournament_size N --local_search_elites N --local_search_budget N\n"
+           "  --local_search_pair_swap BOOL --canonical_labels BOOL --hall_of_fame_injection N\n"
+           "  --fractions_gormanium LIST --fractions_waste LIST   (one per unit)\n"
+           "  --scenarios N --robust_objective expected|worst --feed_spread S --fraction_spread S\n"
+           "  --scenario_seed N --single_precision BOOL\n"
+           "  --sensitivity BOOL --top_k N --warm_start FRACTION --checkpoint DIR --log FILE --archive FILE\n"
+           "  --design_index FILE --evaluation_database FILE --socket PATH --output FILE";
+}
@@ -0,0 +1,284 @@
+#include "Design_Index.h"
+#include "Genetic_Algorithm.h"
+
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+using namespace std;
+
+namespace
+{
+    bool Valid_Ratio(double ratio)
+    {
+        return ratio > 0.0 && isfinite(ratio);
+    }
+
+    bool Same_Ratio(double a, double b)
+    {
+        return abs(a - b) <= 1e-9 * max(abs(a), abs(b));
+    }
+}
+
+DesignIndex::DesignIndex(const string &path, int per_key) : path_{path}, per_key_{max(per_key, 1)}
+{
+    if (path_.empty())
+    {
+        return;
+    }
+    ifstream in(path_);
+    string line;
+    while (getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+        Entry entry{};
+        stringstream fields(line);
+        fields >> entry.num_units >> entry.price_ratio >> entry.feed_ratio >> entry.relative_performance;
+        int gene;
+        while (fields >> gene)
+        {
+            entry.circuit.push_back(gene);
+        }
+        // skip damaged lines
+        if (!fields.fail() || fields.eof())
+        {
+            if ((int)entry.circuit.size() == 2 * entry.num_units + 1)
+            {
+                entries_.push_back(entry);
+            }
+        }
+    }
+}
+
+DesignIndex::~DesignIndex()
+{
+    if (modified_)
+    {
+        Save();
+    }
+}
+
+void DesignIndex::Add(const vector<int> &circuit,
+                      double performance,
+                      double flow_rate_gormanium,
+                      double flow_rate_waste,
+                      double price_gormanium,
+                      double cost_waste)
+{
+    Entry entry{(int)(circuit.size() - 1) / 2,
+                price_gormanium / cost_waste,
+                flow_rate_gormanium / flow_rate_waste,
+                performance / (cost_waste * flow_rate_waste),
+                circuit};
+    if (circuit.size() % 2 == 0 || !Valid_Ratio(entry.price_ratio) || !Valid_Ratio(entry.feed_ratio))
+    {
+        return;
+    }
+
+    lock_guard<mutex> guard(lock_);
+    // the circuits already stored for the problem, and the worst of them
+    int stored = 0;
+    int worst = -1;
+    for (size_t i = 0; i < entries_.size(); i++)
+    {
+        Entry &other = entries_[i];
+        if (other.num_units != entry.num_units ||
+            !Same_Ratio(other.price_ratio, entry.price_ratio) ||
+            !Same_Ratio(other.feed_ratio, entry.feed_ratio))
+        {
+            continue;
+        }
+        if (other.circuit == circuit)
+        {
+            return;
+        }
+        stored++;
+        if (worst < 0 || other.relative_performance < entries_[worst].relative_performance)
+        {
+            worst = i;
+        }
+    }
+    if (stored < per_key_)
+    {
+        entries_.push_back(entry);
+    }
+    else if (entries_[worst].relative_performance < entry.relative_performance)
+    {
+        entries_[worst] = entry;
+    }
+    else
+    {
+        return;
+    }
+    modified_ = true;
+}
+
+vector<vector<int>> DesignIndex::Nearest(int num_units,
+                                         double flow_rate_gormanium,
+                                         double flow_rate_waste,
+                                         double price_gormanium,
+                                         double cost_waste,
+                                         int count) const
+{
+    double price_ratio = price_gormanium / cost_waste;
+    double feed_ratio = flow_rate_gormanium / flow_rate_waste;
+    vector<vector<int>> circuits;
+    if (!Valid_Ratio(price_ratio) || !Valid_Ratio(feed_ratio))
+    {
+        return circuits;
+    }
+
+    lock_guard<mutex> guard(lock_);
+    // distance between problems on a log scale, as the ratios span orders of magnitude
+    vector<pair<pair<double, double>, const Entry *>> candidates;
+    for (const Entry &entry : entries_)
+    {
+        if (entry.num_units == num_units)
+        {
+            double distance = abs(log(entry.price_ratio / price_ratio)) + abs(log(entry.feed_ratio / feed_ratio));
+            candidates.push_back({{distance, -entry.relative_performance}, &entry});
+        }
+    }
+    sort(candidates.begin(), candidates.end(),
+         [](const pair<pair<double, double>, const Entry *> &a, const pair<pair<double, double>, const Entry *> &b) {
+             return a.first < b.first;
+         });
+    set<vector<int>> seen;
+    for (size_t i = 0; i < candidates.size() && (int)circuits.size() < count; i++)
+    {
+        if (seen.insert(candidates[i].second->circuit).second)
+        {
+            circuits.push_back(candidates[i].second->circuit);
+        }
+    }
+    return circuits;
+}
+
+bool DesignIndex::Save()
+{
+    if (path_.empty())
+    {
+        return true;
+    }
+    lock_guard<mutex> guard(lock_);
+    // written next to the index then renamed, so a crash never leaves half an index
+    string temporary = path_ + ".tmp";
+    {
+        ofstream out(temporary);
+        out.precision(17);
+        out << "# num_units price_ratio feed_ratio relative_performance circuit\n";
+        for (const Entry &entry : entries_)
+        {
+            out << entry.num_units << ' ' << entry.price_ratio << ' ' << entry.feed_ratio << ' '
+                << entry.relative_performance;
+            for (int gene : entry.circuit)
+            {
+                out << ' ' << gene;
+            }
+            out << '\n';
+        }
+        if (!out.good())
+        {
+            return false;
+        }
+    }
+    error_code error;
+    filesystem::rename(temporary, path_, error);
+    if (error)
+    {
+        return false;
+    }
+    modified_ = false;
+    return true;
+}
+
+size_t DesignIndex::size() const
+{
+    lock_guard<mutex> guard(lock_);
+    return entries_.size();
+}
+
+vector<vector<int>> Grow_Circuit(const vector<int> &circuit)
+{
+    int n = (circuit.size() - 1) / 2;
+    // the outputs of the circuit move up by one to make room for unit n
+    vector<int> base(2 * (n + 1) + 1);
+    for (size_t i = 0; i < circuit.size(); i++)
+    {
+        base[i] = circuit[i] >= n ? circuit[i] + 1 : circuit[i];
+    }
+    set<vector<int>> grown;
+    for (int stream = 0; stream < 2 * n + 1; stream++)
+    {
+        int destination = base[stream];
+        vector<int> candidate(base);
+        candidate[stream] = n;
+        for (int other = 0; other <= n + 2; other++)
+        {
+            // the new unit as a cleaner (its concentrate continues) or as a scavenger
+            for (int side = 0; side < 2; side++)
+            {
+                candidate[2 * n + 1 + side] = destination;
+                candidate[2 * n + 2 - side] = other;
+                if (utils::Check_Validity(candidate) == 0)
+                {
+                    grown.insert(candidate);
+                }
+            }
+        }
+    }
+    return vector<vector<int>>(grown.begin(), grown.end());
+}
+
+vector<vector<int>> Warm_Start_Circuits(const DesignIndex &index,
+                                        int count,
+                                        int num_units,
+                                        double flow_rate_gormanium,
+                                        double flow_rate_waste,
+                                        double price_gormanium,
+                                        double cost_waste)
+{
+    if (count <= 0)
+    {
+        return {};
+    }
+    set<vector<int>> candidates;
+    for (const vector<int> &circuit : index.Nearest(num_units, flow_rate_gormanium, flow_rate_waste, price_gormanium, cost_waste, count))
+    {
+        candidates.insert(circuit);
+    }
+    if (num_units > 1)
+    {
+        for (const vector<int> &smaller : index.Nearest(num_units - 1, flow_rate_gormanium, flow_rate_waste, price_gormanium, cost_waste, count))
+        {
+            for (const vector<int> &circuit : Grow_Circuit(smaller))
+            {
+                candidates.insert(circuit);
+            }
+        }
+    }
+    if (candidates.empty())
+    {
+        return {};
+    }
+
+    // rank them all for this problem, as one batch
+    vector<vector<int>> circuits(candidates.begin(), candidates.end());
+    PopulationFlows flows;
+    vector<double> performance;
+    Evaluate_Population_Flows(circuits, flows, 1e-4, 1000, flow_rate_gormanium, flow_rate_waste);
+    Reprice_Population(flows, vector<double>{price_gormanium}, vector<double>{cost_waste}, performance);
+    vector<int> order(circuits.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&performance](int a, int b) { return performance[a] > performance[b]; });
+    vector<vector<int>> best;
+    for (size_t k = 0; k < order.size() && (int)best.size() < count; k++)
+    {
+        best.push_back(circuits[order[k]]);
+    }
+    return best;
+}
@@ -0,0 +1,347 @@
+#include "Evaluation_Database.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    const char MAGIC[8] = {'G', 'A', 'L', 'E', 'N', 'A', 'D', 'B'};
+    const uint32_t VERSION = 1;
+    const size_t HEADER_SIZE = EvaluationDatabase::HEADER_SIZE;
+    // positions in the header
+    const size_t CAPACITY_OFFSET = 24;
+    const size_t COUNT_OFFSET = 32;
+    const size_t TOLERANCE_OFFSET = 40;
+    // positions in a slot: tag, key (feed rates and fractions), flows, converged, gene
+    const size_t KEY_OFFSET = 8;
+    const size_t FLOWS_OFFSET = 40;
+    const size_t CONVERGED_OFFSET = 72;
+    const size_t GENE_OFFSET = 74;
+    // tag of a slot being written, published tags have their top bit set
+    const uint64_t BUSY = 1;
+
+    static_assert(sizeof(atomic<uint64_t>) == 8 && atomic<uint64_t>::is_always_lock_free,
+                  "the tags are shared between processes as plain 64-bit words");
+
+    size_t Slot_Size(int num_units)
+    {
+        size_t size = GENE_OFFSET + 2 * (2 * num_units + 1);
+        return (size + 7) / 8 * 8;
+    }
+
+    template <typename T>
+    void Put(char *data, size_t offset, T value)
+    {
+        memcpy(data + offset, &value, sizeof(T));
+    }
+
+    template <typename T>
+    T Get(const char *data, size_t offset)
+    {
+        T value;
+        memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    void Make_Header(char *header, int num_units, uint64_t capacity, double tolerance, int max_iterations)
+    {
+        memset(header, 0, HEADER_SIZE);
+        memcpy(header, MAGIC, sizeof(MAGIC));
+        Put<uint32_t>(header, 8, VERSION);
+        Put<uint32_t>(header, 12, num_units);
+        Put<uint32_t>(header, 16, Slot_Size(num_units));
+        Put<uint32_t>(header, 20, max_iterations);
+        Put<uint64_t>(header, CAPACITY_OFFSET, capacity);
+        Put<uint64_t>(header, COUNT_OFFSET, 0);
+        Put<double>(header, TOLERANCE_OFFSET, tolerance);
+    }
+
+    bool Check_Header(const char *header, int num_units, double tolerance, int max_iterations)
+    {
+        uint64_t capacity = Get<uint64_t>(header, CAPACITY_OFFSET);
+        return memcmp(header, MAGIC, sizeof(MAGIC)) == 0 &&
+               Get<uint32_t>(header, 8) == VERSION &&
+               (int)Get<uint32_t>(header, 12) == num_units &&
+               Get<uint32_t>(header, 16) == Slot_Size(num_units) &&
+               (int)Get<uint32_t>(header, 20) == max_iterations &&
+               Get<double>(header, TOLERANCE_OFFSET) == tolerance &&
+               capacity > 0 && (capacity & (capacity - 1)) == 0;
+    }
+}
+
+EvaluationDatabase::EvaluationDatabase(const string &path, int num_units, uint64_t capacity, double tolerance, int max_iterations)
+    : num_units_{num_units},
+      tolerance_{tolerance},
+      max_iterations_{max_iterations},
+      slot_size_{Slot_Size(num_units)}
+{
+    uint64_t new_capacity = 1;
+    while (new_capacity < capacity)
+    {
+        new_capacity <<= 1;
+    }
+    char header[HEADER_SIZE];
+
+    // whoever opens the file first creates the table, the others wait for it
+#ifdef _WIN32
+    file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_ == INVALID_HANDLE_VALUE)
+    {
+        file_ = nullptr;
+        throw BadEvaluationDatabase();
+    }
+    OVERLAPPED whole_file{};
+    LockFileEx(file_, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &whole_file);
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file_, &file_size);
+    DWORD done = 0;
+    bool good;
+    if (file_size.QuadPart == 0)
+    {
+        Make_Header(header, num_units, new_capacity, tolerance, max_iterations);
+        LARGE_INTEGER end;
+        end.QuadPart = HEADER_SIZE + new_capacity * slot_size_;
+        good = WriteFile(file_, header, HEADER_SIZE, &done, NULL) && done == HEADER_SIZE &&
+               SetFilePointerEx(file_, end, NULL, FILE_BEGIN) && SetEndOfFile(file_);
+    }
+    else
+    {
+        good = ReadFile(file_, header, HEADER_SIZE, &done, NULL) && done == HEADER_SIZE;
+    }
+    UnlockFileEx(file_, 0, MAXDWORD, MAXDWORD, &whole_file);
+    if (!good || !Check_Header(header, num_units, tolerance, max_iterations))
+    {
+        Close();
+        throw BadEvaluationDatabase();
+    }
+    capacity_ = Get<uint64_t>(header, CAPACITY_OFFSET);
+    length_ = HEADER_SIZE + capacity_ * slot_size_;
+    mapping_ = CreateFileMappingA(file_, NULL, PAGE_READWRITE, 0, 0, NULL);
+    if (mapping_ != nullptr)
+    {
+        data_ = static_cast<char *>(MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, length_));
+    }
+#else
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        throw BadEvaluationDatabase();
+    }
+    flock(fd, LOCK_EX);
+    struct stat status;
+    bool good = fstat(fd, &status) == 0;
+    if (good && status.st_size == 0)
+    {
+        Make_Header(header, num_units, new_capacity, tolerance, max_iterations);
+        good = pwrite(fd, header, HEADER_SIZE, 0) == (ssize_t)HEADER_SIZE &&
+               ftruncate(fd, HEADER_SIZE + new_capacity * slot_size_) == 0;
+    }
+    else if (good)
+    {
+        good = pread(fd, header, HEADER_SIZE, 0) == (ssize_t)HEADER_SIZE;
+    }
+    flock(fd, LOCK_UN);
+    if (good && Check_Header(header, num_units, tolerance, max_iterations))
+    {
+        capacity_ = Get<uint64_t>(header, CAPACITY_OFFSET);
+        length_ = HEADER_SIZE + capacity_ * slot_size_;
+        void *mapped = mmap(nullptr, length_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED)
+        {
+            data_ = static_cast<char *>(mapped);
+        }
+    }
+    // the mapping keeps the file open
+    close(fd);
+#endif
+    if (data_ == nullptr)
+    {
+        Close();
+        throw BadEvaluationDatabase();
+    }
+}
+
+EvaluationDatabase::~EvaluationDatabase()
+{
+    Close();
+}
+
+void EvaluationDatabase::Close()
+{
+#ifdef _WIN32
+    if (data_ != nullptr)
+    {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr)
+    {
+        CloseHandle(mapping_);
+    }
+    if (file_ != nullptr)
+    {
+        CloseHandle(file_);
+    }
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (data_ != nullptr)
+    {
+        munmap(data_, length_);
+    }
+#endif
+    data_ = nullptr;
+}
+
+atomic<uint64_t> &EvaluationDatabase::Tag(uint64_t slot) const
+{
+    return *reinterpret_cast<atomic<uint64_t> *>(data_ + HEADER_SIZE + slot * slot_size_);
+}
+
+atomic<uint64_t> &EvaluationDatabase::Count() const
+{
+    return *reinterpret_cast<atomic<uint64_t> *>(data_ + COUNT_OFFSET);
+}
+
+uint64_t EvaluationDatabase::Hash(const vector<int> &circuit, const double key[4]) const
+{
+    // FNV-1a over the gene and the bits of the key, then mixed so that the low bits,
+    // used as the first slot, depend on all of them
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&hash](uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    };
+    for (int gene : circuit)
+    {
+        add(gene);
+    }
+    for (int k = 0; k < 4; k++)
+    {
+        uint64_t bits;
+        memcpy(&bits, &key[k], sizeof(bits));
+        add(bits);
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+bool EvaluationDatabase::Matches(const char *slot, const vector<int> &circuit, const double key[4]) const
+{
+    if (memcmp(slot + KEY_OFFSET, key, 4 * sizeof(double)) != 0)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < circuit.size(); i++)
+    {
+        if (Get<uint16_t>(slot, GENE_OFFSET + 2 * i) != circuit[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EvaluationDatabase::Lookup(const vector<int> &circuit,
+                                double input_gormanium,
+                                double input_waste,
+                                double fraction_gormanium,
+                                double fraction_waste,
+                                CircuitFlows &flows) const
+{
+    if ((int)circuit.size() != 2 * num_units_ + 1)
+    {
+        misses_.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    const double key[4] = {input_gormanium, input_waste, fraction_gormanium, fraction_waste};
+    uint64_t hash = Hash(circuit, key);
+    uint64_t tag = hash | (1ULL << 63);
+    for (uint64_t probe = 0; probe < capacity_; probe++)
+    {
+        uint64_t slot = (hash + probe) & (capacity_ - 1);
+        uint64_t found = Tag(slot).load(memory_order_acquire);
+        if (found == 0)
+        {
+            // slots are filled in probe order and never emptied
+            break;
+        }
+        const char *data = data_ + HEADER_SIZE + slot * slot_size_;
+        if (found == tag && Matches(data, circuit, key))
+        {
+            flows.conc_gormanium = Get<double>(data, FLOWS_OFFSET);
+            flows.conc_waste = Get<double>(data, FLOWS_OFFSET + 8);
+            flows.tail_gormanium = Get<double>(data, FLOWS_OFFSET + 16);
+            flows.tail_waste = Get<double>(data, FLOWS_OFFSET + 24);
+            flows.converged = Get<uint16_t>(data, CONVERGED_OFFSET) != 0;
+            hits_.fetch_add(1, memory_order_relaxed);
+            return true;
+        }
+    }
+    misses_.fetch_add(1, memory_order_relaxed);
+    return false;
+}
+
+bool EvaluationDatabase::Insert(const vector<int> &circuit,
+                                double input_gormanium,
+                                double input_waste,
+                                double fraction_gormanium,
+                                double fraction_waste,
+                                const CircuitFlows &flows)
+{
+    if ((int)circuit.size() != 2 * num_units_ + 1 ||
+        Count().load(memory_order_relaxed) >= capacity_ / 4 * 3)
+    {
+        return false;
+    }
+    const double key[4] = {input_gormanium, input_waste, fraction_gormanium, fraction_waste};
+    uint64_t hash = Hash(circuit, key);
+    uint64_t tag = hash | (1ULL << 63);
+    for (uint64_t probe = 0; probe < capacity_; probe++)
+    {
+        uint64_t slot = (hash + probe) & (capacity_ - 1);
+        uint64_t found = Tag(slot).load(memory_order_acquire);
+        if (found == 0 && Tag(slot).compare_exchange_strong(found, BUSY, memory_order_acq_rel))
+        {
+            // claimed: fill it, then publish it
+            char *data = data_ + HEADER_SIZE + slot * slot_size_;
+            memcpy(data + KEY_OFFSET, key, sizeof(key));
+            Put<double>(data, FLOWS_OFFSET, flows.conc_gormanium);
+            Put<double>(data, FLOWS_OFFSET + 8, flows.conc_waste);
+            Put<double>(data, FLOWS_OFFSET + 16, flows.tail_gormanium);
+            Put<double>(data, FLOWS_OFFSET + 24, flows.tail_waste);
+            Put<uint16_t>(data, CONVERGED_OFFSET, flows.converged ? 1 : 0);
+            for (size_t i = 0; i < circuit.size(); i++)
+            {
+                Put<uint16_t>(data, GENE_OFFSET + 2 * i, circuit[i]);
+            }
+            Tag(slot).store(tag, memory_order_release);
+            Count().fetch_add(1, memory_order_relaxed);
+            return true;
+        }
+        // a slot still being written may hold the same circuit, which at worst is stored twice
+        if (found == tag && Matches(data_ + HEADER_SIZE + slot * slot_size_, circuit, key))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t EvaluationDatabase::size() const
+{
+    return Count().load(memory_order_relaxed);
+}
@@ -0,0 +1,189 @@
+#include "Exhaustive_Search.h"
+#include "utils.h"
+
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace
+{
+    // a circuit and its performance, ordered best first
+    typedef pair<double, vector<int>> Candidate;
+
+    bool Better(const Candidate &a, const Candidate &b)
+    {
+        if (a.first != b.first)
+        {
+            return a.first > b.first;
+        }
+        return a.second < b.second;
+    }
+
+    // state shared by the recursion of a single thread
+    struct Enumerator
+    {
+        int num_units;
+        int top_k;
+        double flow_rate_gormanium;
+        double flow_rate_waste;
+        double price_gormanium;
+        double cost_waste;
+        vector<int> gene;
+        // heap of the best circuits found so far, worst on top
+        vector<Candidate> top;
+        long long evaluated{0};
+
+        void Evaluate()
+        {
+            if (utils::Check_Validity(gene) != 0)
+            {
+                return;
+            }
+            double performance = Evaluate_Circuit(
+                gene,
+                false,
+                0,
+                1e-4,
+                1000,
+                price_gormanium,
+                cost_waste,
+                flow_rate_gormanium,
+                flow_rate_waste);
+            evaluated++;
+            if ((int)top.size() < top_k)
+            {
+                top.push_back(Candidate(performance, gene));
+                push_heap(top.begin(), top.end(), Better);
+            }
+            else if (Better(Candidate(performance, gene), top.front()))
+            {
+                pop_heap(top.begin(), top.end(), Better);
+                top.back() = Candidate(performance, gene);
+                push_heap(top.begin(), top.end(), Better);
+            }
+        }
+
+        // fill gene position `slot` (1 to 2 * num_units), `next_label` being the
+        // first label not yet discovered
+        void Recurse(int slot, int next_label)
+        {
+            if (slot == 2 * num_units + 1)
+            {
+                Evaluate();
+                return;
+            }
+            int unit = (slot - 1) / 2;
+            // a unit must have been discovered by the time its own pipes are decided
+            if (unit >= next_label)
+            {
+                return;
+            }
+            // every undiscovered unit needs one of the remaining pipes
+            if (num_units - next_label > 2 * num_units + 1 - slot)
+            {
+                return;
+            }
+            int last = min(next_label, num_units - 1);
+            for (int value = 0; value < num_units + 2; value++)
+            {
+                if (value > last && value < num_units)
+                {
+                    continue;
+                }
+                // no self-recycle, and the tailings can't go where the concentrate goes
+                if (value == unit || (slot % 2 == 0 && value == gene[slot - 1]))
+                {
+                    continue;
+                }
+                gene[slot] = value;
+                Recurse(slot + 1, value == next_label ? next_label + 1 : next_label);
+            }
+        }
+    };
+}
+
+vector<vector<int>> Exhaustive_Optimization(
+    int num_units,
+    int top_k,
+    vector<double> &top_performance,
+    long long &evaluated,
+    double flow_rate_gormanium,
+    double flow_rate_waste,
+    double price_gormanium,
+    double cost_waste)
+{
+    // the top-K lists of the threads are heaps, which need room for a circuit
+    if (top_k < 1)
+    {
+        throw invalid_argument("top_k must be at least 1");
+    }
+    // Step 1. Enumerate the choices for the pipes of the first unit, as well as the
+    // concentrate of the second one, sequentially to create enough independent branches
+    vector<vector<int>> branches;
+    vector<int> labels;
+    int depth = min(3, 2 * num_units);
+    for (int value = 0; value < (int)pow(num_units + 2, depth); value++)
+    {
+        vector<int> gene(2 * num_units + 1, 0);
+        int code = value;
+        int next_label = 1;
+        bool valid = true;
+        for (int slot = 1; slot <= depth; slot++)
+        {
+            int unit = (slot - 1) / 2;
+            gene[slot] = code % (num_units + 2);
+            code /= num_units + 2;
+            if (unit >= next_label || gene[slot] == unit ||
+                (gene[slot] < num_units && gene[slot] > next_label) ||
+                (slot % 2 == 0 && gene[slot] == gene[slot - 1]))
+            {
+                valid = false;
+                break;
+            }
+            if (gene[slot] == next_label)
+            {
+                next_label++;
+            }
+        }
+        if (valid)
+        {
+            branches.push_back(gene);
+            labels.push_back(next_label);
+        }
+    }
+
+    // Step 2. Complete every branch in parallel, each thread with its own top-K list
+    vector<Candidate> top;
+    evaluated = 0;
+#pragma omp parallel
+    {
+        Enumerator enumerator{num_units, top_k, flow_rate_gormanium, flow_rate_waste, price_gormanium, cost_waste};
+#pragma omp for schedule(dynamic)
+        for (int b = 0; b < (int)branches.size(); b++)
+        {
+            enumerator.gene = branches[b];
+            enumerator.Recurse(depth + 1, labels[b]);
+        }
+#pragma omp critical
+        {
+            top.insert(top.end(), enumerator.top.begin(), enumerator.top.end());
+            evaluated += enumerator.evaluated;
+        }
+    }
+
+    // Step 3. Merge the lists of all threads
+    sort(top.begin(), top.end(), Better);
+    if ((int)top.size() > top_k)
+    {
+        top.resize(top_k);
+    }
+    vector<vector<int>> top_circuits;
+    top_performance.clear();
+    for (const Candidate &candidate : top)
+    {
+        top_performance.push_back(candidate.first);
+        top_circuits.push_back(candidate.second);
+    }
+    return top_circuits;
+}
@@ -1,125 +1,173 @@
 #include "Genetic_Algorithm.h"
 #include "utils.h"
 
+#include <stdexcept>
+
 using namespace std;
 
 /* -------------- Circuit Modeling Part----------------*/
-void Evaluate_Flows(
-    vector<double> &new_feed_gormanium,
-    vector<double> &new_feed_waste,
-    const vector<int> &circuit_vector,
-    double tolerance,
-    int max_iterations,
-    double gormanium_price,
-    double waste_cost,
-    double input_gormanium,
-    double input_waste)
+namespace
 {
-    int n = (circuit_vector.size() - 1) / 2;
-    vector<double> feed_waste(n + 2, 0.0);
-    vector<double> feed_gormanium(n + 2, 0.0);
+    // Fractions going to concentrate of the original problem, the same constants for
+    // every unit, so that the compiler folds them into the kernel
+    struct UniformSplit
+    {
+        double gormanium(int unit) const { return FRACTION_GORMANIUM; }
+        double waste(int unit) const { return FRACTION_WASTE; }
+    };
 
-    // Fractions going to concentrate
-    double fraction_gormanium = 0.2;
-    double fraction_waste = 0.05;
+    // Fractions going to concentrate of each unit, read in unit order from the arrays
+    // of UnitFractions
+    struct PerUnitSplit
+    {
+        const double *fraction_gormanium;
+        const double *fraction_waste;
+        double gormanium(int unit) const { return fraction_gormanium[unit]; }
+        double waste(int unit) const { return fraction_waste[unit]; }
+    };
 
-    // This will later be used to check for mass continuity
-    double total_mass = 0.0;
+    template <typename Split>
+    void Flow_Kernel(
+        vector<double> &new_feed_gormanium,
+        vector<double> &new_feed_waste,
+        const vector<int> &circuit_vector,
+        double tolerance,
+        int max_iterations,
+        double input_gormanium,
+        double input_waste,
+        const Split &split)
+    {
+        int n = (circuit_vector.size() - 1) / 2;
+        vector<double> feed_waste(n + 2, 0.0);
+        vector<double> feed_gormanium(n + 2, 0.0);
 
-    // set initial feed rate - entry unit index is given by circuit_vector[0]
-    feed_gormanium[circuit_vector[0]] = input_gormanium;
-    feed_waste[circuit_vector[0]] = input_waste;
+        // This will later be used to check for mass continuity
+        double total_mass = 0.0;
 
-    // Initialise relative error variables and iteration counter
-    double gormanium_error;
-    double waste_error;
-    int it = 0;
+        // set initial feed rate - entry unit index is given by circuit_vector[0]
+        feed_gormanium[circuit_vector[0]] = input_gormanium;
+        feed_waste[circuit_vector[0]] = input_waste;
 
-    while (it < max_iterations)
-    {
-        // New feed vector should be set to 0 at start of every iteration
-        std::fill(new_feed_gormanium.begin(), new_feed_gormanium.end(), 0.0);
-        std::fill(new_feed_waste.begin(), new_feed_waste.end(), 0.0);
+        // Initialise relative error variables and iteration counter
+        double gormanium_error;
+        double waste_error;
+        int it = 0;
 
-        // Update gormanium and waste feeds based on current feeds into each unit
-        for (int i = 0; i < n; i++)
+        while (it < max_iterations)
         {
-            // gormanium to concentrate
-            new_feed_gormanium[circuit_vector[i * 2 + 1]] += feed_gormanium[i] * fraction_gormanium;
-            // waste to concentrate
-            new_feed_waste[circuit_vector[i * 2 + 1]] += feed_waste[i] * fraction_waste;
+            // New feed vector should be set to 0 at start of every iteration
+            std::fill(new_feed_gormanium.begin(), new_feed_gormanium.end(), 0.0);
+            std::fill(new_feed_waste.begin(), new_feed_waste.end(), 0.0);
 
-            // gormanium to tailings
-            new_feed_gormanium[circuit_vector[i * 2 + 2]] += feed_gormanium[i] * (1 - fraction_gormanium);
-            // waste to tailings
-            new_feed_waste[circuit_vector[i * 2 + 2]] += feed_waste[i] * (1 - fraction_waste);
-        }
+            // Update gormanium and waste feeds based on current feeds into each unit
+            for (int i = 0; i < n; i++)
+            {
+                double fraction_gormanium = split.gormanium(i);
+                double fraction_waste = split.waste(i);
+                // gormanium to concentrate
+                new_feed_gormanium[circuit_vector[i * 2 + 1]] += feed_gormanium[i] * fraction_gormanium;
+                // waste to concentrate
+                new_feed_waste[circuit_vector[i * 2 + 1]] += feed_waste[i] * fraction_waste;
 
-        // this is true if any difference between previous and current waste or
-        // gormanium feed arrays exceeds our given tolerance
-        bool exceeds_tolerance = false;
+                // gormanium to tailings
+                new_feed_gormanium[circuit_vector[i * 2 + 2]] += feed_gormanium[i] * (1 - fraction_gormanium);
+                // waste to tailings
+                new_feed_waste[circuit_vector[i * 2 + 2]] += feed_waste[i] * (1 - fraction_waste);
+            }
 
-        // Feed mass into the overall circuit
-        new_feed_gormanium[circuit_vector[0]] += input_gormanium;
-        new_feed_waste[circuit_vector[0]] += input_waste;
+            // this is true if any difference between previous and current waste or
+            // gormanium feed arrays exceeds our given tolerance
+            bool exceeds_tolerance = false;
 
-        for (int i = 0; i < n; i++)
-        {
-            // Calculate relative errors in gormanium and waste feed vectors with respect to previous iteration
-            gormanium_error = std::abs(new_feed_gormanium[i] - feed_gormanium[i]) / feed_gormanium[i];
-            waste_error = std::abs(new_feed_waste[i] - feed_waste[i]) / feed_waste[i];
+            // Feed mass into the overall circuit
+            new_feed_gormanium[circuit_vector[0]] += input_gormanium;
+            new_feed_waste[circuit_vector[0]] += input_waste;
 
-            // As soon as any value exceeds the tolerance, proceed to the next iteration in the circuit
-            if (gormanium_error > tolerance || waste_error > tolerance)
+            for (int i = 0; i < n; i++)
+            {
+                // Calculate relative errors in gormanium and waste feed vectors with respect to previous iteration
+                gormanium_error = std::abs(new_feed_gormanium[i] - feed_gormanium[i]) / feed_gormanium[i];
+                waste_error = std::abs(new_feed_waste[i] - feed_waste[i]) / feed_waste[i];
+
+                // As soon as any value exceeds the tolerance, proceed to the next iteration in the circuit
+                if (gormanium_error > tolerance || waste_error > tolerance)
+                {
+                    exceeds_tolerance = true;
+                    break;
+                }
+            }
+
+            // this means we've reached steady state and can calculate the performance
+            if (exceeds_tolerance == false)
             {
-                exceeds_tolerance = true;
                 break;
             }
-        }
 
-        // this means we've reached steady state and can calculate the performance
-        if (exceeds_tolerance == false)
+            // Update feed vectors for next iteration
+            for (int i = 0; i < n + 2; i++)
+            {
+                feed_gormanium[i] = new_feed_gormanium[i];
+                feed_waste[i] = new_feed_waste[i];
+            }
+
+            // Store destination tailing and concentrate
+            total_mass += new_feed_gormanium[n] + new_feed_gormanium[n + 1] + new_feed_waste[n] + new_feed_waste[n + 1];
+
+            // Take destination mass out of the circuit (i.e. set to 0)
+            feed_gormanium[n] = 0.0;
+            feed_gormanium[n + 1] = 0.0;
+            feed_waste[n] = 0.0;
+            feed_waste[n + 1] = 0.0;
+
+            // increment iteration count
+            it++;
+        }
+        // check for mass continuity
+        for (int i = 0; i < n; i++)
         {
-            break;
+            total_mass += new_feed_gormanium[i];
+            total_mass += new_feed_waste[i];
         }
 
-        // Update feed vectors for next iteration
-        for (int i = 0; i < n + 2; i++)
+        // Print message and return negative performance if the algorithm does not converge
+        if (it == max_iterations)
         {
-            feed_gormanium[i] = new_feed_gormanium[i];
-            feed_waste[i] = new_feed_waste[i];
+            throw 1;
         }
 
-        // Store destination tailing and concentrate
-        total_mass += new_feed_gormanium[n] + new_feed_gormanium[n + 1] + new_feed_waste[n] + new_feed_waste[n + 1];
-
-        // Take destination mass out of the circuit (i.e. set to 0)
-        feed_gormanium[n] = 0.0;
-        feed_gormanium[n + 1] = 0.0;
-        feed_waste[n] = 0.0;
-        feed_waste[n + 1] = 0.0;
+        // Total mass in the circuit should be equal to the mass fed into it
+        double sum_check = (it + 1) * (input_gormanium + input_waste);
 
-        // increment iteration count
-        it++;
+        if (std::abs(total_mass - sum_check) / sum_check > 1e-4)
+            throw 2;
     }
-    // check for mass continuity
-    for (int i = 0; i < n; i++)
+}
+
+void Evaluate_Flows(
+    vector<double> &new_feed_gormanium,
+    vector<double> &new_feed_waste,
+    const vector<int> &circuit_vector,
+    double tolerance,
+    int max_iterations,
+    double gormanium_price,
+    double waste_cost,
+    double input_gormanium,
+    double input_waste,
+    const UnitFractions &fractions)
+{
+    int n = (circuit_vector.size() - 1) / 2;
+    if (fractions.uniform())
     {
-        total_mass += new_feed_gormanium[i];
-        total_mass += new_feed_waste[i];
+        Flow_Kernel(new_feed_gormanium, new_feed_waste, circuit_vector, tolerance, max_iterations,
+                    input_gormanium, input_waste, UniformSplit());
+        return;
     }
-
-    // Print message and return negative performance if the algorithm does not converge
-    if (it == max_iterations)
+    if (!fractions.valid(n))
     {
-        throw 1;
+        throw invalid_argument("the concentrate fractions are not valid for a circuit of " + to_string(n) + " units");
     }
-
-    // Total mass in the circuit should be equal to the mass fed into it
-    double sum_check = (it + 1) * (input_gormanium + input_waste);
-
-    if (std::abs(total_mass - sum_check) / sum_check > 1e-4)
-        throw 2;
+    Flow_Kernel(new_feed_gormanium, new_feed_waste, circuit_vector, tolerance, max_iterations,
+                input_gormanium, input_waste, PerUnitSplit{fractions.gormanium.data(), fractions.waste.data()});
 }
 
 double Evaluate_Circuit(
@@ -131,7 +179,8 @@ double Evaluate_Circuit(
     double gormanium_price,
     double waste_cost,
     double input_gormanium,
-    double input_waste)
+    double input_waste,
+    const UnitFractions &fractions)
 {
     // Initialise vectors of gormanium and waste feeds into units. We use n+2
     // to account for the destinations of the final concentrate and tailings
@@ -151,7 +200,8 @@ double Evaluate_Circuit(
             gormanium_price,
             waste_cost,
             input_gormanium,
-            input_waste);
+            input_waste,
+            fractions);
     }
     catch (const int error_code)
     {
@@ -180,16 +230,176 @@ double Evaluate_Circuit(
 
         // as this this should only be used in the main executable,
         // only need to go up one level to reach `data/`
-        std::string data_dir = utils::Get_Exe_Path() + utils::File_Sep() +
+        static const std::string data_dir = utils::Get_Exe_Path() + utils::File_Sep() +
             ".." + utils::File_Sep() + "data";
-        utils::Print_Circuit_To_File(data_dir, circuit_vector,
+        // written by the background writer, the calling thread only copies the vectors
+        Output_Writer().Write_Circuit(data_dir, circuit_vector,
             new_feed_gormanium, new_feed_waste,
-            current_it, performance);
+            current_it, performance, fractions);
     }
 
     return performance;
 }
 
+void Evaluate_Population_Flows(
+    const vector<vector<int>> &population,
+    PopulationFlows &flows,
+    double tolerance,
+    int max_iterations,
+    double input_gormanium,
+    double input_waste,
+    EvaluationDatabase *database,
+    const UnitFractions &fractions)
+{
+    int size = population.size();
+    flows.conc_gormanium.assign(size, 0.0);
+    flows.conc_waste.assign(size, 0.0);
+    flows.converged.assign(size, 0);
+    if (database != nullptr && (database->tolerance() != tolerance || database->max_iterations() != max_iterations ||
+                                !fractions.uniform()))
+    {
+        database = nullptr;
+    }
+
+    utils::Parallel_For(0, size, [&](int i) {
+        CircuitFlows stored;
+        if (database != nullptr &&
+            database->Lookup(population[i], input_gormanium, input_waste, FRACTION_GORMANIUM, FRACTION_WASTE, stored))
+        {
+            flows.conc_gormanium[i] = stored.conc_gormanium;
+            flows.conc_waste[i] = stored.conc_waste;
+            flows.converged[i] = stored.converged;
+            return;
+        }
+        int n = (population[i].size() - 1) / 2;
+        vector<double> new_feed_gormanium(n + 2);
+        vector<double> new_feed_waste(n + 2);
+        try
+        {
+            Evaluate_Flows(
+                new_feed_gormanium,
+                new_feed_waste,
+                population[i],
+                tolerance,
+                max_iterations,
+                0.0,
+                0.0,
+                input_gormanium,
+                input_waste,
+                fractions);
+            flows.conc_gormanium[i] = new_feed_gormanium[n];
+            flows.conc_waste[i] = new_feed_waste[n];
+            flows.converged[i] = 1;
+            stored = {new_feed_gormanium[n], new_feed_waste[n], new_feed_gormanium[n + 1], new_feed_waste[n + 1], true};
+        }
+        catch (const int error_code)
+        {
+            if (error_code == 1)
+            {
+                // no gormanium and all the waste in the concentrate gives
+                // the same penalty as Evaluate_Circuit for any cost of waste
+                flows.conc_gormanium[i] = 0.0;
+                flows.conc_waste[i] = input_waste;
+                stored = {0.0, input_waste, 0.0, 0.0, false};
+            }
+            else
+            {
+                throw "Mass continuity FAILED!";
+            }
+        }
+        if (database != nullptr)
+        {
+            database->Insert(population[i], input_gormanium, input_waste, FRACTION_GORMANIUM, FRACTION_WASTE, stored);
+        }
+    }, 4);
+}
+
+void Reprice_Population(
+    const PopulationFlows &flows,
+    const vector<double> &gormanium_prices,
+    const vector<double> &waste_costs,
+    vector<double> &performance)
+{
+    int size = flows.conc_gormanium.size();
+    int num_scenarios = gormanium_prices.size();
+    performance.resize(size * num_scenarios);
+
+    const double *gormanium = flows.conc_gormanium.data();
+    const double *waste = flows.conc_waste.data();
+    for (int s = 0; s < num_scenarios; s++)
+    {
+        double price = gormanium_prices[s];
+        double cost = waste_costs[s];
+        double *out = performance.data() + s * size;
+        // branch free so that the compiler can vectorise the inner loop
+#pragma omp simd
+        for (int i = 0; i < size; i++)
+        {
+            out[i] = gormanium[i] * price - waste[i] * cost;
+        }
+    }
+}
+
+double Screening_Margin(
+    double tolerance,
+    double price_gormanium,
+    double cost_waste,
+    double flow_rate_gormanium,
+    double flow_rate_waste)
+{
+    return 10 * tolerance * (price_gormanium * flow_rate_gormanium + cost_waste * flow_rate_waste);
+}
+
+vector<int> Refinement_Candidates(const vector<double> &performance, int elites, double margin)
+{
+    vector<int> order(performance.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&performance](int a, int b) { return performance[a] > performance[b]; });
+    int count = 0;
+    while (count < (int)order.size() &&
+           (count < elites || performance[order[count]] >= performance[order[0]] - margin))
+    {
+        count++;
+    }
+    order.resize(count);
+    return order;
+}
+
+int Screen_Robust_Population(
+    const vector<vector<int>> &population,
+    const ScenarioSet &scenarios,
+    double price_gormanium,
+    double cost_waste,
+    RobustObjective objective,
+    vector<double> &performance,
+    double margin)
+{
+    Robust_Population_Performance(population, scenarios, price_gormanium, cost_waste, objective, performance, true);
+    vector<char> refined(population.size(), 0);
+    int count = 0;
+    while (true)
+    {
+        vector<int> candidates;
+        for (int k : Refinement_Candidates(performance, 0, margin))
+        {
+            if (!refined[k])
+            {
+                candidates.push_back(k);
+            }
+        }
+        if (candidates.empty())
+        {
+            return count;
+        }
+        utils::Parallel_For(0, candidates.size(), [&](int c) {
+            int k = candidates[c];
+            performance[k] = Robust_Performance(population[k], scenarios, price_gormanium, cost_waste, objective);
+            refined[k] = 1;
+        });
+        count += candidates.size();
+    }
+}
+
 /* -------------- Genetic Algorithm Part----------------*/
 
 // random initial function
@@ -222,6 +432,34 @@ void Generate_Initial(int population_size, vector<vector<int>> &parents, int num
     return;
 }
 
+void Generate_Initial(int population_size, vector<vector<int>> &parents, int num_units, mt19937 &rng)
+{
+    uniform_int_distribution<int> destination(0, num_units + 1);
+    parents.reserve(population_size);
+    while ((int)parents.size() < population_size)
+    {
+        vector<int> circuit_vector;
+        circuit_vector.reserve(2 * num_units + 1);
+        circuit_vector.push_back(0);
+        for (int j = 0; j < num_units * 2; j++)
+        {
+            if (j < num_units + 1)
+            {
+                circuit_vector.push_back(j + 1);
+            }
+            else
+            {
+                circuit_vector.push_back(destination(rng));
+            }
+        }
+        shuffle(circuit_vector.begin() + 1, circuit_vector.end(), rng);
+        if (utils::Check_Validity(circuit_vector) == 0)
+        {
+            parents.push_back(circuit_vector);
+        }
+    }
+}
+
 void Performance(
     int population_size,
     const vector<vector<int>> &parents,
@@ -229,14 +467,16 @@ void Performance(
     double flow_rate_gormanium,
     double flow_rate_waste,
     double price_gormanium,
-    double cost_waste
+    double cost_waste,
+    const UnitFractions &fractions
 )
 {
-    for (int i = 0; i < parents.size(); i++)
-    {
-        vector<int> temp = parents[i];
-        double r = Evaluate_Circuit(
-            temp,
+    // the circuits are evaluated in parallel, and appended in order
+    int offset = performance.size();
+    performance.resize(offset + parents.size());
+    utils::Parallel_For(0, parents.size(), [&](int i) {
+        performance[offset + i] = Evaluate_Circuit(
+            parents[i],
             false,
             0,
             1e-4,
@@ -244,10 +484,10 @@ void Performance(
             price_gormanium,
             cost_waste,
             flow_rate_gormanium,
-            flow_rate_waste
+            flow_rate_waste,
+            fractions
         );
-        performance.push_back(r);
-    }
+    }, 4);
     return;
 }
 
@@ -261,21 +501,6 @@ void Fitness(int population_size, vector<double> &performance, vector<double> &f
     return;
 }
 
-void Probability(int population_size, const vector<double> &fitness, vector<double> &probability)
-{
-    double sum = accumulate(fitness.begin(), fitness.end(), 0);
-    double pro = 0.0;
-
-    // Roulette method
-    for (int i = 0; i < population_size; i++)
-    {
-        pro += ((fitness[i]) / sum);
-        probability.push_back(pro);
-    }
-
-    return;
-}
-
 double Find_Best_Value(const vector<double> &vec)
 {
     double max_value = *max_element(vec.begin(), vec.end());
@@ -308,7 +533,8 @@ double Calculate_Self_Fitness(
     double flow_rate_gormanium,
     double flow_rate_waste,
     double price_gormanium,
-    double cost_waste)
+    double cost_waste,
+    const UnitFractions &fractions)
 {
     double r = Evaluate_Circuit(
         circuit_vector,
@@ -319,7 +545,8 @@ double Calculate_Self_Fitness(
         price_gormanium,
         cost_waste,
         flow_rate_gormanium,
-        flow_rate_waste
+        flow_rate_waste,
+        fractions
     );
     double f_self = r + 50000;
 
@@ -333,39 +560,6 @@ vector<int> Find_Best_Gen(const vector<vector<int>> &parents, const vector<doubl
     return parents[max_index];
 }
 
-int Choose_Cross(const vector<double> &probability)
-{
-    double num = (rand() % 1000) * 0.001 + 0.001;
-    if (num < probability[0])
-    {
-        return 0;
-    }
-    // Binary search
-    int low = 1;
-    int high = probability.size();
-    int mid = (low + high) / 2;
-
-    while (low < high)
-    {
-        if (num > probability[mid])
-        {
-            low = mid;
-            mid = (high + low) / 2;
-        }
-        else if (num <= probability[mid - 1])
-        {
-            high = mid;
-            mid = (high + low) / 2;
-        }
-        else
-        {
-            return mid;
-        }
-    }
-    //return high;
-    return mid;
-}
-
 void Mutation(double f_self, double f_max, double f_avg, double f, vector<double> &adaptive_rate, vector<int> &gene, int num_units)
 {
     double k2 = adaptive_rate[1];
@@ -421,6 +615,190 @@ void Crossover(double f_max, double f_avg, double f, vector<double> &adaptive_ra
     return;
 }
 
+void Mutation(double f_self, double f_max, double f_avg, double f, vector<double> &adaptive_rate, vector<int> &gene, int num_units, mt19937 &rng)
+{
+    double k2 = adaptive_rate[1];
+    double k4 = adaptive_rate[3];
+    double pm;
+
+    if (f >= f_avg)
+    {
+        pm = k2 * ((f_max - f_self) / (f_max - f_avg));
+    }
+    else
+    {
+        pm = k4;
+    }
+    // this also catches the rate being undefined when f_max == f_avg
+    if (!(pm > 0.0))
+    {
+        return;
+    }
+
+    uniform_int_distribution<int> step(0, num_units + 1);
+    if (pm >= 1.0)
+    {
+        for (size_t i = 1; i < gene.size(); i++)
+        {
+            gene[i] = (gene[i] + step(rng)) % (num_units + 2);
+        }
+        return;
+    }
+    // number of positions skipped before the next mutation, geometric by inversion in double:
+    // geometric_distribution<int> gets very slow for a tiny rate, and cannot go past INT_MAX
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    double log_keep = log1p(-pm);
+    auto gap = [&] { return floor(log(1.0 - uniform(rng)) / log_keep); };
+    for (double i = 1 + gap(); i < gene.size(); i += 1 + gap())
+    {
+        // Pay attention to the step size here, it may need to be adjusted
+        gene[(size_t)i] = (gene[(size_t)i] + step(rng)) % (num_units + 2);
+    }
+}
+
+void Crossover(double f_max, double f_avg, double f, vector<double> &adaptive_rate, vector<int> &father, vector<int> &mother, int num_units, mt19937 &rng)
+{
+    double k1 = adaptive_rate[0];
+    double k3 = adaptive_rate[2];
+    double num = uniform_real_distribution<double>(0.0, 1.0)(rng);
+    double pc;
+    if (f >= f_avg)
+    {
+        pc = k1 * ((f_max - f) / (f_max - f_avg));
+    }
+    else
+    {
+        pc = k3;
+    }
+
+    if (num > pc)
+    {
+        return;
+    }
+
+    int point = uniform_int_distribution<int>(1, 2 * num_units + 1)(rng);
+    for (int i = 1; i < point; i++)
+    {
+        swap(father[i], mother[i]);
+    }
+}
+
+int Local_Search(
+    vector<int> &circuit_vector,
+    double &performance,
+    int budget,
+    bool pair_swap,
+    double flow_rate_gormanium,
+    double flow_rate_waste,
+    double price_gormanium,
+    double cost_waste,
+    const UnitFractions &fractions,
+    mt19937 *rng)
+{
+    int num_units = (circuit_vector.size() - 1) / 2;
+    int evaluations = 0;
+    vector<vector<int>> neighbours;
+    PopulationFlows flows;
+    vector<double> neighbour_performance;
+
+    while (evaluations < budget)
+    {
+        // Step 1. Enumerate the valid neighbours
+        neighbours.clear();
+        vector<int> neighbour(circuit_vector);
+        for (size_t i = 0; i < circuit_vector.size(); i++)
+        {
+            // the feed can only go to a unit, the outputs can also go to the concentrate or tailings
+            int num_values = (i == 0) ? num_units : num_units + 2;
+            for (int value = 0; value < num_values; value++)
+            {
+                if (value == circuit_vector[i])
+                {
+                    continue;
+                }
+                neighbour[i] = value;
+                if (utils::Check_Validity(neighbour) == 0)
+                {
+                    neighbours.push_back(neighbour);
+                }
+            }
+            neighbour[i] = circuit_vector[i];
+        }
+        if (pair_swap)
+        {
+            for (size_t i = 1; i < circuit_vector.size(); i++)
+            {
+                for (size_t j = i + 1; j < circuit_vector.size(); j++)
+                {
+                    if (circuit_vector[i] == circuit_vector[j])
+                    {
+                        continue;
+                    }
+                    swap(neighbour[i], neighbour[j]);
+                    if (utils::Check_Validity(neighbour) == 0)
+                    {
+                        neighbours.push_back(neighbour);
+                    }
+                    swap(neighbour[i], neighbour[j]);
+                }
+            }
+        }
+        if (neighbours.empty())
+        {
+            break;
+        }
+        // when the budget cuts the neighbourhood short, keep a random part of it rather
+        // than always the neighbours of the first genes
+        if ((int)neighbours.size() > budget - evaluations)
+        {
+            if (rng != nullptr)
+            {
+                shuffle(neighbours.begin(), neighbours.end(), *rng);
+            }
+            neighbours.resize(budget - evaluations);
+        }
+
+        // Step 2. Evaluate the whole neighbourhood as one batch
+        Evaluate_Population_Flows(neighbours, flows, 1e-4, 1000, flow_rate_gormanium, flow_rate_waste, nullptr,
+                                  fractions);
+        Reprice_Population(flows, vector<double>{price_gormanium}, vector<double>{cost_waste}, neighbour_performance);
+        evaluations += neighbours.size();
+
+        // Step 3. Move to the best improving neighbour, stop at a local optimum
+        int best = max_element(neighbour_performance.begin(), neighbour_performance.end()) - neighbour_performance.begin();
+        if (neighbour_performance[best] <= performance)
+        {
+            break;
+        }
+        circuit_vector = neighbours[best];
+        performance = neighbour_performance[best];
+    }
+    return evaluations;
+}
+
+vector<double> Checkpoint_Problem(
+    int max_iterations,
+    int threshold,
+    int num_units,
+    double flow_rate_gormanium,
+    double flow_rate_waste,
+    double price_gormanium,
+    double cost_waste,
+    const GeneticOptions &options)
+{
+    vector<double> problem = {(double)max_iterations, (double)threshold, flow_rate_gormanium, flow_rate_waste,
+                              price_gormanium, cost_waste};
+    for (int i = 0; i < num_units; i++)
+    {
+        problem.push_back(options.fractions.gormanium_of(i));
+        problem.push_back(options.fractions.waste_of(i));
+    }
+    const RobustOptions &robust = options.robust;
+    problem.insert(problem.end(), {(double)robust.scenarios, (double)robust.objective, robust.feed_spread,
+                                   robust.fraction_spread, (double)robust.seed});
+    return problem;
+}
+
 vector<int> Genetic_Optimization(
     int population_size,
     int max_iterations,
@@ -430,7 +808,8 @@ vector<int> Genetic_Optimization(
     double flow_rate_gormanium,
     double flow_rate_waste,
     double price_gormanium,
-    double cost_waste
+    double cost_waste,
+    const GeneticOptions &options
 )
 {
     //Step 0. Define parameters
@@ -440,34 +819,204 @@ vector<int> Genetic_Optimization(
     vector<vector<int>> children;                                // The 2D vector to store children gene
     vector<double> performance;                                  // vector for performance
     vector<double> fitness;                                      // vector for fitness
-    vector<double> probability;                                  // vector for performance
     vector<int> best_circuit;                                    // vector to store vest solution vestperformance
+    vector<int> logged_circuit;                                  // last circuit written to the generation log
     double current_best_performance = 0;                         // Current best performance, update every iteration
     double old_best_performance = 0;                             // Last time's best performation, update current best is larger than it
-    srand((unsigned)time(NULL));
+    unsigned seed = options.seed != 0 ? options.seed : random_device()();
+    mt19937 rng(seed);
+    int first_iteration = 0;
+    bool checkpoints = !options.checkpoint_path.empty();
+    auto last_checkpoint = chrono::steady_clock::now();
+    auto start = last_checkpoint;
+    bool out_of_time = false;
+    GeneticCheckpoint checkpoint;
+    vector<double> problem = Checkpoint_Problem(max_iterations, threshold, num_units, flow_rate_gormanium,
+                                                flow_rate_waste, price_gormanium, cost_waste, options);
+    const UnitFractions &fractions = options.fractions;
+    if (!fractions.valid(num_units))
+    {
+        throw invalid_argument("the concentrate fractions are not valid for a circuit of " + to_string(num_units) + " units");
+    }
+    // every circuit of the run is scored under the same scenarios
+    bool robust = options.robust.scenarios > 0;
+    ScenarioSet scenarios;
+    if (robust)
+    {
+        scenarios = Sample_Scenarios(num_units, flow_rate_gormanium, flow_rate_waste, fractions, options.robust);
+    }
+    // relabelled circuits, and the designs and flows stored for uniform fractions, are
+    // only equivalent when all the units are the same
+    bool canonical_labels = options.canonical_labels && fractions.uniform() && !robust;
+    DesignIndex *design_index = fractions.uniform() && !robust ? options.design_index : nullptr;
+    // only the scenario kernel gains from single precision, and how far a performance it
+    // screens can be from the double one depends on the largest feed rates of the scenarios
+    bool screening = robust && options.single_precision;
+    double screening_margin = 0.0;
+    if (screening)
+    {
+        screening_margin = Screening_Margin(
+            1e-4, price_gormanium, cost_waste,
+            *max_element(scenarios.feed_gormanium.begin(), scenarios.feed_gormanium.end()),
+            *max_element(scenarios.feed_waste.begin(), scenarios.feed_waste.end()));
+    }
 
-    // Step 1. Initial parents
-    Generate_Initial(population_size, parents, num_units);
+    // Step 1. Initial parents, or the state of an interrupted run
+    if (checkpoints && Load_Checkpoint(options.checkpoint_path, checkpoint, num_units, population_size, problem))
+    {
+        if (checkpoint.finished)
+        {
+            return checkpoint.best_circuit;
+        }
+        first_iteration = checkpoint.generation;
+        count_for_threshold = checkpoint.count_for_threshold;
+        old_best_performance = checkpoint.old_best_performance;
+        adaptive_rate = checkpoint.adaptive_rate;
+        parents.swap(checkpoint.population);
+        best_circuit = checkpoint.best_circuit;
+        rng = checkpoint.rng;
+    }
+    else
+    {
+        Generate_Initial(population_size, parents, num_units, rng);
+        // warm start from known circuits
+        int seeded = 0;
+        for (const vector<int> &circuit : options.initial_circuits)
+        {
+            if (seeded < population_size &&
+                (int)circuit.size() == 2 * num_units + 1 &&
+                circuit[0] < num_units &&
+                all_of(circuit.begin(), circuit.end(), [num_units](int gene) { return gene >= 0 && gene <= num_units + 1; }) &&
+                utils::Check_Validity(circuit) == 0)
+            {
+                parents[seeded++] = circuit;
+            }
+        }
+        // and from the best circuits of similar problems
+        if (design_index != nullptr)
+        {
+            int wanted = min((int)(options.warm_start * population_size + 0.5), population_size) - seeded;
+            for (const vector<int> &circuit : Warm_Start_Circuits(*design_index, wanted, num_units, flow_rate_gormanium,
+                                                                  flow_rate_waste, price_gormanium, cost_waste))
+            {
+                parents[seeded++] = circuit;
+            }
+        }
+        if (canonical_labels)
+        {
+            for (vector<int> &parent : parents)
+            {
+                parent = utils::Canonical_Circuit(parent);
+            }
+        }
+    }
+
+    // Saves the state at the start of generation i
+    auto save = [&](int i, bool finished) {
+        checkpoint.num_units = num_units;
+        checkpoint.problem = problem;
+        checkpoint.generation = i;
+        checkpoint.count_for_threshold = count_for_threshold;
+        checkpoint.old_best_performance = old_best_performance;
+        checkpoint.finished = finished;
+        checkpoint.adaptive_rate = adaptive_rate;
+        checkpoint.population = parents;
+        checkpoint.best_circuit = best_circuit;
+        checkpoint.rng = rng;
+        if (!Save_Checkpoint(options.checkpoint_path, checkpoint))
+        {
+            cerr << "Could not write checkpoint " << options.checkpoint_path << endl;
+        }
+        last_checkpoint = chrono::steady_clock::now();
+    };
 
     // start iteration
-    for (int i = 0; i < max_iterations; i++)
+    int i = first_iteration;
+    for (; i < max_iterations; i++)
     {
+        if (checkpoints && i != first_iteration &&
+            chrono::duration<double>(chrono::steady_clock::now() - last_checkpoint).count() >= options.checkpoint_interval)
+        {
+            save(i, false);
+        }
+        if (options.time_limit > 0.0 && i != first_iteration &&
+            chrono::duration<double>(chrono::steady_clock::now() - start).count() >= options.time_limit)
+        {
+            out_of_time = true;
+            break;
+        }
         performance.clear();
         fitness.clear();
-        probability.clear();
         best_circuit.clear();
-        // Step 2. Calculate Fitness Value as probability
-        Performance(
-            population_size,
-            parents,
-            performance,
-            flow_rate_gormanium,
-            flow_rate_waste,
-            price_gormanium,
-            cost_waste
-        );
+        // Step 2. Calculate Fitness Value
+        if (screening)
+        {
+            // screen the whole generation in float, then evaluate again in double the
+            // circuits that may be the best
+            Screen_Robust_Population(parents, scenarios, price_gormanium, cost_waste, options.robust.objective,
+                                     performance, screening_margin);
+        }
+        else if (robust)
+        {
+            // all the scenarios of a circuit in one batched solve
+            Robust_Population_Performance(parents, scenarios, price_gormanium, cost_waste, options.robust.objective,
+                                          performance);
+        }
+        else if (options.evaluation_database != nullptr)
+        {
+            // only the circuits never evaluated before go through the flow solver
+            PopulationFlows flows;
+            Evaluate_Population_Flows(parents, flows, 1e-4, 1000, flow_rate_gormanium, flow_rate_waste,
+                                      options.evaluation_database, fractions);
+            Reprice_Population(flows, vector<double>{price_gormanium}, vector<double>{cost_waste}, performance);
+        }
+        else
+        {
+            Performance(
+                population_size,
+                parents,
+                performance,
+                flow_rate_gormanium,
+                flow_rate_waste,
+                price_gormanium,
+                cost_waste,
+                fractions
+            );
+        }
+        // Optionally improve the elites with a local search before they are selected
+        if (options.local_search_elites > 0 && !robust)
+        {
+            int num_elites = min(options.local_search_elites, (int)parents.size());
+            vector<int> order(parents.size());
+            iota(order.begin(), order.end(), 0);
+            partial_sort(order.begin(), order.begin() + num_elites, order.end(),
+                         [&performance](int a, int b) { return performance[a] > performance[b]; });
+            // the budget shared between the elites, at least one evaluation each, and the
+            // order of their neighbours drawn from the run's generator before the threads start
+            vector<unsigned> seeds(num_elites);
+            for (unsigned &elite_seed : seeds)
+            {
+                elite_seed = rng();
+            }
+            utils::Parallel_For(0, num_elites, [&](int e) {
+                int budget = options.local_search_budget / num_elites + (e < options.local_search_budget % num_elites);
+                mt19937 elite_rng(seeds[e]);
+                Local_Search(
+                    parents[order[e]],
+                    performance[order[e]],
+                    max(1, budget),
+                    options.local_search_pair_swap,
+                    flow_rate_gormanium,
+                    flow_rate_waste,
+                    price_gormanium,
+                    cost_waste,
+                    fractions,
+                    &elite_rng
+                );
+            });
+        }
         Fitness(population_size, performance, fitness);
-        Probability(population_size, fitness, probability);
+        ParentSelector selector(fitness, options.selection, options.tournament_size);
         double f_avg = Find_Avg_Fitness(fitness);
         double f_max = Find_Best_Value(fitness);
         double f_self;
@@ -481,13 +1030,70 @@ vector<int> Genetic_Optimization(
             children.push_back(best_circuit);
         }
         children.push_back(best_circuit);
+        // Optionally keep a record of the generation
+        bool log_best = !options.generation_log.empty() && best_circuit != logged_circuit;
+        if (options.archive != nullptr || log_best)
+        {
+            vector<double> best_gormanium(num_units + 2), best_waste(num_units + 2);
+            try
+            {
+                Evaluate_Flows(best_gormanium, best_waste, best_circuit, 1e-4, 1000,
+                               price_gormanium, cost_waste, flow_rate_gormanium, flow_rate_waste, fractions);
+            }
+            catch (const int error_code)
+            {
+                // did not converge, stored without flows
+                best_gormanium.clear();
+                best_waste.clear();
+            }
+            if (options.archive != nullptr)
+            {
+                if (options.archive_population)
+                {
+                    size_t best_index = max_element(performance.begin(), performance.end()) - performance.begin();
+                    for (size_t k = 0; k < parents.size(); k++)
+                    {
+                        if (k != best_index)
+                        {
+                            options.archive->Append(parents[k], performance[k], options.run_id, i);
+                        }
+                    }
+                }
+                options.archive->Append(best_circuit, current_best_performance, options.run_id, i,
+                                        best_gormanium, best_waste);
+            }
+            if (log_best)
+            {
+                // only when the best circuit changes
+                Output_Writer().Log_Circuit(options.generation_log, options.run_id, i, best_circuit,
+                                            best_gormanium, best_waste, current_best_performance);
+                logged_circuit = best_circuit;
+            }
+        }
+        // Share the best circuit with the other runs, and rescue a stagnating run with theirs
+        if (options.hall_of_fame != nullptr)
+        {
+            options.hall_of_fame->Submit(best_circuit, current_best_performance);
+            if (options.hall_of_fame_injection > 0 &&
+                count_for_threshold % options.hall_of_fame_injection == 0 &&
+                options.hall_of_fame->Best_Performance() > current_best_performance + 0.1)
+            {
+                vector<int> global_best;
+                options.hall_of_fame->Best(global_best);
+                if (canonical_labels)
+                {
+                    global_best = utils::Canonical_Circuit(global_best);
+                }
+                children.push_back(global_best);
+            }
+        }
 
         // Generate next generation with the same size
         while (children.size() < population_size)
         {
             // Step 4. Select a pair of the parents
-            int father_index = Choose_Cross(probability);
-            int mother_index = Choose_Cross(probability);
+            int father_index = selector.Next(rng);
+            int mother_index = selector.Next(rng);
             // Prevent father and mother are the same.
             if (father_index == mother_index)
             {
@@ -497,26 +1103,49 @@ vector<int> Genetic_Optimization(
             vector<int> mother(parents[mother_index]);
             // Step 5. Randomly crossover.
             double f = Find_Better_Fitness(father_index, mother_index, fitness);
-            Crossover(f_max, f_avg, f, adaptive_rate, father, mother, num_units);
+            Crossover(f_max, f_avg, f, adaptive_rate, father, mother, num_units, rng);
             vector<int> &child_1 = father;
             vector<int> &child_2 = mother;
             // Step 6. Go over each of the numbers in both two vectors and decide whether to mutate them
-            f_self = Calculate_Self_Fitness(
-                child_1,
-                flow_rate_gormanium,
-                flow_rate_waste,
-                price_gormanium,
-                cost_waste
-            );
-            Mutation(f_self, f_max, f_avg, f, adaptive_rate, child_1, num_units);
-            f_self = Calculate_Self_Fitness(
-                child_2,
-                flow_rate_gormanium,
-                flow_rate_waste,
-                price_gormanium,
-                cost_waste
-            );
-            Mutation(f_self, f_max, f_avg, f, adaptive_rate, child_2, num_units);
+            if (robust)
+            {
+                f_self = Robust_Performance(child_1, scenarios, price_gormanium, cost_waste, options.robust.objective,
+                                            options.single_precision) + 50000;
+            }
+            else
+            {
+                f_self = Calculate_Self_Fitness(
+                    child_1,
+                    flow_rate_gormanium,
+                    flow_rate_waste,
+                    price_gormanium,
+                    cost_waste,
+                    fractions
+                );
+            }
+            Mutation(f_self, f_max, f_avg, f, adaptive_rate, child_1, num_units, rng);
+            if (robust)
+            {
+                f_self = Robust_Performance(child_2, scenarios, price_gormanium, cost_waste, options.robust.objective,
+                                            options.single_precision) + 50000;
+            }
+            else
+            {
+                f_self = Calculate_Self_Fitness(
+                    child_2,
+                    flow_rate_gormanium,
+                    flow_rate_waste,
+                    price_gormanium,
+                    cost_waste,
+                    fractions
+                );
+            }
+            Mutation(f_self, f_max, f_avg, f, adaptive_rate, child_2, num_units, rng);
+            if (canonical_labels)
+            {
+                child_1 = utils::Canonical_Circuit(child_1);
+                child_2 = utils::Canonical_Circuit(child_2);
+            }
             // Step 7. Check that each of these potential new vectors are valid and, if they are, add them to the list of child vectors.
             if (utils::Check_Validity(child_1) == 0)
             {
@@ -543,5 +1172,15 @@ vector<int> Genetic_Optimization(
         parents.swap(children);
         children.clear();
     }
+    if (checkpoints)
+    {
+        // a run stopped by its time limit can still be resumed
+        save(i, !out_of_time);
+    }
+    if (design_index != nullptr && !best_circuit.empty())
+    {
+        design_index->Add(best_circuit, current_best_performance, flow_rate_gormanium, flow_rate_waste,
+                                  price_gormanium, cost_waste);
+    }
     return best_circuit;
 }
\ No newline at end of file
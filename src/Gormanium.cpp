@@ -0,0 +1,185 @@
+// the definitions of the exported functions, dllexport on Windows
+#define GORMANIUM_BUILD
+#include "Gormanium.h"
+#include "Bulk_Evaluator.h"
+#include "Genetic_Algorithm.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    BulkOptions Problem(double tolerance, int max_iterations, double price_gormanium, double cost_waste,
+                        double feed_gormanium, double feed_waste)
+    {
+        BulkOptions options;
+        options.tolerance = tolerance;
+        options.max_iterations = max_iterations;
+        options.price_gormanium = price_gormanium;
+        options.cost_waste = cost_waste;
+        options.flow_rate_gormanium = feed_gormanium;
+        options.flow_rate_waste = feed_waste;
+        return options;
+    }
+
+    // the genes index the flow vectors, so they are checked before anything else
+    bool In_Range(const int *circuit, int num_units)
+    {
+        if (circuit == nullptr || num_units < 1 || circuit[0] < 0 || circuit[0] >= num_units)
+        {
+            return false;
+        }
+        for (int i = 1; i < 2 * num_units + 1; i++)
+        {
+            if (circuit[i] < 0 || circuit[i] > num_units + 1)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int gormanium_abi_version(void)
+{
+    return GORMANIUM_ABI_VERSION;
+}
+
+int gormanium_check_validity(const int *circuit, int num_units)
+{
+    if (!In_Range(circuit, num_units))
+    {
+        return GORMANIUM_MALFORMED;
+    }
+    try
+    {
+        return utils::Check_Validity(vector<int>(circuit, circuit + 2 * num_units + 1));
+    }
+    catch (...)
+    {
+        return GORMANIUM_FAILED;
+    }
+}
+
+int gormanium_evaluate_flows(const int *circuit, int num_units, double tolerance, int max_iterations,
+                             double feed_gormanium, double feed_waste, double *gormanium, double *waste)
+{
+    if (gormanium == nullptr || waste == nullptr)
+    {
+        return GORMANIUM_BAD_ARGUMENT;
+    }
+    if (!In_Range(circuit, num_units))
+    {
+        return GORMANIUM_MALFORMED;
+    }
+    try
+    {
+        vector<double> gormanium_flows(num_units + 2), waste_flows(num_units + 2);
+        Evaluate_Flows(gormanium_flows, waste_flows, vector<int>(circuit, circuit + 2 * num_units + 1), tolerance,
+                       max_iterations, 100.0, 500.0, feed_gormanium, feed_waste);
+        copy(gormanium_flows.begin(), gormanium_flows.end(), gormanium);
+        copy(waste_flows.begin(), waste_flows.end(), waste);
+        return GORMANIUM_OK;
+    }
+    catch (const int error_code)
+    {
+        return error_code == 1 ? GORMANIUM_NOT_CONVERGED : GORMANIUM_MASS_BALANCE;
+    }
+    catch (...)
+    {
+        return GORMANIUM_FAILED;
+    }
+}
+
+double gormanium_evaluate_circuit(const int *circuit, int num_units, double tolerance, int max_iterations,
+                                  double price_gormanium, double cost_waste, double feed_gormanium, double feed_waste)
+{
+    if (!In_Range(circuit, num_units))
+    {
+        return numeric_limits<double>::quiet_NaN();
+    }
+    try
+    {
+        return Evaluate_Circuit(vector<int>(circuit, circuit + 2 * num_units + 1), false, 0, tolerance,
+                                max_iterations, price_gormanium, cost_waste, feed_gormanium, feed_waste);
+    }
+    catch (...)
+    {
+        return numeric_limits<double>::quiet_NaN();
+    }
+}
+
+int gormanium_evaluate_batch(const int *circuits, int count, int num_units, double tolerance, int max_iterations,
+                             double price_gormanium, double cost_waste, double feed_gormanium, double feed_waste,
+                             int *validity, double *performance, double *concentrate_gormanium,
+                             double *concentrate_waste)
+{
+    if (count < 0 || num_units < 1 || (count > 0 && circuits == nullptr))
+    {
+        return GORMANIUM_BAD_ARGUMENT;
+    }
+    BulkOptions options = Problem(tolerance, max_iterations, price_gormanium, cost_waste, feed_gormanium, feed_waste);
+    size_t size = 2 * num_units + 1;
+    vector<char> valid(count, 0);
+    try
+    {
+        utils::Parallel_For(0, count, [&](int i) {
+            double circuit_performance, gormanium, waste;
+            int code = Bulk_Evaluate_Circuit(circuits + i * size, size, options, circuit_performance, gormanium, waste);
+            valid[i] = code == 0;
+            if (validity != nullptr)
+            {
+                validity[i] = code;
+            }
+            if (performance != nullptr)
+            {
+                performance[i] = circuit_performance;
+            }
+            if (concentrate_gormanium != nullptr)
+            {
+                concentrate_gormanium[i] = gormanium;
+            }
+            if (concentrate_waste != nullptr)
+            {
+                concentrate_waste[i] = waste;
+            }
+        }, 64);
+    }
+    catch (...)
+    {
+        return GORMANIUM_FAILED;
+    }
+    return count_if(valid.begin(), valid.end(), [](char v) { return v != 0; });
+}
+
+int gormanium_genetic_optimization(int population_size, int max_iterations, int threshold, int num_units,
+                                   double feed_gormanium, double feed_waste, double price_gormanium,
+                                   double cost_waste, unsigned seed, int *best_circuit, double *performance)
+{
+    if (best_circuit == nullptr || population_size < 2 || max_iterations < 1 || num_units < 1)
+    {
+        return GORMANIUM_BAD_ARGUMENT;
+    }
+    try
+    {
+        GeneticOptions options;
+        options.seed = seed;
+        vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+        vector<int> best = Genetic_Optimization(population_size, max_iterations, threshold, adaptive_rate, num_units,
+                                                feed_gormanium, feed_waste, price_gormanium, cost_waste, options);
+        copy(best.begin(), best.end(), best_circuit);
+        if (performance != nullptr)
+        {
+            *performance = Evaluate_Circuit(best, false, 0, 1e-4, 1000, price_gormanium, cost_waste,
+                                            feed_gormanium, feed_waste);
+        }
+        return GORMANIUM_OK;
+    }
+    catch (...)
+    {
+        return GORMANIUM_FAILED;
+    }
+}
@@ -0,0 +1,72 @@
+#include "Hall_Of_Fame.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+HallOfFame::HallOfFame(int capacity) : capacity_{max(capacity, 1)},
+                                       threshold_{Empty()},
+                                       best_{Empty()}
+{
+    entries_.reserve(capacity_ + 1);
+}
+
+double HallOfFame::Empty()
+{
+    return -numeric_limits<double>::infinity();
+}
+
+bool HallOfFame::Submit(const vector<int> &circuit, double performance)
+{
+    // fast path: not good enough, no lock needed
+    if (!(performance > threshold_.load(memory_order_acquire)))
+    {
+        return false;
+    }
+
+    lock_guard<mutex> guard(lock_);
+    // the threshold may have risen while waiting for the lock
+    if (!(performance > threshold_.load(memory_order_relaxed)))
+    {
+        return false;
+    }
+    for (const pair<double, vector<int>> &entry : entries_)
+    {
+        if (entry.second == circuit)
+        {
+            return false;
+        }
+    }
+    auto position = find_if(entries_.begin(), entries_.end(),
+                            [performance](const pair<double, vector<int>> &entry) { return entry.first < performance; });
+    entries_.emplace(position, performance, circuit);
+    if ((int)entries_.size() > capacity_)
+    {
+        entries_.pop_back();
+    }
+    if ((int)entries_.size() == capacity_)
+    {
+        threshold_.store(entries_.back().first, memory_order_release);
+    }
+    best_.store(entries_.front().first, memory_order_release);
+    version_.fetch_add(1, memory_order_release);
+    return true;
+}
+
+double HallOfFame::Best(vector<int> &circuit) const
+{
+    lock_guard<mutex> guard(lock_);
+    if (entries_.empty())
+    {
+        return Empty();
+    }
+    circuit = entries_.front().second;
+    return entries_.front().first;
+}
+
+vector<pair<double, vector<int>>> HallOfFame::Entries() const
+{
+    lock_guard<mutex> guard(lock_);
+    return entries_;
+}
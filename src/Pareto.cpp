@@ -0,0 +1,264 @@
+#include "Pareto.h"
+#include "utils.h"
+
+#include <limits>
+#include <set>
+
+using namespace std;
+
+bool Dominates(double gormanium_a, double waste_a, double gormanium_b, double waste_b)
+{
+    return (gormanium_a >= gormanium_b && waste_a <= waste_b) &&
+           (gormanium_a > gormanium_b || waste_a < waste_b);
+}
+
+void Non_Dominated_Sort(const PopulationFlows &flows, vector<int> &rank, vector<vector<int>> &fronts)
+{
+    int size = flows.conc_gormanium.size();
+    // circuits dominated by each circuit, and number of circuits dominating each circuit
+    vector<vector<int>> dominated(size);
+    vector<int> dominated_by(size, 0);
+    rank.assign(size, 0);
+    fronts.clear();
+    fronts.push_back(vector<int>());
+
+    for (int p = 0; p < size; p++)
+    {
+        for (int q = p + 1; q < size; q++)
+        {
+            if (Dominates(flows.conc_gormanium[p], flows.conc_waste[p], flows.conc_gormanium[q], flows.conc_waste[q]))
+            {
+                dominated[p].push_back(q);
+                dominated_by[q]++;
+            }
+            else if (Dominates(flows.conc_gormanium[q], flows.conc_waste[q], flows.conc_gormanium[p], flows.conc_waste[p]))
+            {
+                dominated[q].push_back(p);
+                dominated_by[p]++;
+            }
+        }
+    }
+    for (int p = 0; p < size; p++)
+    {
+        if (dominated_by[p] == 0)
+        {
+            fronts[0].push_back(p);
+        }
+    }
+
+    // peel off the fronts one at a time
+    int i = 0;
+    while (!fronts[i].empty())
+    {
+        vector<int> next;
+        for (int p : fronts[i])
+        {
+            for (int q : dominated[p])
+            {
+                if (--dominated_by[q] == 0)
+                {
+                    rank[q] = i + 1;
+                    next.push_back(q);
+                }
+            }
+        }
+        fronts.push_back(next);
+        i++;
+    }
+    // the last front is always empty
+    fronts.pop_back();
+}
+
+void Crowding_Distance(const PopulationFlows &flows, const vector<int> &front, vector<double> &distance)
+{
+    const double infinity = numeric_limits<double>::infinity();
+    for (int p : front)
+    {
+        distance[p] = 0.0;
+    }
+    if (front.size() <= 2)
+    {
+        for (int p : front)
+        {
+            distance[p] = infinity;
+        }
+        return;
+    }
+
+    const vector<double> *objectives[2] = {&flows.conc_gormanium, &flows.conc_waste};
+    vector<int> sorted(front);
+    for (const vector<double> *objective : objectives)
+    {
+        const vector<double> &values = *objective;
+        sort(sorted.begin(), sorted.end(), [&values](int a, int b) { return values[a] < values[b]; });
+        double range = values[sorted.back()] - values[sorted.front()];
+        distance[sorted.front()] = infinity;
+        distance[sorted.back()] = infinity;
+        if (range <= 0.0)
+        {
+            continue;
+        }
+        for (size_t k = 1; k + 1 < sorted.size(); k++)
+        {
+            distance[sorted[k]] += (values[sorted[k + 1]] - values[sorted[k - 1]]) / range;
+        }
+    }
+}
+
+int Crowded_Tournament(const vector<int> &rank, const vector<double> &distance, mt19937 &rng)
+{
+    uniform_int_distribution<int> circuit(0, rank.size() - 1);
+    int a = circuit(rng);
+    int b = circuit(rng);
+    if (rank[a] != rank[b])
+    {
+        return rank[a] < rank[b] ? a : b;
+    }
+    return distance[a] >= distance[b] ? a : b;
+}
+
+vector<vector<int>> Pareto_Optimization(
+    int population_size,
+    int max_iterations,
+    vector<double> &adaptive_rate,
+    PopulationFlows &front_flows,
+    int num_units,
+    double flow_rate_gormanium,
+    double flow_rate_waste,
+    unsigned seed)
+{
+    vector<vector<int>> parents;       // The 2D vector to store parents gene
+    vector<vector<int>> children;      // The 2D vector to store children gene
+    PopulationFlows flows;             // concentrate flows of parents and children
+    vector<int> rank;                  // front index of each parent
+    vector<double> distance;           // crowding distance of each parent
+    vector<vector<int>> fronts;        // indices of the circuits in each front
+    mt19937 rng(seed != 0 ? seed : random_device()());
+
+    // Step 1. Initial parents, ranked like any other generation
+    Generate_Initial(population_size, parents, num_units, rng);
+    Evaluate_Population_Flows(parents, flows, 1e-4, 1000, flow_rate_gormanium, flow_rate_waste);
+    Non_Dominated_Sort(flows, rank, fronts);
+    distance.assign(parents.size(), 0.0);
+    for (const vector<int> &front : fronts)
+    {
+        Crowding_Distance(flows, front, distance);
+    }
+
+    for (int i = 0; i < max_iterations; i++)
+    {
+        // Step 2. Breed the children, selecting parents with the crowded comparison operator.
+        // Passing a below-average fitness to Crossover and Mutation selects the
+        // fixed rates k3 and k4, as there is no scalar fitness to adapt to here.
+        children.clear();
+        while (children.size() < (size_t)population_size)
+        {
+            vector<int> father(parents[Crowded_Tournament(rank, distance, rng)]);
+            vector<int> mother(parents[Crowded_Tournament(rank, distance, rng)]);
+            Crossover(1.0, 1.0, 0.0, adaptive_rate, father, mother, num_units, rng);
+            Mutation(0.0, 1.0, 1.0, 0.0, adaptive_rate, father, num_units, rng);
+            Mutation(0.0, 1.0, 1.0, 0.0, adaptive_rate, mother, num_units, rng);
+            if (utils::Check_Validity(father) == 0)
+            {
+                children.push_back(father);
+            }
+            if (utils::Check_Validity(mother) == 0 && children.size() < (size_t)population_size)
+            {
+                children.push_back(mother);
+            }
+        }
+        PopulationFlows children_flows;
+        Evaluate_Population_Flows(children, children_flows, 1e-4, 1000, flow_rate_gormanium, flow_rate_waste);
+
+        // Step 3. Merge parents and children, dropping duplicated genes so that
+        // copies of the same circuit don't crowd the front
+        vector<vector<int>> merged;
+        PopulationFlows merged_flows;
+        set<vector<int>> seen;
+        for (int k = 0; k < 2; k++)
+        {
+            const vector<vector<int>> &source = k == 0 ? parents : children;
+            const PopulationFlows &source_flows = k == 0 ? flows : children_flows;
+            for (size_t j = 0; j < source.size(); j++)
+            {
+                if (seen.insert(source[j]).second)
+                {
+                    merged.push_back(source[j]);
+                    merged_flows.conc_gormanium.push_back(source_flows.conc_gormanium[j]);
+                    merged_flows.conc_waste.push_back(source_flows.conc_waste[j]);
+                    merged_flows.converged.push_back(source_flows.converged[j]);
+                }
+            }
+        }
+
+        // Step 4. Fill the next generation front by front, the last front
+        // that doesn't fit entirely is truncated by crowding distance
+        vector<int> merged_rank;
+        Non_Dominated_Sort(merged_flows, merged_rank, fronts);
+        vector<double> merged_distance(merged.size(), 0.0);
+        vector<int> selected;
+        for (vector<int> &front : fronts)
+        {
+            Crowding_Distance(merged_flows, front, merged_distance);
+            if (selected.size() + front.size() > (size_t)population_size)
+            {
+                sort(front.begin(), front.end(), [&merged_distance](int a, int b) { return merged_distance[a] > merged_distance[b]; });
+                front.resize(population_size - selected.size());
+            }
+            selected.insert(selected.end(), front.begin(), front.end());
+            if (selected.size() == (size_t)population_size)
+            {
+                break;
+            }
+        }
+
+        // Step 5. Replace the parents by the selected circuits
+        parents.clear();
+        flows = PopulationFlows();
+        rank.clear();
+        distance.clear();
+        for (int j : selected)
+        {
+            parents.push_back(merged[j]);
+            flows.conc_gormanium.push_back(merged_flows.conc_gormanium[j]);
+            flows.conc_waste.push_back(merged_flows.conc_waste[j]);
+            flows.converged.push_back(merged_flows.converged[j]);
+            rank.push_back(merged_rank[j]);
+            distance.push_back(merged_distance[j]);
+        }
+    }
+
+    // Return the first front, one circuit per point in objective space,
+    // by increasing gormanium recovery
+    vector<int> front;
+    for (size_t j = 0; j < parents.size(); j++)
+    {
+        if (rank[j] == 0 && flows.converged[j])
+        {
+            front.push_back(j);
+        }
+    }
+    sort(front.begin(), front.end(), [&flows](int a, int b) {
+        if (flows.conc_gormanium[a] != flows.conc_gormanium[b])
+        {
+            return flows.conc_gormanium[a] < flows.conc_gormanium[b];
+        }
+        return flows.conc_waste[a] < flows.conc_waste[b];
+    });
+    vector<vector<int>> result;
+    front_flows = PopulationFlows();
+    for (int j : front)
+    {
+        if (!result.empty() &&
+            flows.conc_gormanium[j] == front_flows.conc_gormanium.back() &&
+            flows.conc_waste[j] == front_flows.conc_waste.back())
+        {
+            continue;
+        }
+        result.push_back(parents[j]);
+        front_flows.conc_gormanium.push_back(flows.conc_gormanium[j]);
+        front_flows.conc_waste.push_back(flows.conc_waste[j]);
+        front_flows.converged.push_back(flows.converged[j]);
+    }
+    return result;
+}
@@ -0,0 +1,131 @@
+// local includes
+#include "Genetic_Algorithm.h"
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+    const char *USAGE =
+        " [--num_units N] [--circuits N] [--scenarios K] [--seed N]\n"
+        "times the double and single precision scenario kernels on random valid circuits";
+
+    // seconds taken by body
+    template <typename Body>
+    double Time(Body body)
+    {
+        auto start = chrono::steady_clock::now();
+        body();
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    void Report(const char *name, double items, double double_seconds, double single_seconds)
+    {
+        printf("%-34s %12.0f /s %12.0f /s %8.2fx\n", name, items / double_seconds, items / single_seconds,
+               double_seconds / single_seconds);
+    }
+}
+
+// Throughput of the single precision screening against the double precision scenario kernel
+// usage: Precision_Benchmark [options], see USAGE
+int main(int argc, char *argv[])
+{
+    int num_units = 10;
+    int circuits = 2000;
+    int num_scenarios = 32;
+    unsigned seed = 1;
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            string flag = argv[i];
+            if (i + 1 == argc)
+            {
+                throw invalid_argument("unknown flag or missing value: " + flag);
+            }
+            string value = argv[++i];
+            if (flag == "--num_units")
+            {
+                num_units = stoi(value);
+            }
+            else if (flag == "--circuits")
+            {
+                circuits = stoi(value);
+            }
+            else if (flag == "--scenarios")
+            {
+                num_scenarios = stoi(value);
+            }
+            else if (flag == "--seed")
+            {
+                seed = stoul(value);
+            }
+            else
+            {
+                throw invalid_argument("unknown flag: " + flag);
+            }
+        }
+        if (num_units < 1 || circuits < 1 || num_scenarios < 1)
+        {
+            throw invalid_argument("the numbers must be positive");
+        }
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what() << endl
+             << "usage: " << argv[0] << USAGE << endl;
+        return 1;
+    }
+
+    // all the scenarios of a circuit together, vectorised
+    mt19937 rng(seed);
+    vector<vector<int>> population;
+    Generate_Initial(circuits, population, num_units, rng);
+    ScenarioSet scenarios = Sample_Scenarios(num_units, num_scenarios, 10.0, 100.0, UnitFractions(), 0.1, 0.1, seed);
+    double margin = Screening_Margin(1e-4, 100.0, 500.0,
+                                     *max_element(scenarios.feed_gormanium.begin(), scenarios.feed_gormanium.end()),
+                                     *max_element(scenarios.feed_waste.begin(), scenarios.feed_waste.end()));
+    printf("%d random circuits of %d units, %d scenarios\n", circuits, num_units, num_scenarios);
+    printf("%-34s %15s %15s %9s\n", "", "double", "single", "speedup");
+    vector<double> double_performance, single_performance, screened_performance;
+    double double_seconds = Time([&] {
+        Robust_Population_Performance(population, scenarios, 100.0, 500.0, RobustObjective::Expected,
+                                      double_performance);
+    });
+    double single_seconds = Time([&] {
+        Robust_Population_Performance(population, scenarios, 100.0, 500.0, RobustObjective::Expected,
+                                      single_performance, true);
+    });
+    Report("scenarios", (double)circuits * num_scenarios, double_seconds, single_seconds);
+    // a scenario that converges in float only is overestimated by far, the margin only has to
+    // cover the underestimates
+    double largest_difference = 0.0, largest_underestimate = 0.0;
+    for (int i = 0; i < circuits; i++)
+    {
+        largest_difference = max(largest_difference, abs(double_performance[i] - single_performance[i]));
+        largest_underestimate = max(largest_underestimate, double_performance[i] - single_performance[i]);
+    }
+
+    // a generation screened in single precision and refined, against all in double
+    int refined = 0;
+    double screened_seconds = Time([&] {
+        refined = Screen_Robust_Population(population, scenarios, 100.0, 500.0, RobustObjective::Expected,
+                                           screened_performance, margin);
+    });
+    Report("screening with refinement", (double)circuits * num_scenarios, double_seconds, screened_seconds);
+    int best = max_element(screened_performance.begin(), screened_performance.end()) - screened_performance.begin();
+
+    printf("largest difference of performance %g, largest underestimate %g, screening margin %g\n",
+           largest_difference, largest_underestimate, margin);
+    printf("%d circuits refined in double, best circuit %s\n", refined,
+           screened_performance[best] == *max_element(double_performance.begin(), double_performance.end())
+               ? "found"
+               : "missed");
+    return 0;
+}
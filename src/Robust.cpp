@@ -0,0 +1,377 @@
+#include "Robust.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+    // how much closer to the tolerance than its own relative error a scenario solved in float
+    // may come without converging, while it converges in double: 0.4% over 40000 random
+    // circuits of 10 and 20 units under 32 scenarios, 1000 iterations and a tolerance of 1e-4
+    const double CONVERGENCE_BAND = 0.1;
+
+    double Logit(double p)
+    {
+        return log(p / (1.0 - p));
+    }
+
+    double Logistic(double x)
+    {
+        return 1.0 / (1.0 + exp(-x));
+    }
+
+    // Successive substitution of all the scenarios of a circuit, with the flows in Real
+    // arithmetic, double or float for screening
+    template <typename Real>
+    void Scenario_Kernel(
+        const vector<int> &circuit_vector,
+        int count,
+        const Real *input_gormanium,
+        const Real *input_waste,
+        const Real *scenario_fraction_gormanium,
+        const Real *scenario_fraction_waste,
+        Real tolerance,
+        int max_iterations,
+        vector<double> &conc_gormanium,
+        vector<double> &conc_waste,
+        vector<char> &converged,
+        vector<double> &closest_error)
+    {
+        int n = (circuit_vector.size() - 1) / 2;
+        conc_gormanium.assign(count, 0.0);
+        conc_waste.assign(count, 0.0);
+        converged.assign(count, 0);
+        closest_error.assign(count, HUGE_VAL);
+
+        // the flows into unit i in scenario k are at i * count + k, with the final
+        // concentrate and tailings as units n and n + 1, as in Evaluate_Flows
+        vector<Real> feed_gormanium((n + 2) * count, 0);
+        vector<Real> feed_waste((n + 2) * count, 0);
+        vector<Real> new_feed_gormanium((n + 2) * count);
+        vector<Real> new_feed_waste((n + 2) * count);
+        // the mass is summed in double whatever the precision of the flows
+        vector<double> total_mass(count, 0.0);
+        vector<Real> largest_error(count);
+        int entry = circuit_vector[0] * count;
+        for (int k = 0; k < count; k++)
+        {
+            feed_gormanium[entry + k] = input_gormanium[k];
+            feed_waste[entry + k] = input_waste[k];
+        }
+
+        int remaining = count;
+        for (int it = 0; it < max_iterations; it++)
+        {
+            fill(new_feed_gormanium.begin(), new_feed_gormanium.end(), Real(0));
+            fill(new_feed_waste.begin(), new_feed_waste.end(), Real(0));
+
+            // one read of the connectivity of each unit for all the scenarios
+            for (int i = 0; i < n; i++)
+            {
+                const Real *fraction_gormanium = &scenario_fraction_gormanium[i * count];
+                const Real *fraction_waste = &scenario_fraction_waste[i * count];
+                const Real *gormanium = &feed_gormanium[i * count];
+                const Real *waste = &feed_waste[i * count];
+                Real *concentrate_gormanium = &new_feed_gormanium[circuit_vector[i * 2 + 1] * count];
+                Real *concentrate_waste = &new_feed_waste[circuit_vector[i * 2 + 1] * count];
+                Real *tailings_gormanium = &new_feed_gormanium[circuit_vector[i * 2 + 2] * count];
+                Real *tailings_waste = &new_feed_waste[circuit_vector[i * 2 + 2] * count];
+                if (concentrate_gormanium == tailings_gormanium)
+                {
+                    // not a valid circuit, but the mutation rate of a child is evaluated before
+                    // its validity is checked: the rows alias, so no vectorisation
+                    for (int k = 0; k < count; k++)
+                    {
+                        concentrate_gormanium[k] += gormanium[k] * fraction_gormanium[k];
+                        concentrate_waste[k] += waste[k] * fraction_waste[k];
+                        tailings_gormanium[k] += gormanium[k] * (1 - fraction_gormanium[k]);
+                        tailings_waste[k] += waste[k] * (1 - fraction_waste[k]);
+                    }
+                    continue;
+                }
+    #pragma omp simd
+                for (int k = 0; k < count; k++)
+                {
+                    concentrate_gormanium[k] += gormanium[k] * fraction_gormanium[k];
+                    concentrate_waste[k] += waste[k] * fraction_waste[k];
+                    tailings_gormanium[k] += gormanium[k] * (1 - fraction_gormanium[k]);
+                    tailings_waste[k] += waste[k] * (1 - fraction_waste[k]);
+                }
+            }
+
+            // Feed mass into the overall circuit
+            for (int k = 0; k < count; k++)
+            {
+                new_feed_gormanium[entry + k] += input_gormanium[k];
+                new_feed_waste[entry + k] += input_waste[k];
+            }
+
+            // relative errors of every scenario with respect to the previous iteration
+            fill(largest_error.begin(), largest_error.end(), Real(0));
+            for (int i = 0; i < n; i++)
+            {
+                const Real *gormanium = &feed_gormanium[i * count];
+                const Real *waste = &feed_waste[i * count];
+                const Real *new_gormanium = &new_feed_gormanium[i * count];
+                const Real *new_waste = &new_feed_waste[i * count];
+    #pragma omp simd
+                for (int k = 0; k < count; k++)
+                {
+                    Real gormanium_error = std::abs(new_gormanium[k] - gormanium[k]) / gormanium[k];
+                    Real waste_error = std::abs(new_waste[k] - waste[k]) / waste[k];
+                    // a NaN error (no flow yet) does not count, as in Evaluate_Flows
+                    largest_error[k] = gormanium_error > largest_error[k] ? gormanium_error : largest_error[k];
+                    largest_error[k] = waste_error > largest_error[k] ? waste_error : largest_error[k];
+                }
+            }
+
+            // keep the flows of the scenarios that reached steady state at this iteration
+            for (int k = 0; k < count; k++)
+            {
+                if (converged[k])
+                {
+                    continue;
+                }
+                closest_error[k] = min(closest_error[k], (double)largest_error[k]);
+                if (largest_error[k] > tolerance)
+                {
+                    continue;
+                }
+                double mass = total_mass[k];
+                for (int i = 0; i < n; i++)
+                {
+                    mass += new_feed_gormanium[i * count + k];
+                    mass += new_feed_waste[i * count + k];
+                }
+                double sum_check = (it + 1) * ((double)input_gormanium[k] + input_waste[k]);
+                if (std::abs(mass - sum_check) / sum_check > 1e-4)
+                {
+                    throw 2;
+                }
+                conc_gormanium[k] = new_feed_gormanium[n * count + k];
+                conc_waste[k] = new_feed_waste[n * count + k];
+                converged[k] = 1;
+                remaining--;
+            }
+            if (remaining == 0)
+            {
+                break;
+            }
+
+            // Update feed vectors for next iteration, and take the destination mass out of the circuit
+            feed_gormanium.swap(new_feed_gormanium);
+            feed_waste.swap(new_feed_waste);
+            for (int k = 0; k < count; k++)
+            {
+                total_mass[k] += (double)feed_gormanium[n * count + k] + feed_gormanium[(n + 1) * count + k] +
+                                 feed_waste[n * count + k] + feed_waste[(n + 1) * count + k];
+                feed_gormanium[n * count + k] = 0;
+                feed_gormanium[(n + 1) * count + k] = 0;
+                feed_waste[n * count + k] = 0;
+                feed_waste[(n + 1) * count + k] = 0;
+            }
+        }
+
+        // the penalty of Evaluate_Circuit for the scenarios that did not converge
+        for (int k = 0; k < count; k++)
+        {
+            if (!converged[k])
+            {
+                conc_gormanium[k] = 0.0;
+                conc_waste[k] = input_waste[k];
+            }
+        }
+    }
+}
+
+UnitFractions ScenarioSet::fractions_of(int k) const
+{
+    UnitFractions fractions;
+    for (int i = 0; i < num_units; i++)
+    {
+        fractions.gormanium.push_back(fraction_gormanium[i * count + k]);
+        fractions.waste.push_back(fraction_waste[i * count + k]);
+    }
+    return fractions;
+}
+
+ScenarioSet Sample_Scenarios(
+    int num_units,
+    int count,
+    double flow_rate_gormanium,
+    double flow_rate_waste,
+    const UnitFractions &fractions,
+    double feed_spread,
+    double fraction_spread,
+    unsigned seed)
+{
+    if (num_units < 1 || count < 1 || feed_spread < 0.0 || fraction_spread < 0.0)
+    {
+        throw invalid_argument("Bad number or spread of scenarios");
+    }
+    if (!fractions.valid(num_units))
+    {
+        throw invalid_argument("the concentrate fractions are not valid for a circuit of " + to_string(num_units) + " units");
+    }
+    ScenarioSet scenarios;
+    scenarios.num_units = num_units;
+    scenarios.count = count;
+    scenarios.feed_gormanium.resize(count);
+    scenarios.feed_waste.resize(count);
+    scenarios.fraction_gormanium.resize(num_units * count);
+    scenarios.fraction_waste.resize(num_units * count);
+
+    mt19937 rng(seed);
+    normal_distribution<double> normal(0.0, 1.0);
+    for (int k = 0; k < count; k++)
+    {
+        scenarios.feed_gormanium[k] = flow_rate_gormanium * exp(feed_spread * normal(rng));
+        scenarios.feed_waste[k] = flow_rate_waste * exp(feed_spread * normal(rng));
+        for (int i = 0; i < num_units; i++)
+        {
+            scenarios.fraction_gormanium[i * count + k] =
+                Logistic(Logit(fractions.gormanium_of(i)) + fraction_spread * normal(rng));
+            scenarios.fraction_waste[i * count + k] =
+                Logistic(Logit(fractions.waste_of(i)) + fraction_spread * normal(rng));
+        }
+    }
+    return scenarios;
+}
+
+ScenarioSet Sample_Scenarios(
+    int num_units,
+    double flow_rate_gormanium,
+    double flow_rate_waste,
+    const UnitFractions &fractions,
+    const RobustOptions &options)
+{
+    return Sample_Scenarios(num_units, options.scenarios, flow_rate_gormanium, flow_rate_waste, fractions,
+                            options.feed_spread, options.fraction_spread, options.seed);
+}
+
+void Evaluate_Scenario_Flows(
+    const vector<int> &circuit_vector,
+    const ScenarioSet &scenarios,
+    vector<double> &conc_gormanium,
+    vector<double> &conc_waste,
+    vector<char> &converged,
+    double tolerance,
+    int max_iterations,
+    bool single_precision)
+{
+    int n = (circuit_vector.size() - 1) / 2;
+    if (n != scenarios.num_units)
+    {
+        throw invalid_argument("the scenarios are for circuits of " + to_string(scenarios.num_units) + " units");
+    }
+    vector<double> closest_error;
+    if (!single_precision)
+    {
+        Scenario_Kernel(circuit_vector, scenarios.count, scenarios.feed_gormanium.data(), scenarios.feed_waste.data(),
+                        scenarios.fraction_gormanium.data(), scenarios.fraction_waste.data(), tolerance,
+                        max_iterations, conc_gormanium, conc_waste, converged, closest_error);
+        return;
+    }
+    vector<float> feed_gormanium(scenarios.feed_gormanium.begin(), scenarios.feed_gormanium.end());
+    vector<float> feed_waste(scenarios.feed_waste.begin(), scenarios.feed_waste.end());
+    vector<float> fraction_gormanium(scenarios.fraction_gormanium.begin(), scenarios.fraction_gormanium.end());
+    vector<float> fraction_waste(scenarios.fraction_waste.begin(), scenarios.fraction_waste.end());
+    Scenario_Kernel<float>(circuit_vector, scenarios.count, feed_gormanium.data(), feed_waste.data(),
+                           fraction_gormanium.data(), fraction_waste.data(), tolerance, max_iterations,
+                           conc_gormanium, conc_waste, converged, closest_error);
+
+    // a scenario that came within the rounding of the tolerance without converging may
+    // converge in double, and the penalty is far outside any rounding error, so those few
+    // are solved again in double, on their own
+    vector<int> unsure;
+    for (int k = 0; k < scenarios.count; k++)
+    {
+        if (!converged[k] && closest_error[k] <= tolerance * (1 + CONVERGENCE_BAND))
+        {
+            unsure.push_back(k);
+        }
+    }
+    if (unsure.empty())
+    {
+        return;
+    }
+    int count = unsure.size();
+    vector<double> again_feed_gormanium(count), again_feed_waste(count);
+    vector<double> again_fraction_gormanium(n * count), again_fraction_waste(n * count);
+    for (int j = 0; j < count; j++)
+    {
+        int k = unsure[j];
+        again_feed_gormanium[j] = scenarios.feed_gormanium[k];
+        again_feed_waste[j] = scenarios.feed_waste[k];
+        for (int i = 0; i < n; i++)
+        {
+            again_fraction_gormanium[i * count + j] = scenarios.fraction_gormanium[i * scenarios.count + k];
+            again_fraction_waste[i * count + j] = scenarios.fraction_waste[i * scenarios.count + k];
+        }
+    }
+    vector<double> again_conc_gormanium, again_conc_waste;
+    vector<char> again_converged;
+    Scenario_Kernel(circuit_vector, count, again_feed_gormanium.data(), again_feed_waste.data(),
+                    again_fraction_gormanium.data(), again_fraction_waste.data(), tolerance, max_iterations,
+                    again_conc_gormanium, again_conc_waste, again_converged, closest_error);
+    for (int j = 0; j < count; j++)
+    {
+        int k = unsure[j];
+        conc_gormanium[k] = again_conc_gormanium[j];
+        conc_waste[k] = again_conc_waste[j];
+        converged[k] = again_converged[j];
+    }
+}
+
+double Robust_Performance(
+    const vector<int> &circuit_vector,
+    const ScenarioSet &scenarios,
+    double price_gormanium,
+    double cost_waste,
+    RobustObjective objective,
+    bool single_precision)
+{
+    vector<double> conc_gormanium, conc_waste;
+    vector<char> converged;
+    try
+    {
+        Evaluate_Scenario_Flows(circuit_vector, scenarios, conc_gormanium, conc_waste, converged, 1e-4, 1000,
+                                single_precision);
+    }
+    catch (const int error_code)
+    {
+        throw "Mass continuity FAILED!";
+    }
+
+    double sum = 0.0;
+    double worst = 0.0;
+    for (int k = 0; k < scenarios.count; k++)
+    {
+        double performance = conc_gormanium[k] * price_gormanium - conc_waste[k] * cost_waste;
+        sum += performance;
+        worst = k == 0 ? performance : min(worst, performance);
+    }
+    return objective == RobustObjective::Worst_Case ? worst : sum / scenarios.count;
+}
+
+void Robust_Population_Performance(
+    const vector<vector<int>> &population,
+    const ScenarioSet &scenarios,
+    double price_gormanium,
+    double cost_waste,
+    RobustObjective objective,
+    vector<double> &performance,
+    bool single_precision)
+{
+    performance.assign(population.size(), 0.0);
+    utils::Parallel_For(0, population.size(), [&](int i) {
+        performance[i] = Robust_Performance(population[i], scenarios, price_gormanium, cost_waste, objective,
+                                            single_precision);
+    });
+}
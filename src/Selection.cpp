@@ -0,0 +1,220 @@
+#include "Selection.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+
+using namespace std;
+
+void Probability(int population_size, const vector<double> &fitness, vector<double> &probability)
+{
+    double sum = accumulate(fitness.begin(), fitness.end(), 0);
+    double pro = 0.0;
+
+    // Roulette method
+    for (int i = 0; i < population_size; i++)
+    {
+        pro += ((fitness[i]) / sum);
+        probability.push_back(pro);
+    }
+
+    return;
+}
+
+int Choose_Cross(const vector<double> &probability)
+{
+    double num = (rand() % 1000) * 0.001 + 0.001;
+    return Choose_Cross(probability, num);
+}
+
+int Choose_Cross(const vector<double> &probability, mt19937 &rng)
+{
+    double num = uniform_int_distribution<int>(0, 999)(rng) * 0.001 + 0.001;
+    return Choose_Cross(probability, num);
+}
+
+int Choose_Cross(const vector<double> &probability, double num)
+{
+    if (num < probability[0])
+    {
+        return 0;
+    }
+    // Binary search
+    int low = 1;
+    int high = probability.size();
+    int mid = (low + high) / 2;
+
+    while (low < high)
+    {
+        if (num > probability[mid])
+        {
+            low = mid;
+            mid = (high + low) / 2;
+        }
+        else if (num <= probability[mid - 1])
+        {
+            high = mid;
+            mid = (high + low) / 2;
+        }
+        else
+        {
+            return mid;
+        }
+    }
+    //return high;
+    return mid;
+}
+
+AliasTable::AliasTable(const vector<double> &weights) : probability_(weights.size(), 1.0),
+                                                        alias_(weights.size())
+{
+    int n = weights.size();
+    double sum = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += max(weights[i], 0.0);
+    }
+    iota(alias_.begin(), alias_.end(), 0);
+    if (n == 0 || sum <= 0.0)
+    {
+        // uniform, every column keeps its own index
+        return;
+    }
+
+    // scale the weights so that their average is 1, then split them into the
+    // columns holding less than their share and those holding more
+    vector<int> small, large;
+    for (int i = 0; i < n; i++)
+    {
+        probability_[i] = max(weights[i], 0.0) * n / sum;
+        if (probability_[i] < 1.0)
+        {
+            small.push_back(i);
+        }
+        else
+        {
+            large.push_back(i);
+        }
+    }
+    // fill each small column with the excess of a large one
+    while (!small.empty() && !large.empty())
+    {
+        int s = small.back();
+        small.pop_back();
+        int l = large.back();
+        alias_[s] = l;
+        probability_[l] -= 1.0 - probability_[s];
+        if (probability_[l] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // whatever is left is only off by rounding errors
+    for (int i : small)
+    {
+        probability_[i] = 1.0;
+    }
+    for (int i : large)
+    {
+        probability_[i] = 1.0;
+    }
+}
+
+int AliasTable::Sample(mt19937 &rng) const
+{
+    uniform_int_distribution<int> column(0, probability_.size() - 1);
+    uniform_real_distribution<double> coin(0.0, 1.0);
+    int i = column(rng);
+    return coin(rng) < probability_[i] ? i : alias_[i];
+}
+
+void Stochastic_Universal_Sampling(const vector<double> &fitness, int count, vector<int> &selected, mt19937 &rng)
+{
+    int n = fitness.size();
+    selected.clear();
+    selected.reserve(count);
+    double sum = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += max(fitness[i], 0.0);
+    }
+    if (sum <= 0.0)
+    {
+        uniform_int_distribution<int> uniform(0, n - 1);
+        for (int k = 0; k < count; k++)
+        {
+            selected.push_back(uniform(rng));
+        }
+        return;
+    }
+
+    // one random offset, then evenly spaced pointers along the cumulative fitness
+    double step = sum / count;
+    double pointer = uniform_real_distribution<double>(0.0, step)(rng);
+    double cumulative = 0.0;
+    int i = 0;
+    for (int k = 0; k < count; k++)
+    {
+        while (i < n - 1 && cumulative + max(fitness[i], 0.0) <= pointer)
+        {
+            cumulative += max(fitness[i], 0.0);
+            i++;
+        }
+        selected.push_back(i);
+        pointer += step;
+    }
+    shuffle(selected.begin(), selected.end(), rng);
+}
+
+int Tournament_Selection(const vector<double> &fitness, int size, mt19937 &rng)
+{
+    uniform_int_distribution<int> uniform(0, fitness.size() - 1);
+    int best = uniform(rng);
+    for (int k = 1; k < size; k++)
+    {
+        int challenger = uniform(rng);
+        if (fitness[challenger] > fitness[best])
+        {
+            best = challenger;
+        }
+    }
+    return best;
+}
+
+ParentSelector::ParentSelector(const vector<double> &fitness, SelectionMethod method, int tournament_size)
+    : fitness_{fitness},
+      method_{method},
+      tournament_size_{tournament_size},
+      table_{method == SelectionMethod::Alias ? fitness : vector<double>()}
+{
+    if (method_ == SelectionMethod::Roulette)
+    {
+        Probability(fitness_.size(), fitness_, probability_);
+    }
+}
+
+int ParentSelector::Next(mt19937 &rng)
+{
+    switch (method_)
+    {
+    case SelectionMethod::Roulette:
+        return Choose_Cross(probability_, rng);
+    case SelectionMethod::Alias:
+        return table_.Sample(rng);
+    case SelectionMethod::Stochastic_Universal:
+        if (sampled_.empty())
+        {
+            // a whole generation worth of parents at a time
+            Stochastic_Universal_Sampling(fitness_, fitness_.size(), sampled_, rng);
+        }
+        {
+            int index = sampled_.back();
+            sampled_.pop_back();
+            return index;
+        }
+    case SelectionMethod::Tournament:
+    default:
+        return Tournament_Selection(fitness_, tournament_size_, rng);
+    }
+}
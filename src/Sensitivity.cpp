@@ -0,0 +1,101 @@
+#include "Sensitivity.h"
+#include "Genetic_Algorithm.h"
+
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+    /*
+    Adjoint of the flows of one material: recovery[i] is the fraction of the material fed into
+    unit i that reaches the final concentrate, with recovery[n] = 1 and recovery[n + 1] = 0.
+    Solved by successive substitution on the transposed circuit, the connectivity being read
+    the other way round: every unit pulls the recovery of its two destinations.
+    */
+    void Recovery(
+        const vector<int> &circuit_vector,
+        const vector<double> &fraction,
+        double tolerance,
+        int max_iterations,
+        vector<double> &recovery)
+    {
+        int n = (circuit_vector.size() - 1) / 2;
+        vector<double> new_recovery(n + 2, 0.0);
+        recovery.assign(n + 2, 0.0);
+        recovery[n] = new_recovery[n] = 1.0;
+
+        for (int it = 0; it < max_iterations; it++)
+        {
+            bool exceeds_tolerance = false;
+            for (int i = 0; i < n; i++)
+            {
+                new_recovery[i] = fraction[i] * recovery[circuit_vector[i * 2 + 1]] +
+                                  (1 - fraction[i]) * recovery[circuit_vector[i * 2 + 2]];
+                // every unit of a valid circuit eventually reaches the concentrate, a zero
+                // recovery only means that the concentrate is not reached yet
+                if (!(new_recovery[i] > 0.0) || std::abs(new_recovery[i] - recovery[i]) > tolerance * new_recovery[i])
+                {
+                    exceeds_tolerance = true;
+                }
+            }
+            recovery.swap(new_recovery);
+            if (!exceeds_tolerance)
+            {
+                return;
+            }
+        }
+        throw 1;
+    }
+}
+
+void Performance_Sensitivity(
+    const vector<int> &circuit_vector,
+    PerformanceSensitivity &sensitivity,
+    double tolerance,
+    int max_iterations,
+    double gormanium_price,
+    double waste_cost,
+    double input_gormanium,
+    double input_waste,
+    const UnitFractions &fractions)
+{
+    // forward solve, which also checks the fractions and the mass balance
+    int n = (circuit_vector.size() - 1) / 2;
+    vector<double> feed_gormanium(n + 2), feed_waste(n + 2);
+    Evaluate_Flows(feed_gormanium, feed_waste, circuit_vector, tolerance, max_iterations,
+                   gormanium_price, waste_cost, input_gormanium, input_waste, fractions);
+
+    // adjoint solves, one per material
+    vector<double> fraction_gormanium(n), fraction_waste(n);
+    for (int i = 0; i < n; i++)
+    {
+        fraction_gormanium[i] = fractions.gormanium_of(i);
+        fraction_waste[i] = fractions.waste_of(i);
+    }
+    vector<double> recovery_gormanium, recovery_waste;
+    Recovery(circuit_vector, fraction_gormanium, tolerance, max_iterations, recovery_gormanium);
+    Recovery(circuit_vector, fraction_waste, tolerance, max_iterations, recovery_waste);
+
+    sensitivity.conc_gormanium = feed_gormanium[n];
+    sensitivity.conc_waste = feed_waste[n];
+    sensitivity.performance = feed_gormanium[n] * gormanium_price - feed_waste[n] * waste_cost;
+    sensitivity.price_gormanium = feed_gormanium[n];
+    sensitivity.cost_waste = -feed_waste[n];
+    sensitivity.feed_gormanium = gormanium_price * recovery_gormanium[circuit_vector[0]];
+    sensitivity.feed_waste = -waste_cost * recovery_waste[circuit_vector[0]];
+    sensitivity.fraction_gormanium.resize(n);
+    sensitivity.fraction_waste.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        // a little more of the feed of unit i goes to its concentrate rather than its tailings
+        int concentrate = circuit_vector[i * 2 + 1];
+        int tailings = circuit_vector[i * 2 + 2];
+        sensitivity.fraction_gormanium[i] =
+            gormanium_price * feed_gormanium[i] * (recovery_gormanium[concentrate] - recovery_gormanium[tailings]);
+        sensitivity.fraction_waste[i] =
+            -waste_cost * feed_waste[i] * (recovery_waste[concentrate] - recovery_waste[tailings]);
+    }
+    sensitivity.recovery_gormanium.assign(recovery_gormanium.begin(), recovery_gormanium.begin() + n);
+    sensitivity.recovery_waste.assign(recovery_waste.begin(), recovery_waste.begin() + n);
+}
@@ -0,0 +1,678 @@
+#include "Server.h"
+
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace std;
+
+namespace
+{
+    // longest request line, and deepest nesting of its arrays and objects
+    const size_t MAX_REQUEST_SIZE = 64 << 20;
+    const int MAX_DEPTH = 32;
+    // largest circuits and populations an optimise request may ask for
+    const int MAX_UNITS = 1000;
+    const int MAX_POPULATION_SIZE = 1000000;
+
+    // just enough JSON for the requests: objects, arrays, numbers, strings, literals
+    struct Json
+    {
+        enum Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object
+        };
+        Type type{Null};
+        double number{0.0};
+        string text{};
+        vector<Json> items{};
+        vector<pair<string, Json>> members{};
+
+        const Json *Find(const string &key) const
+        {
+            for (const pair<string, Json> &member : members)
+            {
+                if (member.first == key)
+                {
+                    return &member.second;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    class JsonParser
+    {
+    public:
+        JsonParser(const string &text) : text_{text} {}
+
+        Json Parse()
+        {
+            Json value = Value();
+            Skip_Space();
+            if (position_ != text_.size())
+            {
+                throw invalid_argument("unexpected characters after the request");
+            }
+            return value;
+        }
+
+    private:
+        void Skip_Space()
+        {
+            while (position_ < text_.size() && isspace((unsigned char)text_[position_]))
+            {
+                position_++;
+            }
+        }
+
+        void Expect(char c)
+        {
+            Skip_Space();
+            if (position_ >= text_.size() || text_[position_] != c)
+            {
+                throw invalid_argument(string("expected '") + c + "'");
+            }
+            position_++;
+        }
+
+        string Text()
+        {
+            Expect('"');
+            string out;
+            while (position_ < text_.size() && text_[position_] != '"')
+            {
+                char c = text_[position_++];
+                if (c == '\\' && position_ < text_.size())
+                {
+                    c = text_[position_++];
+                    c = c == 'n' ? '\n' : c == 't' ? '\t' : c;
+                }
+                out += c;
+            }
+            Expect('"');
+            return out;
+        }
+
+        Json Value()
+        {
+            Skip_Space();
+            if (position_ >= text_.size())
+            {
+                throw invalid_argument("unexpected end of the request");
+            }
+            Json value;
+            char c = text_[position_];
+            if ((c == '{' || c == '[') && depth_ == MAX_DEPTH)
+            {
+                throw invalid_argument("the request is nested more than " + to_string(MAX_DEPTH) + " levels deep");
+            }
+            if (c == '{')
+            {
+                depth_++;
+                value.type = Json::Object;
+                position_++;
+                Skip_Space();
+                if (position_ < text_.size() && text_[position_] == '}')
+                {
+                    position_++;
+                    depth_--;
+                    return value;
+                }
+                do
+                {
+                    string key = Text();
+                    Expect(':');
+                    value.members.emplace_back(key, Value());
+                    Skip_Space();
+                } while (position_ < text_.size() && text_[position_] == ',' && ++position_);
+                Expect('}');
+                depth_--;
+            }
+            else if (c == '[')
+            {
+                depth_++;
+                value.type = Json::Array;
+                position_++;
+                Skip_Space();
+                if (position_ < text_.size() && text_[position_] == ']')
+                {
+                    position_++;
+                    depth_--;
+                    return value;
+                }
+                do
+                {
+                    value.items.push_back(Value());
+                    Skip_Space();
+                } while (position_ < text_.size() && text_[position_] == ',' && ++position_);
+                Expect(']');
+                depth_--;
+            }
+            else if (c == '"')
+            {
+                value.type = Json::String;
+                value.text = Text();
+            }
+            else if (text_.compare(position_, 4, "true") == 0 || text_.compare(position_, 5, "false") == 0)
+            {
+                value.type = Json::Bool;
+                value.number = c == 't';
+                position_ += c == 't' ? 4 : 5;
+            }
+            else if (text_.compare(position_, 4, "null") == 0)
+            {
+                position_ += 4;
+            }
+            else
+            {
+                value.type = Json::Number;
+                const char *begin = text_.data() + position_;
+                from_chars_result result = from_chars(begin, text_.data() + text_.size(), value.number);
+                if (result.ec != errc())
+                {
+                    throw invalid_argument("bad value");
+                }
+                position_ += result.ptr - begin;
+            }
+            return value;
+        }
+
+        const string &text_;
+        size_t position_{0};
+        int depth_{0};
+    };
+
+    template <typename T>
+    void Append_Number(string &out, T value)
+    {
+        char digits[32];
+        to_chars_result result = to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    template <typename T>
+    void Append_List(string &out, const char *key, const vector<T> &values)
+    {
+        out += ", \"";
+        out += key;
+        out += "\": [";
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            if (i != 0)
+            {
+                out += ", ";
+            }
+            Append_Number(out, values[i]);
+        }
+        out += ']';
+    }
+
+    void Append_Text(string &out, const string &text)
+    {
+        out += '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+            }
+            out += c == '\n' ? ' ' : c;
+        }
+        out += '"';
+    }
+
+    double Number_Field(const Json &request, const string &key, double fallback)
+    {
+        const Json *field = request.Find(key);
+        if (field == nullptr)
+        {
+            return fallback;
+        }
+        if (field->type != Json::Number || !isfinite(field->number))
+        {
+            throw invalid_argument(key + " must be a number");
+        }
+        return field->number;
+    }
+
+    // an integer field, from minimum to maximum
+    long long Integer_Field(const Json &request, const string &key, long long fallback, long long minimum,
+                            long long maximum)
+    {
+        double value = Number_Field(request, key, fallback);
+        if (value != floor(value) || value < minimum || value > maximum)
+        {
+            throw invalid_argument(key + " must be an integer from " + to_string(minimum) + " to " +
+                                   to_string(maximum));
+        }
+        return (long long)value;
+    }
+
+    // the circuits of a request, nullopt-like empty gene for a malformed one
+    vector<vector<int>> Circuits_Field(const Json &request)
+    {
+        const Json *field = request.Find("circuits");
+        if (field == nullptr || field->type != Json::Array)
+        {
+            throw invalid_argument("circuits must be a list of circuits");
+        }
+        vector<vector<int>> circuits;
+        circuits.reserve(field->items.size());
+        for (const Json &item : field->items)
+        {
+            vector<int> circuit;
+            bool good = item.type == Json::Array && item.items.size() % 2 == 1 && item.items.size() >= 3;
+            int n = (item.items.size() - 1) / 2;
+            for (size_t i = 0; good && i < item.items.size(); i++)
+            {
+                double gene = item.items[i].number;
+                // the feed goes to a unit, the outputs to a unit or a final stream
+                good = item.items[i].type == Json::Number && gene == (int)gene && gene >= 0 &&
+                       gene <= (i == 0 ? n - 1 : n + 1);
+                circuit.push_back(gene);
+            }
+            circuits.push_back(good ? circuit : vector<int>());
+        }
+        return circuits;
+    }
+}
+
+CircuitServer::CircuitServer(const string &socket_path, const SolverConfig &config)
+    : socket_path_{socket_path}, config_{config}
+{
+    if (!config_.evaluation_database.empty())
+    {
+        database_.reset(new EvaluationDatabase(config_.evaluation_database, config_.num_units[0]));
+    }
+    if (!config_.design_index.empty())
+    {
+        design_index_.reset(new DesignIndex(config_.design_index));
+    }
+    evaluator_ = thread(&CircuitServer::Evaluation_Loop, this);
+}
+
+CircuitServer::~CircuitServer()
+{
+    Stop();
+    {
+        lock_guard<mutex> guard(clients_lock_);
+#ifndef _WIN32
+        for (pair<const int, thread> &client : clients_)
+        {
+            shutdown(client.first, SHUT_RDWR);
+        }
+#endif
+    }
+    for (pair<const int, thread> &client : clients_)
+    {
+        client.second.join();
+#ifndef _WIN32
+        close(client.first);
+#endif
+    }
+    {
+        lock_guard<mutex> guard(queue_lock_);
+        closing_ = true;
+    }
+    queue_ready_.notify_all();
+    evaluator_.join();
+}
+
+ServerStats CircuitServer::Stats() const
+{
+    return {requests_.load(), evaluations_.load(), batches_.load()};
+}
+
+void CircuitServer::Evaluate(PendingEvaluation &pending)
+{
+    unique_lock<mutex> guard(queue_lock_);
+    queue_.push_back(&pending);
+    queue_ready_.notify_one();
+    evaluated_.wait(guard, [&pending] { return pending.done; });
+}
+
+void CircuitServer::Evaluation_Loop()
+{
+    unique_lock<mutex> guard(queue_lock_);
+    while (true)
+    {
+        queue_ready_.wait(guard, [this] { return closing_ || !queue_.empty(); });
+        if (queue_.empty())
+        {
+            return;
+        }
+        // everything queued while the previous batch was evaluated forms the next one
+        deque<PendingEvaluation *> batch;
+        batch.swap(queue_);
+        guard.unlock();
+
+        // one population per feed, as the flows depend on it
+        while (!batch.empty())
+        {
+            double flow_rate_gormanium = batch.front()->flow_rate_gormanium;
+            double flow_rate_waste = batch.front()->flow_rate_waste;
+            vector<PendingEvaluation *> group;
+            vector<vector<int>> population;
+            for (auto it = batch.begin(); it != batch.end();)
+            {
+                if ((*it)->flow_rate_gormanium == flow_rate_gormanium && (*it)->flow_rate_waste == flow_rate_waste)
+                {
+                    group.push_back(*it);
+                    population.insert(population.end(), (*it)->circuits->begin(), (*it)->circuits->end());
+                    it = batch.erase(it);
+                }
+                else
+                {
+                    it++;
+                }
+            }
+            PopulationFlows flows;
+            string error;
+            try
+            {
+                Evaluate_Population_Flows(population, flows, 1e-4, 1000, flow_rate_gormanium, flow_rate_waste,
+                                          database_.get());
+            }
+            catch (const char *message)
+            {
+                error = message;
+            }
+            batches_.fetch_add(1, memory_order_relaxed);
+            evaluations_.fetch_add(population.size(), memory_order_relaxed);
+
+            size_t offset = 0;
+            for (PendingEvaluation *pending : group)
+            {
+                size_t size = pending->circuits->size();
+                if (error.empty())
+                {
+                    pending->conc_gormanium.assign(flows.conc_gormanium.begin() + offset, flows.conc_gormanium.begin() + offset + size);
+                    pending->conc_waste.assign(flows.conc_waste.begin() + offset, flows.conc_waste.begin() + offset + size);
+                }
+                pending->error = error;
+                offset += size;
+            }
+            guard.lock();
+            for (PendingEvaluation *pending : group)
+            {
+                pending->done = true;
+            }
+            evaluated_.notify_all();
+            guard.unlock();
+        }
+        guard.lock();
+    }
+}
+
+string CircuitServer::Handle(const string &request_text)
+{
+    requests_.fetch_add(1, memory_order_relaxed);
+    string answer = "{";
+    const Json *id = nullptr;
+    Json request;
+    try
+    {
+        if (request_text.size() > MAX_REQUEST_SIZE)
+        {
+            throw invalid_argument("the request is longer than " + to_string(MAX_REQUEST_SIZE) + " bytes");
+        }
+        request = JsonParser(request_text).Parse();
+        if (request.type != Json::Object)
+        {
+            throw invalid_argument("a request must be a JSON object");
+        }
+        id = request.Find("id");
+        if (id != nullptr)
+        {
+            answer += "\"id\": ";
+            if (id->type == Json::String)
+            {
+                Append_Text(answer, id->text);
+            }
+            else
+            {
+                Append_Number(answer, id->number);
+            }
+            answer += ", ";
+        }
+        const Json *type = request.Find("type");
+        if (type == nullptr || type->type != Json::String)
+        {
+            throw invalid_argument("missing type");
+        }
+        double flow_rate_gormanium = Number_Field(request, "flow_rate_gormanium", config_.flow_rate_gormanium[0]);
+        double flow_rate_waste = Number_Field(request, "flow_rate_waste", config_.flow_rate_waste[0]);
+        double price_gormanium = Number_Field(request, "price_gormanium", config_.price_gormanium[0]);
+        double cost_waste = Number_Field(request, "cost_waste", config_.cost_waste[0]);
+
+        string body;
+        if (type->text == "evaluate")
+        {
+            vector<vector<int>> circuits = Circuits_Field(request);
+            // the flows of invalid circuits may not be defined, and would fail the whole batch
+            for (size_t i = 0; i < circuits.size(); i++)
+            {
+                if (circuits[i].empty() || utils::Check_Validity(circuits[i]) != 0)
+                {
+                    throw invalid_argument("circuit " + to_string(i) + " is not valid");
+                }
+            }
+            PendingEvaluation pending{&circuits, flow_rate_gormanium, flow_rate_waste};
+            Evaluate(pending);
+            if (!pending.error.empty())
+            {
+                throw runtime_error(pending.error);
+            }
+            vector<double> performance;
+            PopulationFlows flows{pending.conc_gormanium, pending.conc_waste, {}};
+            Reprice_Population(flows, vector<double>{price_gormanium}, vector<double>{cost_waste}, performance);
+            body += "\"type\": \"evaluate\"";
+            Append_List(body, "performance", performance);
+            Append_List(body, "concentrate_gormanium", pending.conc_gormanium);
+            Append_List(body, "concentrate_waste", pending.conc_waste);
+        }
+        else if (type->text == "validate")
+        {
+            vector<int> valid;
+            for (const vector<int> &circuit : Circuits_Field(request))
+            {
+                valid.push_back(circuit.empty() ? -1 : utils::Check_Validity(circuit));
+            }
+            body += "\"type\": \"validate\"";
+            Append_List(body, "valid", valid);
+        }
+        else if (type->text == "optimise" || type->text == "optimize")
+        {
+            int num_units = Integer_Field(request, "num_units", config_.num_units[0], 2, MAX_UNITS);
+            double seconds = Number_Field(request, "seconds", 0.0);
+            if (seconds <= 0.0)
+            {
+                throw invalid_argument("optimise needs a positive number of seconds");
+            }
+            int population_size =
+                Integer_Field(request, "population_size", config_.population_size, 2, MAX_POPULATION_SIZE);
+            int max_iterations = Integer_Field(request, "max_iterations", config_.max_iterations, 1, INT_MAX);
+            int threshold = Integer_Field(request, "threshold", config_.threshold, 1, INT_MAX);
+            GeneticOptions options = config_.options;
+            options.time_limit = seconds;
+            options.seed = Integer_Field(request, "seed", config_.options.seed, 0, UINT_MAX);
+            options.design_index = design_index_.get();
+            options.evaluation_database = num_units == config_.num_units[0] ? database_.get() : nullptr;
+            options.checkpoint_path.clear();
+            options.generation_log.clear();
+            options.archive = nullptr;
+            options.hall_of_fame = nullptr;
+            vector<double> adaptive_rate = config_.adaptive_rate;
+            vector<int> circuit = Genetic_Optimization(
+                population_size,
+                max_iterations,
+                threshold,
+                adaptive_rate,
+                num_units,
+                flow_rate_gormanium,
+                flow_rate_waste,
+                price_gormanium,
+                cost_waste,
+                options
+            );
+            double performance = Evaluate_Circuit(circuit, false, 0, 1e-4, 1000, price_gormanium, cost_waste,
+                                                  flow_rate_gormanium, flow_rate_waste);
+            body += "\"type\": \"optimise\"";
+            Append_List(body, "circuit", circuit);
+            body += ", \"performance\": ";
+            Append_Number(body, performance);
+        }
+        else
+        {
+            throw invalid_argument("unknown type " + type->text);
+        }
+        answer += body;
+    }
+    catch (const exception &e)
+    {
+        answer += "\"error\": ";
+        Append_Text(answer, e.what());
+    }
+    catch (const char *message)
+    {
+        answer += "\"error\": ";
+        Append_Text(answer, message);
+    }
+    answer += '}';
+    return answer;
+}
+
+#ifdef _WIN32
+
+void CircuitServer::Run()
+{
+    throw runtime_error("The server needs Unix domain sockets");
+}
+
+void CircuitServer::Serve_Connection(int client)
+{
+}
+
+#else
+
+void CircuitServer::Run()
+{
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (listener < 0 || socket_path_.size() >= sizeof(address.sun_path))
+    {
+        throw runtime_error("Cannot create socket " + socket_path_);
+    }
+    strcpy(address.sun_path, socket_path_.c_str());
+    unlink(socket_path_.c_str());
+    if (::bind(listener, (sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 64) != 0)
+    {
+        close(listener);
+        throw runtime_error("Cannot listen on " + socket_path_ + ": " + strerror(errno));
+    }
+
+    // poll with a timeout, so that Stop only has to set a flag
+    while (!stop_.load())
+    {
+        pollfd waiting{listener, POLLIN, 0};
+        if (poll(&waiting, 1, 100) > 0)
+        {
+            int client = accept(listener, nullptr, nullptr);
+            if (client >= 0)
+            {
+                lock_guard<mutex> guard(clients_lock_);
+                clients_[client] = thread(&CircuitServer::Serve_Connection, this, client);
+            }
+        }
+        lock_guard<mutex> guard(clients_lock_);
+        for (int client : finished_)
+        {
+            clients_[client].join();
+            clients_.erase(client);
+            close(client);
+        }
+        finished_.clear();
+    }
+    close(listener);
+    unlink(socket_path_.c_str());
+}
+
+void CircuitServer::Serve_Connection(int client)
+{
+    string pending;
+    char buffer[65536];
+    // the rest of a line too long to be answered is dropped, its error already sent
+    bool skipping = false;
+    while (true)
+    {
+        ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            break;
+        }
+        pending.append(buffer, received);
+        // answer every complete line, all in one write
+        string answers;
+        size_t start = 0, end;
+        while ((end = pending.find('\n', start)) != string::npos)
+        {
+            if (skipping)
+            {
+                skipping = false;
+            }
+            else if (end > start)
+            {
+                answers += Handle(pending.substr(start, end - start));
+                answers += '\n';
+            }
+            start = end + 1;
+        }
+        pending.erase(0, start);
+        if (skipping)
+        {
+            pending.clear();
+        }
+        else if (pending.size() > MAX_REQUEST_SIZE)
+        {
+            answers += Handle(pending);
+            answers += '\n';
+            pending.clear();
+            skipping = true;
+        }
+        for (size_t sent = 0; sent < answers.size();)
+        {
+            ssize_t written = send(client, answers.data() + sent, answers.size() - sent, MSG_NOSIGNAL);
+            if (written <= 0)
+            {
+                break;
+            }
+            sent += written;
+        }
+    }
+    lock_guard<mutex> guard(clients_lock_);
+    finished_.push_back(client);
+}
+
+#endif
@@ -0,0 +1,215 @@
+#include "Steady_State.h"
+#include "utils.h"
+
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <omp.h>
+
+using namespace std;
+
+vector<int> Steady_State_Optimization(
+    int population_size,
+    int max_evaluations,
+    int threshold,
+    vector<double> &adaptive_rate,
+    int num_units,
+    double flow_rate_gormanium,
+    double flow_rate_waste,
+    double price_gormanium,
+    double cost_waste,
+    const GeneticOptions &options)
+{
+    // Step 1. Initial population, evaluated as one parallel batch
+    vector<vector<int>> population;
+    vector<double> performance;
+    vector<double> fitness;
+    unsigned seed = options.seed != 0 ? options.seed : random_device()();
+    mt19937 initial_rng(seed);
+    const UnitFractions &fractions = options.fractions;
+    if (!fractions.valid(num_units))
+    {
+        throw invalid_argument("the concentrate fractions are not valid for a circuit of " + to_string(num_units) + " units");
+    }
+    // every circuit is scored under the same scenarios
+    bool robust = options.robust.scenarios > 0;
+    ScenarioSet scenarios;
+    if (robust)
+    {
+        scenarios = Sample_Scenarios(num_units, flow_rate_gormanium, flow_rate_waste, fractions, options.robust);
+    }
+    // relabelling only keeps the performance when all the units are the same
+    bool canonical_labels = options.canonical_labels && fractions.uniform() && !robust;
+    // only the scenario kernel gains from single precision, and how far a performance it
+    // screens can be from the double one depends on the largest feed rates of the scenarios
+    bool screening = robust && options.single_precision;
+    double screening_margin = 0.0;
+    if (screening)
+    {
+        screening_margin = Screening_Margin(
+            1e-4, price_gormanium, cost_waste,
+            *max_element(scenarios.feed_gormanium.begin(), scenarios.feed_gormanium.end()),
+            *max_element(scenarios.feed_waste.begin(), scenarios.feed_waste.end()));
+    }
+    Generate_Initial(population_size, population, num_units, initial_rng);
+    if (canonical_labels)
+    {
+        for (vector<int> &circuit : population)
+        {
+            circuit = utils::Canonical_Circuit(circuit);
+        }
+    }
+    if (screening)
+    {
+        // the best circuit is the one returned, it needs its double precision performance
+        Screen_Robust_Population(population, scenarios, price_gormanium, cost_waste, options.robust.objective,
+                                 performance, screening_margin);
+    }
+    else if (robust)
+    {
+        Robust_Population_Performance(population, scenarios, price_gormanium, cost_waste, options.robust.objective,
+                                      performance);
+    }
+    else
+    {
+        PopulationFlows flows;
+        Evaluate_Population_Flows(population, flows, 1e-4, 1000, flow_rate_gormanium, flow_rate_waste,
+                                  options.evaluation_database, fractions);
+        Reprice_Population(flows, vector<double>{price_gormanium}, vector<double>{cost_waste}, performance);
+    }
+    Fitness(population_size, performance, fitness);
+
+    // State shared by the workers, only accessed while holding `lock`
+    mutex lock;
+    multiset<vector<int>> members(population.begin(), population.end());
+    double fitness_sum = accumulate(fitness.begin(), fitness.end(), 0.0);
+    int best = max_element(fitness.begin(), fitness.end()) - fitness.begin();
+    double old_best_performance = performance[best];
+    int evaluations = 0;
+    int since_improvement = 0;
+    bool done = false;
+
+    // Step 2. Every worker breeds, evaluates and inserts children until the budget is spent
+#pragma omp parallel
+    {
+        mt19937 rng(seed + omp_get_thread_num());
+        uniform_int_distribution<int> uniform(0, population_size - 1);
+        while (true)
+        {
+            vector<int> father, mother;
+            double f, f_max, f_avg, f_min;
+            {
+                lock_guard<mutex> guard(lock);
+                if (done)
+                {
+                    break;
+                }
+                int father_index = Tournament_Selection(fitness, options.tournament_size, rng);
+                int mother_index = Tournament_Selection(fitness, options.tournament_size, rng);
+                father = population[father_index];
+                mother = population[mother_index];
+                f = Find_Better_Fitness(father_index, mother_index, fitness);
+                f_max = fitness[best];
+                f_avg = fitness_sum / population_size;
+                f_min = *min_element(fitness.begin(), fitness.end());
+            }
+
+            Crossover(f_max, f_avg, f, adaptive_rate, father, mother, num_units, rng);
+            for (vector<int> *child : {&father, &mother})
+            {
+                Mutation(f, f_max, f_avg, f, adaptive_rate, *child, num_units, rng);
+                if (canonical_labels)
+                {
+                    *child = utils::Canonical_Circuit(*child);
+                }
+                if (utils::Check_Validity(*child) != 0)
+                {
+                    continue;
+                }
+                // the expensive part, done without holding the lock. A child screened in single
+                // precision that cannot beat the worst circuit is never inserted, the others are
+                // evaluated again in double
+                double child_performance;
+                if (robust)
+                {
+                    child_performance = Robust_Performance(*child, scenarios, price_gormanium, cost_waste,
+                                                           options.robust.objective, screening);
+                    if (screening && child_performance + 50000 + screening_margin >= f_min)
+                    {
+                        child_performance = Robust_Performance(*child, scenarios, price_gormanium, cost_waste,
+                                                               options.robust.objective);
+                    }
+                }
+                else
+                {
+                    child_performance = Evaluate_Circuit(
+                        *child,
+                        false,
+                        0,
+                        1e-4,
+                        1000,
+                        price_gormanium,
+                        cost_waste,
+                        flow_rate_gormanium,
+                        flow_rate_waste,
+                        fractions
+                    );
+                }
+                double child_fitness = child_performance + 50000;
+
+                lock_guard<mutex> guard(lock);
+                if (done)
+                {
+                    break;
+                }
+                evaluations++;
+                since_improvement++;
+                if (members.count(*child) == 0)
+                {
+                    // pick the circuit to replace
+                    int victim;
+                    if (options.replace_worst)
+                    {
+                        victim = min_element(fitness.begin(), fitness.end()) - fitness.begin();
+                    }
+                    else
+                    {
+                        victim = uniform(rng);
+                        for (int k = 1; k < options.tournament_size; k++)
+                        {
+                            int challenger = uniform(rng);
+                            if (fitness[challenger] < fitness[victim])
+                            {
+                                victim = challenger;
+                            }
+                        }
+                    }
+                    if (child_fitness > fitness[victim])
+                    {
+                        bool new_best = child_fitness > fitness[best];
+                        members.erase(members.find(population[victim]));
+                        members.insert(*child);
+                        fitness_sum += child_fitness - fitness[victim];
+                        population[victim] = *child;
+                        performance[victim] = child_performance;
+                        fitness[victim] = child_fitness;
+                        if (new_best)
+                        {
+                            best = victim;
+                        }
+                        if (performance[best] - old_best_performance > 0.1)
+                        {
+                            old_best_performance = performance[best];
+                            since_improvement = 0;
+                        }
+                    }
+                }
+                if (evaluations >= max_evaluations || since_improvement >= threshold)
+                {
+                    done = true;
+                }
+            }
+        }
+    }
+    return population[best];
+}
@@ -0,0 +1,236 @@
+#include "Sweep.h"
+#include "utils.h"
+
+#include <array>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+
+using namespace std;
+
+namespace
+{
+    const int DIMENSIONS = 5;
+
+    array<int, DIMENSIONS> Grid_Sizes(const SolverConfig &config)
+    {
+        return {(int)config.num_units.size(),
+                (int)config.flow_rate_gormanium.size(),
+                (int)config.flow_rate_waste.size(),
+                (int)config.price_gormanium.size(),
+                (int)config.cost_waste.size()};
+    }
+
+    // grid indices of point p, the last dimension varying fastest
+    array<int, DIMENSIONS> Grid_Indices(int p, const array<int, DIMENSIONS> &sizes)
+    {
+        array<int, DIMENSIONS> indices;
+        for (int d = DIMENSIONS - 1; d >= 0; d--)
+        {
+            indices[d] = p % sizes[d];
+            p /= sizes[d];
+        }
+        return indices;
+    }
+
+    int Grid_Point(const array<int, DIMENSIONS> &indices, const array<int, DIMENSIONS> &sizes)
+    {
+        int p = 0;
+        for (int d = 0; d < DIMENSIONS; d++)
+        {
+            p = p * sizes[d] + indices[d];
+        }
+        return p;
+    }
+}
+
+vector<SweepPoint> Sweep_Grid(const SolverConfig &config)
+{
+    array<int, DIMENSIONS> sizes = Grid_Sizes(config);
+    int total = sizes[0] * sizes[1] * sizes[2] * sizes[3] * sizes[4];
+    vector<SweepPoint> grid(total);
+    for (int p = 0; p < total; p++)
+    {
+        array<int, DIMENSIONS> indices = Grid_Indices(p, sizes);
+        grid[p].num_units = config.num_units[indices[0]];
+        grid[p].flow_rate_gormanium = config.flow_rate_gormanium[indices[1]];
+        grid[p].flow_rate_waste = config.flow_rate_waste[indices[2]];
+        grid[p].price_gormanium = config.price_gormanium[indices[3]];
+        grid[p].cost_waste = config.cost_waste[indices[4]];
+    }
+    return grid;
+}
+
+vector<SweepResult> Sweep_Optimization(const SolverConfig &config)
+{
+    vector<SweepPoint> grid = Sweep_Grid(config);
+    array<int, DIMENSIONS> sizes = Grid_Sizes(config);
+    vector<SweepResult> results(grid.size());
+
+    // the waves, by sum of the grid indices
+    map<int, vector<int>> waves;
+    for (int p = 0; p < (int)grid.size(); p++)
+    {
+        array<int, DIMENSIONS> indices = Grid_Indices(p, sizes);
+        waves[indices[0] + indices[1] + indices[2] + indices[3] + indices[4]].push_back(p);
+    }
+
+    // one evaluation database per number of units, shared by all the points
+    map<int, unique_ptr<EvaluationDatabase>> databases;
+    if (!config.evaluation_database.empty())
+    {
+        for (int num_units : config.num_units)
+        {
+            string path = config.evaluation_database;
+            if (config.num_units.size() > 1)
+            {
+                path += "_" + to_string(num_units);
+            }
+            databases[num_units].reset(new EvaluationDatabase(path, num_units));
+        }
+    }
+
+    // best circuits of past problems, grown by the results of this sweep
+    unique_ptr<DesignIndex> design_index;
+    if (!config.design_index.empty())
+    {
+        design_index.reset(new DesignIndex(config.design_index));
+    }
+
+    int injection = config.hall_of_fame_injection >= 0 ? config.hall_of_fame_injection : config.threshold / 3;
+    int num_warm = (int)(config.options.warm_start * config.population_size + 0.5);
+
+    for (const pair<const int, vector<int>> &wave : waves)
+    {
+        const vector<int> &points = wave.second;
+        utils::Parallel_For(0, points.size(), [&](int w) {
+            int p = points[w];
+            const SweepPoint &point = grid[p];
+            SweepResult &result = results[p];
+            result.point = point;
+
+            // warm start from the neighbours solved in the previous wave, taking their
+            // best circuits in turn
+            vector<const vector<vector<int>> *> neighbours;
+            array<int, DIMENSIONS> indices = Grid_Indices(p, sizes);
+            for (int d = 0; d < DIMENSIONS; d++)
+            {
+                if (indices[d] > 0)
+                {
+                    array<int, DIMENSIONS> previous = indices;
+                    previous[d]--;
+                    const SweepResult &neighbour = results[Grid_Point(previous, sizes)];
+                    if (neighbour.point.num_units == point.num_units)
+                    {
+                        neighbours.push_back(&neighbour.best_circuits);
+                    }
+                }
+            }
+            vector<vector<int>> warm;
+            set<vector<int>> seen;
+            for (size_t rank = 0; (int)warm.size() < num_warm; rank++)
+            {
+                bool any = false;
+                for (const vector<vector<int>> *best : neighbours)
+                {
+                    if (rank < best->size() && (int)warm.size() < num_warm)
+                    {
+                        any = true;
+                        if (seen.insert((*best)[rank]).second)
+                        {
+                            warm.push_back((*best)[rank]);
+                        }
+                    }
+                }
+                if (!any)
+                {
+                    break;
+                }
+            }
+            result.warm_started = warm.size();
+
+            HallOfFame hall_of_fame(10);
+            utils::Parallel_For(0, config.runs, [&](int r) {
+                vector<double> adaptive_rate = config.adaptive_rate;
+                GeneticOptions options = config.options;
+                int run = p * config.runs + r;
+                options.run_id = run;
+                options.seed = config.options.seed != 0 ? config.options.seed + run : 0;
+                options.hall_of_fame = &hall_of_fame;
+                options.hall_of_fame_injection = injection;
+                options.initial_circuits = warm;
+                options.archive = nullptr;
+                options.design_index = design_index.get();
+                options.evaluation_database = databases.count(point.num_units) ? databases.at(point.num_units).get() : nullptr;
+                if (!config.checkpoint_directory.empty())
+                {
+                    options.checkpoint_path = config.checkpoint_directory + utils::File_Sep() + "point_" +
+                                              to_string(p) + "_run_" + to_string(r) + ".bin";
+                }
+                vector<int> circuit = Genetic_Optimization(
+                    config.population_size,
+                    config.max_iterations,
+                    config.threshold,
+                    adaptive_rate,
+                    point.num_units,
+                    point.flow_rate_gormanium,
+                    point.flow_rate_waste,
+                    point.price_gormanium,
+                    point.cost_waste,
+                    options
+                );
+                double performance = Evaluate_Circuit(circuit, false, 0, 1e-4, 1000, point.price_gormanium,
+                                                      point.cost_waste, point.flow_rate_gormanium, point.flow_rate_waste,
+                                                      config.options.fractions);
+                hall_of_fame.Submit(circuit, performance);
+            });
+
+            result.performance = hall_of_fame.Best(result.circuit);
+            for (const pair<double, vector<int>> &entry : hall_of_fame.Entries())
+            {
+                result.best_circuits.push_back(entry.second);
+            }
+            vector<double> gormanium(point.num_units + 2), waste(point.num_units + 2);
+            try
+            {
+                Evaluate_Flows(gormanium, waste, result.circuit, 1e-4, 1000, point.price_gormanium,
+                               point.cost_waste, point.flow_rate_gormanium, point.flow_rate_waste,
+                               config.options.fractions);
+                int n = point.num_units;
+                result.recovery = gormanium[n] / point.flow_rate_gormanium;
+                result.grade = gormanium[n] + waste[n] > 0.0 ? gormanium[n] / (gormanium[n] + waste[n]) : 0.0;
+            }
+            catch (const int error_code)
+            {
+                // no converged flows, recovery and grade left at 0
+            }
+        });
+    }
+    return results;
+}
+
+bool Write_Sweep_Table(const string &path, const vector<SweepResult> &results)
+{
+    ofstream out(path);
+    if (!out.good())
+    {
+        return false;
+    }
+    out.precision(10);
+    out << "num_units,flow_rate_gormanium,flow_rate_waste,price_gormanium,cost_waste,"
+        << "performance,recovery,grade,warm_started,circuit\n";
+    for (const SweepResult &result : results)
+    {
+        out << result.point.num_units << ',' << result.point.flow_rate_gormanium << ','
+            << result.point.flow_rate_waste << ',' << result.point.price_gormanium << ','
+            << result.point.cost_waste << ',' << result.performance << ',' << result.recovery << ','
+            << result.grade << ',' << result.warm_started << ',';
+        for (size_t i = 0; i < result.circuit.size(); i++)
+        {
+            out << (i == 0 ? "" : " ") << result.circuit[i];
+        }
+        out << '\n';
+    }
+    return out.good();
+}
@@ -1,96 +1,378 @@
 // local includes
+#include "Archive.h"
+#include "Config.h"
+#include "Exhaustive_Search.h"
 #include "Genetic_Algorithm.h"
+#include "Pareto.h"
+#include "Sensitivity.h"
+#include "Server.h"
+#include "Steady_State.h"
+#include "Sweep.h"
 // system includes
 #include <omp.h>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
 
 using namespace std;
 
-int main(int argc, char *argv[])
+namespace
 {
-    // Pre defined parameters
-    int population_size = 200;           // fixed population size
-    int max_iterations = 10000;          //max number of generations
-    int threshold = 300;                 // threshhold to stop iteration
-    int run_times = 20;                  // multiple executions
-    int num_procs = omp_get_num_procs(); // get the node's total process
-    double ever_best_performance = 0.0;  // Mark the best performance.
-
-    double price_gormanium = 100.0;
-    double cost_waste = 500.0;
-    double flow_rate_gormanium = 10.0;
-    double flow_rate_waste = 100.0;
-
-    // Adaptive Genetic Algotirhm parameters
-    vector<double> adaptive_rate;
-    adaptive_rate.push_back(1.0);
-    adaptive_rate.push_back(0.5);
-    adaptive_rate.push_back(1.0);
-    adaptive_rate.push_back(0.5);
-    vector<int> ever_best_circuit;
+    void Print_Circuit(const vector<int> &circuit)
+    {
+        for (size_t i = 0; i < circuit.size(); i++)
+        {
+            cout << circuit[i] << " ";
+        }
+        cout << endl;
+    }
 
-    // Try multi times get the best result
-    cout << "Multithreads started..." << endl;
-#pragma omp parallel for num_threads(2 * num_procs - 1)
-    for (int i = 0; i < run_times; i++)
-    {
-        vector<int> result = Genetic_Optimization(
-            population_size,
-            max_iterations,
-            threshold,
-            adaptive_rate,
-            10,
-            price_gormanium,
-            cost_waste,
-            flow_rate_gormanium,
-            flow_rate_waste
-        );
-        double current_best_performance = Evaluate_Circuit(
-            result,
-            false,
+    // the performance optimised by the runs, robust when scenarios are set, in which case the
+    // data file still holds the flows under the nominal conditions
+    double Performance(const SolverConfig &config, const vector<int> &circuit, bool write_to_file = false)
+    {
+        const RobustOptions &robust = config.options.robust;
+        if (robust.scenarios > 0)
+        {
+            if (write_to_file)
+            {
+                SolverConfig nominal = config;
+                nominal.options.robust.scenarios = 0;
+                Performance(nominal, circuit, true);
+            }
+            ScenarioSet scenarios = Sample_Scenarios(config.num_units[0], config.flow_rate_gormanium[0],
+                                                     config.flow_rate_waste[0], config.options.fractions, robust);
+            return Robust_Performance(circuit, scenarios, config.price_gormanium[0], config.cost_waste[0],
+                                      robust.objective);
+        }
+        return Evaluate_Circuit(
+            circuit,
+            write_to_file,
             0,
             1e-4,
             1000,
-            price_gormanium,
-            cost_waste,
-            flow_rate_gormanium,
-            flow_rate_waste
+            config.price_gormanium[0],
+            config.cost_waste[0],
+            config.flow_rate_gormanium[0],
+            config.flow_rate_waste[0],
+            config.options.fractions
         );
-        if (ever_best_performance < current_best_performance)
+    }
+
+    // gradient of the nominal performance of a circuit, from one forward and one adjoint solve
+    void Print_Sensitivity(const SolverConfig &config, const vector<int> &circuit)
+    {
+        PerformanceSensitivity sensitivity;
+        try
+        {
+            Performance_Sensitivity(circuit, sensitivity, 1e-6, 100000, config.price_gormanium[0], config.cost_waste[0],
+                                    config.flow_rate_gormanium[0], config.flow_rate_waste[0], config.options.fractions);
+        }
+        catch (const int error_code)
+        {
+            cout << "No sensitivity: the flows of the circuit did not converge" << endl;
+            return;
+        }
+        cout << "Sensitivity of the performance to:" << endl;
+        cout << "  price_gormanium " << sensitivity.price_gormanium << ", cost_waste " << sensitivity.cost_waste
+             << ", flow_rate_gormanium " << sensitivity.feed_gormanium << ", flow_rate_waste "
+             << sensitivity.feed_waste << endl;
+        cout << "  unit, recovery of gormanium, recovery of waste, fraction_gormanium, fraction_waste" << endl;
+        for (size_t i = 0; i < sensitivity.fraction_gormanium.size(); i++)
+        {
+            cout << "  " << i << ", " << sensitivity.recovery_gormanium[i] << ", " << sensitivity.recovery_waste[i]
+                 << ", " << sensitivity.fraction_gormanium[i] << ", " << sensitivity.fraction_waste[i] << endl;
+        }
+    }
+
+    // the best of config.runs runs of the generational or steady-state algorithm
+    int Run_Genetic(SolverConfig &config)
+    {
+        int num_units = config.num_units[0];
+        int num_procs = omp_get_num_procs(); // get the node's total process
+
+        // Best circuits of all the runs, shared while they run: a run that has not improved
+        // for a third of the threshold takes the best circuit found so far as an elite
+        HallOfFame hall_of_fame(10);
+        GeneticOptions options = config.options;
+        options.hall_of_fame = &hall_of_fame;
+        options.hall_of_fame_injection = config.hall_of_fame_injection >= 0 ? config.hall_of_fame_injection : config.threshold / 3;
+        unique_ptr<ArchiveWriter> archive;
+        if (!config.archive.empty())
         {
-            ever_best_performance = current_best_performance;
-            ever_best_circuit = result;
+            archive.reset(new ArchiveWriter(config.archive, num_units));
+            options.archive = archive.get();
         }
+        unique_ptr<DesignIndex> design_index;
+        if (!config.design_index.empty())
+        {
+            design_index.reset(new DesignIndex(config.design_index));
+            options.design_index = design_index.get();
+        }
+        unique_ptr<EvaluationDatabase> database;
+        if (!config.evaluation_database.empty())
+        {
+            database.reset(new EvaluationDatabase(config.evaluation_database, num_units));
+            options.evaluation_database = database.get();
+        }
+
+        // Try multi times get the best result
+        // One thread per processor: the runs are tasks of a single team, and the evaluation
+        // batches inside each run are tasks of the same team, so threads that run out of runs
+        // help with the evaluations of the others instead of the machine being oversubscribed
+        cout << "Multithreads started..." << endl;
+#pragma omp parallel num_threads(num_procs) proc_bind(spread)
+#pragma omp single
+#pragma omp taskloop grainsize(1)
+        for (int i = 0; i < config.runs; i++)
+        {
+            GeneticOptions run_options = options;
+            run_options.run_id = i;
+            if (run_options.seed != 0)
+            {
+                run_options.seed += i;
+            }
+            if (!config.checkpoint_directory.empty())
+            {
+                run_options.checkpoint_path = config.checkpoint_directory + utils::File_Sep() + "run_" + to_string(i) + ".bin";
+            }
+            vector<double> adaptive_rate = config.adaptive_rate;
+            vector<int> result;
+            if (config.mode == "steady")
+            {
+                result = Steady_State_Optimization(
+                    config.population_size,
+                    config.max_iterations * config.population_size,
+                    config.threshold * config.population_size,
+                    adaptive_rate,
+                    num_units,
+                    config.flow_rate_gormanium[0],
+                    config.flow_rate_waste[0],
+                    config.price_gormanium[0],
+                    config.cost_waste[0],
+                    run_options
+                );
+            }
+            else
+            {
+                result = Genetic_Optimization(
+                    config.population_size,
+                    config.max_iterations,
+                    config.threshold,
+                    adaptive_rate,
+                    num_units,
+                    config.flow_rate_gormanium[0],
+                    config.flow_rate_waste[0],
+                    config.price_gormanium[0],
+                    config.cost_waste[0],
+                    run_options
+                );
+            }
+            double current_best_performance = Performance(config, result);
+            hall_of_fame.Submit(result, current_best_performance);
 #pragma omp critical
+            {
+                cout << "-------------------------------------------------------" << endl;
+                cout << "Run time: " << i << ", the best performance is: " << current_best_performance << endl;
+                Print_Circuit(result);
+            }
+        }
+        if (archive)
+        {
+            archive->Flush();
+        }
+        // output best performance and result
+        vector<int> ever_best_circuit;
+        double ever_best_performance = hall_of_fame.Best(ever_best_circuit);
+        Performance(config, ever_best_circuit, true);
+        cout << "-------------------------------------------------------" << endl;
+        cout << "After " << config.runs << " executions, "
+             << "the best performance is: " << ever_best_performance << endl;
+        cout << "The best circuit is: " << endl;
+        Print_Circuit(ever_best_circuit);
+        if (config.sensitivity)
+        {
+            Print_Sensitivity(config, ever_best_circuit);
+        }
+        if (database)
+        {
+            cout << database->hits() << " evaluations found in " << config.evaluation_database << ", "
+                 << database->misses() << " new, " << database->size() << " circuits stored" << endl;
+        }
+        return 0;
+    }
+
+    // the Pareto front of gormanium against waste in the concentrate
+    int Run_Pareto(SolverConfig &config)
+    {
+        PopulationFlows front_flows;
+        vector<double> adaptive_rate = config.adaptive_rate;
+        vector<vector<int>> front = Pareto_Optimization(
+            config.population_size,
+            config.max_iterations,
+            adaptive_rate,
+            front_flows,
+            config.num_units[0],
+            config.flow_rate_gormanium[0],
+            config.flow_rate_waste[0],
+            config.options.seed
+        );
+        ofstream out(config.output);
+        out << "gormanium,waste,circuit\n";
+        cout << "Pareto front of " << front.size() << " circuits (gormanium, waste):" << endl;
+        for (size_t i = 0; i < front.size(); i++)
         {
-            cout << "-------------------------------------------------------" << endl;
-            cout << "Run time: " << i << ", the best performance is: " << current_best_performance << endl;
-            for (int i = 0; i < result.size(); i++)
+            cout << front_flows.conc_gormanium[i] << ", " << front_flows.conc_waste[i] << ": ";
+            Print_Circuit(front[i]);
+            out << front_flows.conc_gormanium[i] << ',' << front_flows.conc_waste[i] << ',';
+            for (size_t j = 0; j < front[i].size(); j++)
             {
-                cout << result[i] << " ";
+                out << (j == 0 ? "" : " ") << front[i][j];
             }
-            cout << endl;
-        }
-    }
-    // output best performance and result
-    Evaluate_Circuit(
-        ever_best_circuit,
-        true,
-        0,
-        1e-4,
-        1000,
-        price_gormanium,
-        cost_waste,
-        flow_rate_gormanium,
-        flow_rate_waste
-    );
-    cout << "-------------------------------------------------------" << endl;
-    cout << "After " << run_times << " executions, "
-         << "the best performance is: " << ever_best_performance << endl;
-    cout << "The best circuit is: " << endl;
+            out << '\n';
+        }
+        return out.good() ? 0 : 1;
+    }
+
+    // the top_k circuits of all the valid circuits
+    int Run_Exhaustive(SolverConfig &config)
+    {
+        vector<double> top_performance;
+        long long evaluated = 0;
+        vector<vector<int>> top = Exhaustive_Optimization(
+            config.num_units[0],
+            config.top_k,
+            top_performance,
+            evaluated,
+            config.flow_rate_gormanium[0],
+            config.flow_rate_waste[0],
+            config.price_gormanium[0],
+            config.cost_waste[0]
+        );
+        cout << evaluated << " valid circuits evaluated, the best are:" << endl;
+        for (size_t i = 0; i < top.size(); i++)
+        {
+            cout << top_performance[i] << ": ";
+            Print_Circuit(top[i]);
+        }
+        return 0;
+    }
 
-    for (int i = 0; i < ever_best_circuit.size(); i++)
+    // the best circuit of every point of a grid of problems
+    int Run_Sweep(SolverConfig &config)
+    {
+        vector<SweepResult> results = Sweep_Optimization(config);
+        for (const SweepResult &result : results)
+        {
+            cout << result.point.num_units << " units, feed " << result.point.flow_rate_gormanium << "/"
+                 << result.point.flow_rate_waste << " kg/s, prices " << result.point.price_gormanium << "/"
+                 << result.point.cost_waste << ": " << result.performance << endl;
+        }
+        if (!Write_Sweep_Table(config.output, results))
+        {
+            cerr << "Cannot write " << config.output << endl;
+            return 1;
+        }
+        cout << "Results written to " << config.output << endl;
+        return 0;
+    }
+
+    CircuitServer *running_server = nullptr;
+
+    void Stop_Server(int signal)
+    {
+        running_server->Stop();
+    }
+
+    // answer requests on a socket until interrupted
+    int Run_Server(SolverConfig &config)
+    {
+        CircuitServer server(config.socket, config);
+        running_server = &server;
+        signal(SIGINT, Stop_Server);
+        signal(SIGTERM, Stop_Server);
+        cout << "Listening on " << config.socket << endl;
+        server.Run();
+        ServerStats stats = server.Stats();
+        cout << stats.requests << " requests, " << stats.evaluations << " circuits evaluated in "
+             << stats.batches << " batches" << endl;
+        return 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Pre defined parameters, overridden by an optional configuration file and the
+    // command line, see Config.h and the README
+    SolverConfig config;
+    try
+    {
+        Parse_Arguments(argc, argv, config);
+    }
+    catch (const invalid_argument &e)
+    {
+        cout << e.what() << endl;
+        cout << Config_Usage(argv[0]) << endl;
+        return 1;
+    }
+    if (config.mode != "sweep" && config.num_units.size() * config.flow_rate_gormanium.size() *
+                                          config.flow_rate_waste.size() * config.price_gormanium.size() *
+                                          config.cost_waste.size() != 1)
+    {
+        cout << "Lists of values are only allowed in sweep mode" << endl;
+        return 1;
+    }
+    if (!config.options.fractions.uniform())
+    {
+        if (config.mode != "ga" && config.mode != "steady" && config.mode != "sweep")
+        {
+            cout << "Concentrate fractions per unit are only supported by the ga, steady and sweep modes" << endl;
+            return 1;
+        }
+        if (config.num_units.size() != 1 || !config.options.fractions.valid(config.num_units[0]))
+        {
+            cout << "fractions_gormanium and fractions_waste need one value between 0 and 1 per unit" << endl;
+            return 1;
+        }
+    }
+    if (config.options.robust.scenarios > 0 && config.mode != "ga" && config.mode != "steady")
+    {
+        cout << "Robust evaluation over scenarios is only supported by the ga and steady modes" << endl;
+        return 1;
+    }
+    if (config.options.single_precision && config.options.robust.scenarios <= 0)
+    {
+        cout << "single_precision screens the scenarios of the robust evaluation, it needs scenarios" << endl;
+        return 1;
+    }
+    if (config.options.robust.feed_spread < 0.0 || config.options.robust.fraction_spread < 0.0)
+    {
+        cout << "feed_spread and fraction_spread cannot be negative" << endl;
+        return 1;
+    }
+    if (!config.checkpoint_directory.empty())
+    {
+        filesystem::create_directories(config.checkpoint_directory);
+    }
+
+    if (config.mode == "pareto")
+    {
+        return Run_Pareto(config);
+    }
+    if (config.mode == "exhaustive")
+    {
+        return Run_Exhaustive(config);
+    }
+    if (config.mode == "sweep")
+    {
+        return Run_Sweep(config);
+    }
+    if (config.mode == "serve")
     {
-        cout << ever_best_circuit[i] << " ";
+        return Run_Server(config);
     }
-    return 0;
-}
\ No newline at end of file
+    return Run_Genetic(config);
+}
@@ -2,17 +2,20 @@
 #include "utils.h"
 #include <vector>
 // system includes
+#include <algorithm>
 #include <assert.h>
+#include <charconv>
+#include <cmath>
 #include <fstream>
 #include <queue>
-#include <omp.h>
 
 void utils::Print_Circuit_To_File(std::string path,
                                   const std::vector<int> schematic,
                                   const std::vector<double> gormanium,
                                   const std::vector<double> waste,
                                   const int iter,
-                                  const double performance)
+                                  const double performance,
+                                  const UnitFractions &fractions)
 {
     int n = (schematic.size() - 1) / 2;
     // create the filestream and print
@@ -60,11 +63,179 @@ void utils::Print_Circuit_To_File(std::string path,
             }
             out << std::endl;
             out << performance;
+            // the fractions of each unit, only when they differ from the original problem
+            if (!fractions.uniform())
+            {
+                for (const std::vector<double> *values : {&fractions.gormanium, &fractions.waste})
+                {
+                    out << std::endl;
+                    for (size_t i = 0; i < values->size(); i++)
+                    {
+                        out << (*values)[i];
+                        if (i != values->size() - 1)
+                        {
+                            out << ", ";
+                        }
+                    }
+                }
+            }
         }
     }
     out.close();
 }
 
+namespace
+{
+    // rounded to two decimals, as in visualisation.py
+    void Append_Fixed(std::string &out, double value)
+    {
+        char digits[32];
+        std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value,
+                                                    std::chars_format::fixed, 2);
+        out.append(digits, result.ptr);
+    }
+
+    // colour of a stream by its grade, from 0% (red) to 100% (blue) gormanium
+    const char *Grade_Colour(double gormanium, double waste)
+    {
+        static const char *colours[11] = {"red4", "red3", "red2", "purple3", "purple2", "purple1",
+                                          "purple", "mediumslateblue", "blue2", "blue3", "blue4"};
+        double total = gormanium + waste;
+        int grade = total > 0.0 ? (int)std::lround(gormanium / total * 10.0) : 0;
+        return colours[std::min(std::max(grade, 0), 10)];
+    }
+
+    void Append_Node(std::string &dot, const std::string &name, const char *style)
+    {
+        dot += "    \"";
+        dot += name;
+        dot += "\" [";
+        dot += style;
+        dot += "];\n";
+    }
+}
+
+void utils::Append_Dot(std::string &dot,
+                       const std::vector<int> &schematic,
+                       const std::vector<double> &gormanium,
+                       const std::vector<double> &waste,
+                       int iter,
+                       double performance,
+                       const std::string &name,
+                       double input_gormanium,
+                       double input_waste,
+                       const UnitFractions &fractions)
+{
+    int n = (schematic.size() - 1) / 2;
+    bool flows = (int)gormanium.size() == n + 2 && (int)waste.size() == n + 2;
+
+    std::vector<std::string> nodes(n + 2);
+    for (int i = 0; i < n; i++)
+    {
+        nodes[i] = "Unit " + std::to_string(i);
+    }
+    nodes[n] = "Concentrate";
+    nodes[n + 1] = "Tailings";
+
+    dot += "digraph \"";
+    dot += name;
+    dot += "\" {\n    rankdir=LR; splines=spline; fontname=\"helvetica\";\n";
+    if (flows)
+    {
+        dot += "    label=\"Iteration: " + std::to_string(iter) + "\tPerformance: ";
+        Append_Fixed(dot, performance);
+        dot += "\";\n";
+    }
+    Append_Node(dot, "Feed", "shape=rectangle, style=\"rounded, filled\"");
+    for (int i = 0; i < n; i++)
+    {
+        Append_Node(dot, nodes[i], "shape=rectangle");
+    }
+    Append_Node(dot, nodes[n], "shape=rectangle, style=\"rounded, filled\", color=blue");
+    Append_Node(dot, nodes[n + 1], "shape=rectangle, style=\"rounded, filled\", color=red");
+    dot += "    { rank=sink; \"Concentrate\"; \"Tailings\"; }\n";
+
+    // outflows of each unit, the widths are relative to the largest stream
+    std::vector<double> out_gormanium(2 * n + 1), out_waste(2 * n + 1);
+    out_gormanium[0] = input_gormanium;
+    out_waste[0] = input_waste;
+    double largest = input_gormanium + input_waste;
+    if (flows)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            // same fractions as Evaluate_Flows
+            double fraction_gormanium = fractions.gormanium_of(i);
+            double fraction_waste = fractions.waste_of(i);
+            out_gormanium[2 * i + 1] = fraction_gormanium * gormanium[i];
+            out_waste[2 * i + 1] = fraction_waste * waste[i];
+            out_gormanium[2 * i + 2] = (1 - fraction_gormanium) * gormanium[i];
+            out_waste[2 * i + 2] = (1 - fraction_waste) * waste[i];
+            largest = std::max({largest, out_gormanium[2 * i + 1] + out_waste[2 * i + 1],
+                                out_gormanium[2 * i + 2] + out_waste[2 * i + 2]});
+        }
+    }
+
+    for (size_t i = 0; i < schematic.size(); i++)
+    {
+        const std::string &from = i == 0 ? std::string("Feed") : nodes[(i - 1) / 2];
+        bool tailings = i != 0 && i % 2 == 0;
+        dot += "    \"" + from + "\" -> \"" + nodes[schematic[i]] + "\" [";
+        if (flows)
+        {
+            dot += "color=";
+            dot += Grade_Colour(out_gormanium[i], out_waste[i]);
+            dot += ", penwidth=";
+            Append_Fixed(dot, (out_gormanium[i] + out_waste[i]) / largest * 4.4 + 0.6);
+            dot += ", label=\"G: ";
+            Append_Fixed(dot, out_gormanium[i]);
+            dot += "kg/s  W: ";
+            Append_Fixed(dot, out_waste[i]);
+            dot += "kg/s\", fontsize=11";
+            if (i != 0)
+            {
+                dot += tailings ? ", fontcolor=red" : ", fontcolor=blue";
+            }
+        }
+        else
+        {
+            dot += i == 0 ? "color=black" : (tailings ? "color=red" : "color=blue");
+        }
+        dot += tailings ? ", style=dashed, arrowhead=empty];\n" : ", arrowhead=normal];\n";
+    }
+    dot += "}\n";
+}
+
+void utils::Print_Circuits_To_Dot(std::string filename,
+                                  const std::vector<std::vector<int>> &schematics,
+                                  const std::vector<std::vector<double>> &gormanium,
+                                  const std::vector<std::vector<double>> &waste,
+                                  const std::vector<int> &iters,
+                                  const std::vector<double> &performances)
+{
+    std::string dot;
+    std::ofstream out(filename, std::ofstream::out | std::ofstream::binary);
+    for (size_t k = 0; k < schematics.size(); k++)
+    {
+        int n = (schematics[k].size() - 1) / 2;
+        int iter = k < iters.size() ? iters[k] : 0;
+        Append_Dot(dot,
+                   schematics[k],
+                   k < gormanium.size() ? gormanium[k] : std::vector<double>(),
+                   k < waste.size() ? waste[k] : std::vector<double>(),
+                   iter,
+                   k < performances.size() ? performances[k] : -1e9,
+                   "circuit_" + std::to_string(n) + "_" + std::to_string(iter));
+        // written in large blocks
+        if (dot.size() > (1 << 20))
+        {
+            out.write(dot.data(), dot.size());
+            dot.clear();
+        }
+    }
+    out.write(dot.data(), dot.size());
+}
+
 std::string utils::File_Sep()
 {
 #ifdef _WIN32
@@ -76,20 +247,24 @@ std::string utils::File_Sep()
 
 std::string utils::Get_Exe_Path()
 {
-    // recall PATH_MAX macro redefined for windows to mean MAX_PATH in utils header
+    // the executable does not move, so the path is only looked up once
+    static const std::string exe_path = [] {
+        // recall PATH_MAX macro redefined for windows to mean MAX_PATH in utils header
 #ifdef _WIN32
-    TCHAR result[PATH_MAX];
-    // by setting module handle to null, will retrieve filepath of current process
-    GetModuleFileName(NULL, result, PATH_MAX);
-    std::wstring temp(&result[0]);
-    // and now safely convert to string
-    std::string path(temp.begin(), temp.end());
+        TCHAR result[PATH_MAX];
+        // by setting module handle to null, will retrieve filepath of current process
+        GetModuleFileName(NULL, result, PATH_MAX);
+        std::wstring temp(&result[0]);
+        // and now safely convert to string
+        std::string path(temp.begin(), temp.end());
 #else
-    char result[PATH_MAX];
-    ssize_t count = readlink("/proc/self/exe", result, PATH_MAX);
-    std::string path = std::string(result, (count > 0) ? count : 0);
+        char result[PATH_MAX];
+        ssize_t count = readlink("/proc/self/exe", result, PATH_MAX);
+        std::string path = std::string(result, (count > 0) ? count : 0);
 #endif
-    return path.substr(0, path.find_last_of(utils::File_Sep()));
+        return path.substr(0, path.find_last_of(utils::File_Sep()));
+    }();
+    return exe_path;
 }
 
 int utils::Check_Validity(const std::vector<int> &schematic)
@@ -127,28 +302,80 @@ int utils::Check_Validity(const std::vector<int> &schematic)
     // reflect that we've traversed this circuit once, and all visited nodes will have a colour code 1.
     level++;
     // now re-run the algorithm, but this time use the output units as the starting points to make
-    // sure that all outputs are forward reachable from every other node
-    int success{0};
-    // require units to be firstprivate such that each of the threads won't interfere with each others BFS traversal
-    // all other vars except `int success` are read-only within the parallel section
-#pragma omp parallel num_threads(2) default(none) firstprivate(units) shared(success, output_nodes, level, num_units)
+    // sure that all outputs are forward reachable from every other node.
+    // both traversals are far too small to be worth a thread each, so they run one after the
+    // other, each on its own copy of the units so that they don't interfere with each other's colours
+    for (int k = 0; k < 2; k++)
     {
+        std::vector<SeparationUnit> visited(units);
         std::vector<int> outputs{}; // we don't care about what BFS_Reverse will put in here.
-        int thread_id{omp_get_thread_num()};
-        int res = BFS_Reverse(units, outputs, output_nodes[thread_id], num_units, level);
-        // if the output node is forward reachable from all other nodes, then return 0 (since that's the success exit code)
-        int outcome = !(res == (num_units - 1));
-#pragma omp critical
-        // make sure that both threads get a 0 code (success code)
-        success += outcome;
+        int res = BFS_Reverse(visited, outputs, output_nodes[k], num_units, level);
+        // the output node must be forward reachable from all other nodes
+        if (res != (num_units - 1))
+        {
+            // then there was definitely a circuit error, so return code 1
+            return 1;
+        }
     }
-    if (success == 0)
+    return 0;
+}
+
+int utils::Check_Validity(const std::vector<int> &schematic, const UnitFractions &fractions)
+{
+    int status = Check_Validity(schematic);
+    if (status == 0 && !fractions.valid((schematic.size() - 1) / 2))
     {
-        return 0;
+        return 2;
     }
-    else
-        // then there was definitely a circuit error, so return code 1
-        return 1;
+    return status;
+}
+
+std::vector<int> utils::Canonical_Circuit(const std::vector<int> &schematic)
+{
+    int num_units{static_cast<int>(schematic.size() - 1) / 2};
+    // new label of each unit, and unit holding each new label.
+    // units are labelled in the order they are queued, so the
+    // second vector doubles up as the BFS queue.
+    std::vector<int> label(num_units, -1);
+    std::vector<int> order{};
+    order.reserve(num_units);
+    label[schematic[0]] = 0;
+    order.push_back(schematic[0]);
+    for (size_t head = 0; head < order.size(); head++)
+    {
+        int unit = order[head];
+        // look at the concentrate first, then the tailings
+        for (int k = 1; k <= 2; k++)
+        {
+            int next = schematic[2 * unit + k];
+            if (next < num_units && label[next] == -1)
+            {
+                label[next] = order.size();
+                order.push_back(next);
+            }
+        }
+    }
+    // units unreachable from the feed go last
+    for (int i = 0; i < num_units; i++)
+    {
+        if (label[i] == -1)
+        {
+            label[i] = order.size();
+            order.push_back(i);
+        }
+    }
+
+    std::vector<int> canonical(schematic.size());
+    canonical[0] = 0;
+    for (int i = 0; i < num_units; i++)
+    {
+        for (int k = 1; k <= 2; k++)
+        {
+            int next = schematic[2 * order[i] + k];
+            canonical[2 * i + k] = (next < num_units) ? label[next] : next;
+        }
+    }
+    return canonical;
 }
 
 bool utils::BFS(std::vector<SeparationUnit> &units, std::vector<int> &output_nodes, int root, int num_units, int level)
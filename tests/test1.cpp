@@ -76,6 +76,30 @@ int main(int argc, char *argv[])
 		assert(edge_cases_answers[i] == utils::Check_Validity(edge_cases[i]));
 	}
 
+	// relabelling the units of a circuit must not change its canonical form
+	for (auto &&circuit : std::vector<std::vector<int>>{bb1, ec1, ec2})
+	{
+		int n = (circuit.size() - 1) / 2;
+		// reverse the unit indices: unit i becomes unit n - 1 - i
+		std::vector<int> relabelled(circuit.size());
+		relabelled[0] = n - 1 - circuit[0];
+		for (int i = 0; i < n; i++)
+		{
+			for (int k = 1; k <= 2; k++)
+			{
+				int next = circuit[2 * i + k];
+				relabelled[2 * (n - 1 - i) + k] = (next < n) ? n - 1 - next : next;
+			}
+		}
+		std::vector<int> canonical = utils::Canonical_Circuit(circuit);
+		assert(canonical == utils::Canonical_Circuit(relabelled));
+		assert(canonical == utils::Canonical_Circuit(canonical));
+		assert(canonical[0] == 0);
+		assert(utils::Check_Validity(canonical) == 0);
+	}
+	// units are numbered in breadth first order from the feed, concentrate first
+	assert((utils::Canonical_Circuit(std::vector<int>{2, 3, 4, 0, 3, 1, 4}) == std::vector<int>{0, 1, 4, 2, 3, 3, 4}));
+
 	// now test that the parents are being correctly recognised in a single forward iteration
 	std::vector<SeparationUnit> test1 = make_circuit(std::vector<int>{0, 1, 2}); // answers: 0:none
 	std::vector<std::vector<int>> test1_sol{{}};
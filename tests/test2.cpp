@@ -1,9 +1,33 @@
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
 #include "CUnit.h"
 #include "Genetic_Algorithm.h"
+#include "Pareto.h"
+#include "Exhaustive_Search.h"
+#include "Steady_State.h"
+#include "Config.h"
+#include "Sweep.h"
+#include "Server.h"
+#include "Bulk_Evaluator.h"
+#include "Gormanium.h"
+#include "Sensitivity.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 bool all_Close(std::vector<double> &v1, std::vector<double> &v2, double tol = 0.1)
 {
@@ -142,6 +166,1058 @@ bool test_Probability()
     return all_Close(probability, answer) && (probability.size() == answer.size());
 }
 
+bool test_Reprice_Population()
+{
+    std::vector<std::vector<int>> population{
+        {0, 4, 3, 2, 0, 5, 4, 4, 6, 2, 1},
+        {0, 1, 2, 3, 0, 0, 4},
+        {0, 1, 2}};
+    std::vector<double> prices{100.0, 50.0, 250.0};
+    std::vector<double> costs{500.0, 20.0, 0.0};
+
+    PopulationFlows flows;
+    Evaluate_Population_Flows(population, flows);
+    std::vector<double> performance;
+    Reprice_Population(flows, prices, costs, performance);
+
+    if (performance.size() != population.size() * prices.size())
+    {
+        return false;
+    }
+    // every scenario should match a direct evaluation of the circuit
+    for (size_t s = 0; s < prices.size(); s++)
+    {
+        for (size_t i = 0; i < population.size(); i++)
+        {
+            double expected = Evaluate_Circuit(population[i], false, 0, 1e-4, 1000, prices[s], costs[s]);
+            if (std::abs(performance[s * population.size() + i] - expected) > 1e-9)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool test_Non_Dominated_Sort()
+{
+    PopulationFlows flows;
+    flows.conc_gormanium = {1.0, 2.0, 2.0, 0.5, 3.0};
+    flows.conc_waste = {1.0, 1.0, 3.0, 2.0, 3.0};
+    flows.converged = {1, 1, 1, 1, 1};
+    std::vector<int> rank;
+    std::vector<std::vector<int>> fronts;
+    Non_Dominated_Sort(flows, rank, fronts);
+
+    // 1 and 4 are non-dominated, 0 and 2 only dominated by them, 3 by 0
+    std::vector<int> answer{1, 0, 1, 2, 0};
+    return rank == answer && fronts.size() == 3 && fronts[0].size() == 2;
+}
+
+bool test_Pareto_Optimization()
+{
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    PopulationFlows front_flows;
+    std::vector<std::vector<int>> front = Pareto_Optimization(50, 30, adaptive_rate, front_flows, 5, 10.0, 100.0, 7);
+
+    // the same seed gives the same front
+    PopulationFlows again_flows;
+    if (front.empty() || front.size() != front_flows.conc_gormanium.size() ||
+        Pareto_Optimization(50, 30, adaptive_rate, again_flows, 5, 10.0, 100.0, 7) != front ||
+        again_flows.conc_gormanium != front_flows.conc_gormanium)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < front.size(); i++)
+    {
+        if (utils::Check_Validity(front[i]) != 0)
+        {
+            return false;
+        }
+        // sorted by recovery, and no circuit of the front dominates another
+        if (i > 0 && !(front_flows.conc_gormanium[i] > front_flows.conc_gormanium[i - 1] &&
+                       front_flows.conc_waste[i] > front_flows.conc_waste[i - 1]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool test_Local_Search()
+{
+    std::vector<int> circuit_vector = {0, 1, 2, 3, 0, 0, 4};
+    double performance = Evaluate_Circuit(circuit_vector);
+    double start = performance;
+
+    int evaluations = Local_Search(circuit_vector, performance, 500, true);
+
+    // the local optimum must be valid, better, and correctly scored
+    return evaluations > 0 && evaluations <= 500 &&
+           utils::Check_Validity(circuit_vector) == 0 &&
+           performance > start &&
+           std::abs(performance - Evaluate_Circuit(circuit_vector)) < 1e-9;
+}
+
+bool test_Local_Search_Random_Order()
+{
+    // a budget smaller than the neighbourhood reaches different neighbours with different generators
+    std::set<std::vector<int>> optima;
+    for (unsigned seed = 0; seed < 20; seed++)
+    {
+        std::vector<int> circuit_vector = {0, 1, 2, 3, 0, 0, 4};
+        double performance = Evaluate_Circuit(circuit_vector);
+        std::mt19937 rng(seed);
+        if (Local_Search(circuit_vector, performance, 5, true, 10.0, 100.0, 100.0, 500.0, UnitFractions(), &rng) != 5 ||
+            utils::Check_Validity(circuit_vector) != 0)
+        {
+            return false;
+        }
+        optima.insert(circuit_vector);
+    }
+    return optima.size() > 1;
+}
+
+bool test_Genetic_Optimization_Local_Search()
+{
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    GeneticOptions options;
+    options.local_search_elites = 2;
+    options.local_search_budget = 200;
+    std::vector<int> best = Genetic_Optimization(30, 20, 20, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+
+    // a budget below the number of elites still gives each of them one evaluation
+    options.local_search_elites = 5;
+    options.local_search_budget = 1;
+    std::vector<int> small_budget = Genetic_Optimization(30, 20, 20, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+
+    return best.size() == 11 && utils::Check_Validity(best) == 0 &&
+           small_budget.size() == 11 && utils::Check_Validity(small_budget) == 0;
+}
+
+bool test_Exhaustive_Optimization()
+{
+    // brute force every gene of a 2 unit circuit
+    int n = 2;
+    double brute_best = -1e9;
+    int brute_valid = 0;
+    std::vector<int> gene(2 * n + 1);
+    for (int code = 0; code < n * (n + 2) * (n + 2) * (n + 2) * (n + 2); code++)
+    {
+        int rest = code;
+        gene[0] = rest % n;
+        rest /= n;
+        for (int i = 1; i < 2 * n + 1; i++)
+        {
+            gene[i] = rest % (n + 2);
+            rest /= n + 2;
+        }
+        if (utils::Check_Validity(gene) == 0)
+        {
+            brute_valid++;
+            brute_best = std::max(brute_best, Evaluate_Circuit(gene));
+        }
+    }
+
+    std::vector<double> top_performance;
+    long long evaluated;
+    std::vector<std::vector<int>> top = Exhaustive_Optimization(n, 3, top_performance, evaluated);
+    // each circuit is enumerated once instead of once per labelling of its n units
+    bool small = top_performance[0] == brute_best && evaluated * 2 == brute_valid;
+
+    // 3 units, 1488 valid genes collapse to 248 circuits
+    top = Exhaustive_Optimization(3, 5, top_performance, evaluated);
+    bool sorted = std::is_sorted(top_performance.rbegin(), top_performance.rend());
+    bool large = top.size() == 5 && evaluated == 248 && std::abs(top_performance[0] - 4.857) < 1e-3 &&
+                 std::abs(Evaluate_Circuit(top[0]) - top_performance[0]) < 1e-9 &&
+                 utils::Canonical_Circuit(top[0]) == top[0];
+
+    // there is no top 0
+    bool rejected = false;
+    try
+    {
+        Exhaustive_Optimization(3, 0, top_performance, evaluated);
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+
+    return small && sorted && large && rejected;
+}
+
+bool test_Genetic_Optimization_Canonical()
+{
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    GeneticOptions options;
+    options.canonical_labels = true;
+    std::vector<int> best = Genetic_Optimization(30, 20, 20, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+
+    return utils::Check_Validity(best) == 0 && utils::Canonical_Circuit(best) == best;
+}
+
+bool test_Mutation_Rate()
+{
+    // below average fitness, so the mutation rate is k4
+    int num_units = 100;
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.02};
+    std::vector<int> original(2 * num_units + 1, 0);
+    std::mt19937 rng(5);
+    srand(5);
+
+    int trials = 5000;
+    double changed_skip = 0.0;
+    double changed_legacy = 0.0;
+    bool feed_kept = true;
+    for (int t = 0; t < trials; t++)
+    {
+        std::vector<int> skip(original);
+        std::vector<int> legacy(original);
+        Mutation(0.0, 1.0, 1.0, 0.0, adaptive_rate, skip, num_units, rng);
+        Mutation(0.0, 1.0, 1.0, 0.0, adaptive_rate, legacy, num_units);
+        for (size_t i = 0; i < original.size(); i++)
+        {
+            changed_skip += skip[i] != original[i];
+            changed_legacy += legacy[i] != original[i];
+        }
+        feed_kept = feed_kept && skip[0] == original[0];
+    }
+    // each of the 2n output genes mutates with probability k4, and a mutation
+    // keeps the same value with probability 1 / (n + 2)
+    double expected = trials * 2 * num_units * 0.02 * (1.0 - 1.0 / (num_units + 2));
+    double sigma = std::sqrt(expected);
+    bool ok = feed_kept && std::abs(changed_skip - expected) < 5 * sigma &&
+              std::abs(changed_legacy - expected) < 5 * sigma;
+
+    // a tiny rate is as fast as any other, and almost never mutates
+    adaptive_rate[3] = 1e-12;
+    double changed_tiny = 0.0;
+    for (int t = 0; t < trials; t++)
+    {
+        std::vector<int> tiny(original);
+        Mutation(0.0, 1.0, 1.0, 0.0, adaptive_rate, tiny, num_units, rng);
+        changed_tiny += tiny != original;
+    }
+    return ok && changed_tiny == 0.0;
+}
+
+bool test_Steady_State_Optimization()
+{
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    GeneticOptions options;
+    options.seed = 17;
+    std::vector<int> best = Steady_State_Optimization(30, 3000, 3000, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+    bool worst_ok = best.size() == 11 && utils::Check_Validity(best) == 0 && Evaluate_Circuit(best) > 0.0;
+
+    options.replace_worst = false;
+    best = Steady_State_Optimization(30, 3000, 3000, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+    bool tournament_ok = best.size() == 11 && utils::Check_Validity(best) == 0;
+
+    return worst_ok && tournament_ok;
+}
+
+bool test_Hall_Of_Fame()
+{
+    // many threads submitting the same candidates, the hall of fame keeps the best distinct ones
+    HallOfFame hall(5);
+#pragma omp parallel for
+    for (int i = 0; i < 4000; i++)
+    {
+        int k = i % 1000;
+        hall.Submit(std::vector<int>{k}, (k * 37) % 1000);
+    }
+    std::vector<std::pair<double, std::vector<int>>> entries = hall.Entries();
+    bool top_ok = entries.size() == 5;
+    for (int j = 0; top_ok && j < 5; j++)
+    {
+        // (k * 37) % 1000 is a permutation of 0..999
+        top_ok = entries[j].first == 999 - j && (entries[j].second[0] * 37) % 1000 == 999 - j;
+    }
+    std::vector<int> best;
+    bool best_ok = hall.Best(best) == 999 && hall.Best_Performance() == 999 && best == entries[0].second;
+    bool reject_ok = !hall.Submit(std::vector<int>{-1}, 995) && !hall.Submit(entries[0].second, 1000);
+
+    // concurrent runs sharing a hall of fame, with injection of its best circuit
+    HallOfFame shared(3);
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    GeneticOptions options;
+    options.hall_of_fame = &shared;
+    options.hall_of_fame_injection = 5;
+    std::vector<double> run_best(2);
+#pragma omp parallel for
+    for (int run = 0; run < 2; run++)
+    {
+        GeneticOptions run_options = options;
+        run_options.seed = 100 + run;
+        std::vector<int> result = Genetic_Optimization(40, 100, 30, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, run_options);
+        run_best[run] = Evaluate_Circuit(result, false, 0, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0);
+    }
+    std::vector<int> shared_best;
+    double shared_performance = shared.Best(shared_best);
+    bool shared_ok = shared_performance >= std::max(run_best[0], run_best[1]) - 1e-6 &&
+                     std::abs(Evaluate_Circuit(shared_best, false, 0, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0) - shared_performance) < 1e-6;
+
+    return top_ok && best_ok && reject_ok && shared_ok;
+}
+
+bool test_Checkpoint_Resume()
+{
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    std::string interrupted = (std::filesystem::temp_directory_path() / "ga_interrupted.bin").string();
+    std::string uninterrupted = (std::filesystem::temp_directory_path() / "ga_uninterrupted.bin").string();
+    std::remove(interrupted.c_str());
+    std::remove(uninterrupted.c_str());
+    GeneticOptions options;
+    options.seed = 5;
+    options.checkpoint_interval = 0.0;
+    std::vector<double> problem = Checkpoint_Problem(60, 1000, 5, 10.0, 100.0, 100.0, 500.0, options);
+
+    // a run of 60 generations, and the same run stopped by its time limit after each of
+    // its first 30 generations and resumed
+    options.checkpoint_path = uninterrupted;
+    std::vector<double> rates = adaptive_rate;
+    std::vector<int> expected = Genetic_Optimization(30, 60, 1000, rates, 5, 10.0, 100.0, 100.0, 500.0, options);
+    options.checkpoint_path = interrupted;
+    options.time_limit = 1e-9;
+    for (int i = 0; i < 30; i++)
+    {
+        rates = adaptive_rate;
+        Genetic_Optimization(30, 60, 1000, rates, 5, 10.0, 100.0, 100.0, 500.0, options);
+    }
+    GeneticCheckpoint middle;
+    bool middle_ok = Load_Checkpoint(interrupted, middle, 5, 30, problem) && middle.generation == 30 && !middle.finished;
+    // a gene out of range in the population or the best circuit is rejected, and so are
+    // another number of rates, population size or problem
+    std::string damaged = (std::filesystem::temp_directory_path() / "ga_damaged.bin").string();
+    GeneticCheckpoint bad = middle, ignored;
+    bad.population[0][1] = middle.num_units + 2;
+    bool damaged_ok = Save_Checkpoint(damaged, bad) && !Load_Checkpoint(damaged, ignored, 5, 30, problem);
+    bad = middle;
+    bad.best_circuit[0] = middle.num_units;
+    damaged_ok = damaged_ok && Save_Checkpoint(damaged, bad) && !Load_Checkpoint(damaged, ignored, 5, 30, problem);
+    bad = middle;
+    bad.adaptive_rate.push_back(1.0);
+    damaged_ok = damaged_ok && Save_Checkpoint(damaged, bad) && !Load_Checkpoint(damaged, ignored, 5, 30, problem);
+    std::vector<double> other_price = Checkpoint_Problem(60, 1000, 5, 10.0, 100.0, 5.0, 1.0, options);
+    std::vector<double> other_limit = Checkpoint_Problem(40, 1000, 5, 10.0, 100.0, 100.0, 500.0, options);
+    damaged_ok = damaged_ok && Save_Checkpoint(damaged, middle) && Load_Checkpoint(damaged, ignored, 5, 30, problem) &&
+                 !Load_Checkpoint(damaged, ignored, 5, 31, problem) &&
+                 !Load_Checkpoint(damaged, ignored, 5, 30, other_price) &&
+                 !Load_Checkpoint(damaged, ignored, 5, 30, other_limit);
+    std::remove(damaged.c_str());
+    // the seed is ignored when resuming, the state of the generator comes from the checkpoint
+    options.seed = 6;
+    options.time_limit = 0.0;
+    rates = adaptive_rate;
+    std::vector<int> resumed = Genetic_Optimization(30, 60, 1000, rates, 5, 10.0, 100.0, 100.0, 500.0, options);
+
+    // both end in the same state
+    GeneticCheckpoint a, b;
+    bool same = Load_Checkpoint(uninterrupted, a, 5, 30, problem) && Load_Checkpoint(interrupted, b, 5, 30, problem) &&
+                a.generation == 60 && b.generation == 60 && a.finished && b.finished &&
+                a.population == b.population && a.rng == b.rng &&
+                a.count_for_threshold == b.count_for_threshold && resumed == expected;
+
+    // the finished run of another problem is not returned, the run starts afresh
+    rates = adaptive_rate;
+    Genetic_Optimization(30, 60, 1000, rates, 5, 10.0, 100.0, 5.0, 1.0, options);
+    bool fresh = Load_Checkpoint(interrupted, b, 5, 30, other_price) && b.generation == 60 &&
+                 b.population != a.population && !Load_Checkpoint(interrupted, b, 5, 30, problem);
+
+    std::remove(interrupted.c_str());
+    std::remove(uninterrupted.c_str());
+    return middle_ok && damaged_ok && same && fresh && !Load_Checkpoint(uninterrupted, a, 5, 30, problem);
+}
+
+bool test_Genetic_Optimization_Archive()
+{
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    std::string path = (std::filesystem::temp_directory_path() / "ga_archive.bin").string();
+    std::remove(path.c_str());
+    bool ok = true;
+    {
+        ArchiveWriter archive(path, 5);
+        GeneticOptions options;
+        options.seed = 3;
+        options.archive = &archive;
+        options.run_id = 4;
+        Genetic_Optimization(30, 20, 1000, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+    }
+    {
+        // the best circuit of each of the 20 generations, with its flows
+        ArchiveReader archive(path);
+        ok = archive.size() == 20;
+        for (uint64_t i = 0; ok && i < archive.size(); i++)
+        {
+            ArchiveRecord record = archive[i];
+            ok = record.run() == 4 && record.generation() == (int)i && record.has_flows() &&
+                 std::abs(record.performance() - Evaluate_Circuit(record.Circuit())) < 1e-6 &&
+                 std::abs(record.gormanium(5) * 100.0 - record.waste(5) * 500.0 - record.performance()) < 1e-6;
+        }
+    }
+    std::remove(path.c_str());
+    return ok;
+}
+
+bool test_Generation_Log()
+{
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    std::string path = (std::filesystem::temp_directory_path() / "ga_generations.jsonl").string();
+    std::remove(path.c_str());
+    GeneticOptions options;
+    options.seed = 8;
+    options.run_id = 2;
+    options.generation_log = path;
+    Genetic_Optimization(30, 40, 1000, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+    Output_Writer().Flush();
+
+    // one line per change of the best circuit, in order of generation
+    std::ifstream log(path);
+    std::string line, previous_circuit;
+    int lines = 0, previous_generation = -1;
+    bool ok = true;
+    while (std::getline(log, line))
+    {
+        lines++;
+        int generation = std::stoi(line.substr(line.find("\"generation\": ") + 14));
+        std::string circuit = line.substr(line.find("\"circuit\""), line.find("]") - line.find("\"circuit\""));
+        ok = ok && line.rfind("{\"run\": 2, ", 0) == 0 && line.back() == '}' &&
+             line.find("\"waste\": [") != std::string::npos &&
+             generation > previous_generation && circuit != previous_circuit;
+        previous_generation = generation;
+        previous_circuit = circuit;
+    }
+    log.close();
+    std::remove(path.c_str());
+    return ok && lines >= 1 && lines < 40;
+}
+
+bool test_Initial_Circuits()
+{
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    GeneticOptions options;
+    options.seed = 3;
+    std::vector<int> best = Genetic_Optimization(50, 200, 50, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+    double best_performance = Evaluate_Circuit(best, false, 0, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0);
+
+    // a single generation from a population holding the good circuit keeps it; the
+    // circuits of the wrong size and the invalid ones are ignored
+    options.seed = 4;
+    options.initial_circuits = {best, {0, 1, 2}, std::vector<int>(11, 0)};
+    std::vector<int> result = Genetic_Optimization(50, 1, 50, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+    double result_performance = Evaluate_Circuit(result, false, 0, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0);
+    return result_performance >= best_performance - 1e-6;
+}
+
+bool test_Config()
+{
+    SolverConfig config;
+    Set_Config_Value(config, "price_gormanium", "50:100:25");
+    Set_Config_Value(config, "num_units", "4, 6");
+    Set_Config_Value(config, "selection", "tournament");
+    bool ok = config.price_gormanium == std::vector<double>{50.0, 75.0, 100.0} &&
+              config.num_units == std::vector<int>{4, 6} &&
+              config.options.selection == SelectionMethod::Tournament;
+
+    // the command line overrides the file, in order
+    std::string path = (std::filesystem::temp_directory_path() / "ga_config.txt").string();
+    std::ofstream file(path);
+    file << "# a sweep\nmode = sweep\nruns = 3  # per point\ncost_waste = 100,200\n";
+    file.close();
+    const char *argv[] = {"Genetic_Algorithm", "--config", path.c_str(), "--runs", "5", "--seed=7"};
+    Parse_Arguments(6, const_cast<char **>(argv), config);
+    std::remove(path.c_str());
+    ok = ok && config.mode == "sweep" && config.runs == 5 && config.options.seed == 7 &&
+         config.cost_waste == std::vector<double>{100.0, 200.0};
+
+    // unknown keys and bad values are errors
+    for (std::pair<std::string, std::string> bad : {std::make_pair("populaton_size", "10"),
+                                                    std::make_pair("runs", "ten"),
+                                                    std::make_pair("price_gormanium", "100:50:10"),
+                                                    std::make_pair("top_k", "0"),
+                                                    std::make_pair("mode", "annealing")})
+    {
+        try
+        {
+            Set_Config_Value(config, bad.first, bad.second);
+            ok = false;
+        }
+        catch (const std::invalid_argument &e)
+        {
+        }
+    }
+    return ok;
+}
+
+bool test_Sweep_Optimization()
+{
+    SolverConfig config;
+    config.population_size = 20;
+    config.max_iterations = 20;
+    config.threshold = 20;
+    config.runs = 2;
+    config.num_units = {4};
+    config.price_gormanium = {80.0, 100.0};
+    config.cost_waste = {400.0, 500.0};
+    config.options.warm_start = 0.5;
+    config.options.seed = 5;
+    std::vector<SweepResult> results = Sweep_Optimization(config);
+    if (results.size() != 4)
+    {
+        return false;
+    }
+
+    // grid order, last axis fastest; only the first point starts cold
+    bool ok = results[1].point.price_gormanium == 80.0 && results[1].point.cost_waste == 500.0 &&
+              results[2].point.price_gormanium == 100.0 && results[2].point.cost_waste == 400.0 &&
+              results[0].warm_started == 0;
+    for (int p = 1; p < 4; p++)
+    {
+        ok = ok && results[p].warm_started > 0 && results[p].warm_started <= 10;
+    }
+    for (const SweepResult &result : results)
+    {
+        double performance = Evaluate_Circuit(result.circuit, false, 0, 1e-4, 1000, result.point.price_gormanium,
+                                              result.point.cost_waste, 10.0, 100.0);
+        ok = ok && std::abs(performance - result.performance) < 1e-6 && result.recovery > 0.0 &&
+             result.recovery <= 1.0 && result.grade > 0.0 && result.grade <= 1.0;
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "ga_sweep.csv").string();
+    ok = ok && Write_Sweep_Table(path, results);
+    std::ifstream table(path);
+    std::string line;
+    int lines = 0;
+    while (std::getline(table, line))
+    {
+        lines++;
+    }
+    table.close();
+    std::remove(path.c_str());
+    return ok && lines == 5;
+}
+
+bool test_Evaluation_Database()
+{
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    std::string path = (std::filesystem::temp_directory_path() / "ga_evaluations.db").string();
+    std::remove(path.c_str());
+    GeneticOptions options;
+    options.seed = 9;
+    std::vector<int> plain = Genetic_Optimization(30, 30, 1000, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+
+    // the same run through a database gives the same circuit, and a second run with
+    // another cost of waste finds all the flows of the first one in the database
+    std::vector<int> first, second;
+    std::uint64_t stored;
+    {
+        EvaluationDatabase database(path, 5, 1 << 14);
+        options.evaluation_database = &database;
+        adaptive_rate = {1.0, 0.5, 1.0, 0.5};
+        first = Genetic_Optimization(30, 30, 1000, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+        stored = database.size();
+    }
+    EvaluationDatabase database(path, 5);
+    options.evaluation_database = &database;
+    adaptive_rate = {1.0, 0.5, 1.0, 0.5};
+    second = Genetic_Optimization(30, 1, 1000, adaptive_rate, 5, 10.0, 100.0, 100.0, 250.0, options);
+    bool ok = first == plain && stored > 30 && database.hits() == 30 && database.misses() == 0;
+    std::remove(path.c_str());
+    return ok;
+}
+
+bool test_Grow_Circuit()
+{
+    std::vector<int> circuit{0, 1, 2, 2, 0, 3, 4};
+    std::vector<std::vector<int>> grown = Grow_Circuit(circuit);
+    bool ok = !grown.empty();
+    for (const std::vector<int> &bigger : grown)
+    {
+        ok = ok && bigger.size() == 9 && utils::Check_Validity(bigger) == 0;
+    }
+    // a unit cleaning the concentrate of unit 0, sending its tailings back to unit 0
+    ok = ok && std::count(grown.begin(), grown.end(), std::vector<int>{0, 3, 2, 2, 0, 4, 5, 1, 0}) == 1;
+    return ok;
+}
+
+bool test_Design_Index()
+{
+    std::string path = (std::filesystem::temp_directory_path() / "ga_designs.txt").string();
+    std::remove(path.c_str());
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    GeneticOptions options;
+    options.seed = 10;
+    std::vector<int> best;
+    {
+        // a solved 5-unit problem is stored, and saved when the index is destroyed
+        DesignIndex index(path, 3);
+        options.design_index = &index;
+        best = Genetic_Optimization(50, 200, 50, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+        if (index.size() != 1)
+        {
+            return false;
+        }
+    }
+    DesignIndex index(path, 3);
+    double best_performance = Evaluate_Circuit(best, false, 0, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0);
+
+    // the same problem at twice the scale is the same problem, a near one comes next
+    index.Add({0, 1, 2, 2, 0, 3, 4}, 1.0, 10.0, 100.0, 150.0, 500.0);
+    std::vector<std::vector<int>> nearest = index.Nearest(5, 20.0, 200.0, 200.0, 1000.0, 5);
+    bool ok = index.size() == 2 && nearest.size() == 1 && nearest[0] == best &&
+              index.Nearest(3, 10.0, 100.0, 100.0, 500.0, 5).size() == 1;
+
+    // one generation started from the index keeps the stored circuit
+    options.design_index = &index;
+    options.seed = 11;
+    adaptive_rate = {1.0, 0.5, 1.0, 0.5};
+    std::vector<int> warm = Genetic_Optimization(50, 1, 50, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+    ok = ok && Evaluate_Circuit(warm, false, 0, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0) >= best_performance - 1e-6;
+
+    // a 6-unit problem starts from the 5-unit circuit grown by one unit, ranked for the problem
+    std::vector<std::vector<int>> grown = Warm_Start_Circuits(index, 4, 6, 10.0, 100.0, 100.0, 500.0);
+    ok = ok && grown.size() == 4 && grown[0].size() == 13;
+    double previous = 1e9;
+    for (const std::vector<int> &circuit : grown)
+    {
+        double performance = Evaluate_Circuit(circuit, false, 0, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0);
+        ok = ok && performance <= previous;
+        previous = performance;
+    }
+    std::remove(path.c_str());
+    return ok;
+}
+
+bool test_Circuit_Server()
+{
+    SolverConfig config;
+    config.population_size = 30;
+    CircuitServer server("", config);
+    double expected = Evaluate_Circuit({0, 1, 2, 2, 0, 3, 4}, false, 0, 1e-4, 1000, 100.0, 250.0, 10.0, 100.0);
+
+    // requests answered directly, from several threads, so that they are batched together
+    std::vector<std::string> answers(8);
+    std::vector<std::thread> clients;
+    for (int t = 0; t < 8; t++)
+    {
+        clients.emplace_back([&server, &answers, t] {
+            answers[t] = server.Handle("{\"id\": " + std::to_string(t) + ", \"type\": \"evaluate\", "
+                                       "\"cost_waste\": 250, \"circuits\": [[0, 1, 2, 2, 0, 3, 4], [0, 1, 2, 2, 0, 3, 4]]}");
+        });
+    }
+    for (std::thread &client : clients)
+    {
+        client.join();
+    }
+    bool ok = server.Stats().evaluations == 16 && server.Stats().batches <= 8;
+    for (int t = 0; t < 8; t++)
+    {
+        size_t start = answers[t].find("\"performance\": [") + 16;
+        ok = ok && answers[t].rfind("{\"id\": " + std::to_string(t) + ", ", 0) == 0 &&
+             std::abs(std::stod(answers[t].substr(start)) - expected) < 1e-9;
+    }
+    ok = ok && server.Handle("{\"type\": \"validate\", \"circuits\": [[0, 1, 2, 2, 0, 3, 4], [0, 4, 3, 2, 0, 3, 4], [0, 7, 1]]}") ==
+                   "{\"type\": \"validate\", \"valid\": [0, 1, -1]}";
+    ok = ok && server.Handle("{\"type\": \"evaluate\", \"circuits\": [[0, 4, 3, 2, 0, 3, 4]]}").find("\"error\"") != std::string::npos;
+    ok = ok && server.Handle("{\"type\": ").find("\"error\"") != std::string::npos;
+    std::string optimised = server.Handle("{\"type\": \"optimise\", \"num_units\": 4, \"seconds\": 0.2, \"seed\": 3}");
+    ok = ok && optimised.find("\"circuit\": [") != std::string::npos;
+    // optimise parameters out of range, and requests nested too deep, are errors, not crashes
+    for (const char *parameters : {"\"population_size\": 0", "\"population_size\": -1", "\"population_size\": 2.5",
+                                   "\"max_iterations\": 0", "\"threshold\": -3", "\"num_units\": 1e12",
+                                   "\"seed\": -1"})
+    {
+        ok = ok && server.Handle(std::string("{\"type\": \"optimise\", \"seconds\": 0.1, ") + parameters + "}")
+                           .rfind("{\"error\": ", 0) == 0;
+    }
+    ok = ok && server.Handle(std::string(200000, '[')).rfind("{\"error\": ", 0) == 0;
+
+#ifndef _WIN32
+    // the same over a socket, two requests in one write
+    std::string path = (std::filesystem::temp_directory_path() / "ga_server.sock").string();
+    CircuitServer listening(path, config);
+    std::thread running([&listening] { listening.Run(); });
+    int client = -1;
+    for (int attempt = 0; attempt < 100 && client < 0; attempt++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        client = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, path.c_str());
+        if (connect(client, (sockaddr *)&address, sizeof(address)) != 0)
+        {
+            close(client);
+            client = -1;
+        }
+    }
+    std::string requests = "{\"id\": 1, \"type\": \"validate\", \"circuits\": [[0, 1, 2, 2, 0, 3, 4]]}\n"
+                           "{\"id\": 2, \"type\": \"validate\", \"circuits\": []}\n";
+    std::string received;
+    if (client >= 0 && send(client, requests.data(), requests.size(), 0) == (ssize_t)requests.size())
+    {
+        char buffer[256];
+        ssize_t size;
+        while (std::count(received.begin(), received.end(), '\n') < 2 && (size = recv(client, buffer, sizeof(buffer), 0)) > 0)
+        {
+            received.append(buffer, size);
+        }
+        close(client);
+    }
+    listening.Stop();
+    running.join();
+    ok = ok && received == "{\"id\": 1, \"type\": \"validate\", \"valid\": [0]}\n"
+                           "{\"id\": 2, \"type\": \"validate\", \"valid\": []}\n";
+#endif
+    return ok;
+}
+
+bool test_Bulk_Evaluate()
+{
+    std::vector<int> good{0, 1, 2, 2, 0, 3, 4};
+    std::vector<int> cycle{0, 1, 1, 0, 0, 3, 4};
+    // files of data/ one after the other, with their flows, performance and fractions, a comment,
+    // a line that is not a circuit and a circuit out of range
+    std::stringstream text;
+    text << "0, 1, 2, 2, 0, 3, 4\n1.5, 2.5, 3.5, 4.5, 5.5\n1, 2, 3, 4, 5.25\n-1234.5\n0.3, 0.2, 0.25\n0.04, 0.05, 0.06\n\n"
+         << "# comment\n0 1 1 0 0 3 4\nnot a circuit\n0,1,2,2,0,3,9\n0,1,2,2,0,3,4\n";
+    BulkOptions options;
+    options.chunk_size = 2;
+    std::stringstream results;
+    BulkStats stats = Bulk_Evaluate(text, results, options);
+
+    std::string line;
+    std::vector<std::string> lines;
+    while (std::getline(results, line))
+    {
+        lines.push_back(line);
+    }
+    std::vector<double> gormanium(5), waste(5);
+    Evaluate_Flows(gormanium, waste, good, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0);
+    bool ok = stats.circuits == 5 && stats.valid == 2 && lines.size() == 6 &&
+              lines[0] == "valid,performance,concentrate_gormanium,concentrate_waste" &&
+              lines[1].rfind("0,", 0) == 0 && lines[1] == lines[5] &&
+              std::abs(std::stod(lines[1].substr(2)) - Evaluate_Circuit(good)) < 1e-6 &&
+              lines[2] == std::to_string(utils::Check_Validity(cycle)) + ",,," &&
+              lines[3] == "-1,,," && lines[4] == "-1,,,";
+
+    // circuits of 3 units after one of 2 units are circuits, not its flows
+    std::stringstream mixed("0 1 2 2 0 3 4\n0 1 3 2 0\n0 1 3 2 0\n"), mixed_results;
+    options.chunk_size = 1000;
+    stats = Bulk_Evaluate(mixed, mixed_results, options);
+    ok = ok && stats.circuits == 3;
+
+    // binary in and out agree with the text
+    std::stringstream binary, binary_results;
+    for (const std::vector<int> &circuit : {good, cycle})
+    {
+        std::uint16_t units = (circuit.size() - 1) / 2;
+        binary.write(reinterpret_cast<const char *>(&units), sizeof(units));
+        for (int gene : circuit)
+        {
+            std::uint16_t value = gene;
+            binary.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+    }
+    options.binary_input = options.binary_output = true;
+    stats = Bulk_Evaluate(binary, binary_results, options);
+    std::int32_t code[2];
+    double values[2][3];
+    for (int i = 0; i < 2; i++)
+    {
+        binary_results.read(reinterpret_cast<char *>(&code[i]), sizeof(code[i]));
+        binary_results.read(reinterpret_cast<char *>(values[i]), sizeof(values[i]));
+    }
+    return ok && stats.circuits == 2 && stats.valid == 1 && binary_results.good() && code[0] == 0 &&
+           std::abs(values[0][0] - Evaluate_Circuit(good)) < 1e-6 &&
+           std::abs(values[0][1] - gormanium[3]) < 1e-9 && std::abs(values[0][2] - waste[3]) < 1e-9 &&
+           code[1] != 0 && std::isnan(values[1][0]);
+}
+
+bool test_Gormanium_C_Interface()
+{
+    // two circuits in one contiguous array, as a NumPy array would pass them
+    int circuits[2][7] = {{0, 1, 2, 2, 0, 3, 4}, {0, 1, 1, 0, 0, 3, 4}};
+    std::vector<int> good(circuits[0], circuits[0] + 7);
+    int validity[2];
+    double performance[2], gormanium[2], waste[2];
+    int valid = gormanium_evaluate_batch(&circuits[0][0], 2, 3, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0, validity,
+                                         performance, gormanium, waste);
+
+    double flows_gormanium[5], flows_waste[5];
+    int flows = gormanium_evaluate_flows(circuits[0], 3, 1e-4, 1000, 10.0, 100.0, flows_gormanium, flows_waste);
+    int out_of_range[7] = {0, 1, 2, 2, 0, 3, 9};
+    int best[21];
+    double best_performance;
+    int optimised = gormanium_genetic_optimization(30, 20, 1000, 10, 10.0, 100.0, 100.0, 500.0, 5, best,
+                                                   &best_performance);
+    return gormanium_abi_version() == GORMANIUM_ABI_VERSION && valid == 1 && validity[0] == 0 &&
+           validity[1] == utils::Check_Validity(std::vector<int>(circuits[1], circuits[1] + 7)) &&
+           std::abs(performance[0] - Evaluate_Circuit(good)) < 1e-6 && std::isnan(performance[1]) &&
+           flows == GORMANIUM_OK && std::abs(flows_gormanium[3] - gormanium[0]) < 1e-9 &&
+           std::abs(flows_waste[3] - waste[0]) < 1e-9 &&
+           gormanium_evaluate_circuit(circuits[0], 3, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0) == performance[0] &&
+           gormanium_check_validity(circuits[0], 3) == 0 &&
+           gormanium_check_validity(out_of_range, 3) == GORMANIUM_MALFORMED &&
+           std::isnan(gormanium_evaluate_circuit(out_of_range, 3, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0)) &&
+           gormanium_evaluate_batch(nullptr, 1, 3, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0, nullptr, nullptr, nullptr,
+                                    nullptr) == GORMANIUM_BAD_ARGUMENT &&
+           optimised == GORMANIUM_OK && utils::Check_Validity(std::vector<int>(best, best + 21)) == 0 &&
+           std::abs(best_performance - Evaluate_Circuit(std::vector<int>(best, best + 21))) < 1e-6;
+}
+
+bool test_Gormanium_Exports(const std::string &library)
+{
+    bool ok = true;
+#ifdef __linux__
+    // the shared library exports the C interface and nothing else
+    FILE *symbols = popen(("nm -D --defined-only " + library + " 2>/dev/null").c_str(), "r");
+    char line[4096];
+    int exported = 0;
+    while (symbols != nullptr && fgets(line, sizeof(line), symbols) != nullptr)
+    {
+        const char *name = strrchr(line, ' ');
+        ok = ok && name != nullptr && strncmp(name + 1, "gormanium_", 10) == 0;
+        exported++;
+    }
+    ok = ok && symbols != nullptr && pclose(symbols) == 0 && exported > 0;
+#endif
+    return ok;
+}
+
+bool test_Unit_Fractions()
+{
+    std::vector<int> circuit{0, 1, 2, 2, 0, 3, 4};
+    std::vector<double> gormanium(5), waste(5), uniform_gormanium(5), uniform_waste(5);
+    // the fractions of the original problem given per unit give exactly the same flows
+    Evaluate_Flows(uniform_gormanium, uniform_waste, circuit);
+    UnitFractions same{std::vector<double>(3, FRACTION_GORMANIUM), std::vector<double>(3, FRACTION_WASTE)};
+    Evaluate_Flows(gormanium, waste, circuit, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0, same);
+    bool ok = gormanium == uniform_gormanium && waste == uniform_waste;
+
+    // other fractions change the flows, and the mass still balances
+    UnitFractions better{{0.4, 0.2, 0.2}, {0.02, 0.05, 0.05}};
+    Evaluate_Flows(gormanium, waste, circuit, 1e-6, 10000, 100.0, 500.0, 10.0, 100.0, better);
+    ok = ok && std::abs(gormanium[0] - uniform_gormanium[0]) > 0.1 && std::abs(waste[1] - uniform_waste[1]) > 0.1 &&
+         std::abs(gormanium[3] + gormanium[4] - 10.0) < 1e-3 && std::abs(waste[3] + waste[4] - 100.0) < 1e-2 &&
+         std::abs(Evaluate_Circuit(circuit, false, 0, 1e-6, 10000, 100.0, 500.0, 10.0, 100.0, better) -
+                  (gormanium[3] * 100.0 - waste[3] * 500.0)) < 1e-9;
+
+    // the fractions must be given for every unit, strictly between 0 and 1
+    UnitFractions short_fractions{{0.4, 0.2}, {0.02, 0.05}};
+    UnitFractions total{{1.0, 0.2, 0.2}, {0.02, 0.05, 0.05}};
+    bool rejected = false;
+    try
+    {
+        Evaluate_Flows(gormanium, waste, circuit, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0, short_fractions);
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+    ok = ok && rejected && utils::Check_Validity(circuit, better) == 0 &&
+         utils::Check_Validity(circuit, short_fractions) == 2 && utils::Check_Validity(circuit, total) == 2 &&
+         utils::Check_Validity(std::vector<int>{0, 1, 1, 0, 0, 3, 4}, better) ==
+             utils::Check_Validity(std::vector<int>{0, 1, 1, 0, 0, 3, 4});
+
+    // the algorithms optimise for the given units, and ignore canonical labels
+    GeneticOptions options;
+    options.seed = 3;
+    options.canonical_labels = true;
+    options.fractions = {{0.2, 0.2, 0.2, 0.2, 0.4}, {0.05, 0.05, 0.05, 0.05, 0.02}};
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    std::vector<int> best = Genetic_Optimization(50, 200, 50, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+    adaptive_rate = {1.0, 0.5, 1.0, 0.5};
+    std::vector<int> steady = Steady_State_Optimization(50, 2000, 500, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0,
+                                                        options);
+    options.fractions = {};
+    adaptive_rate = {1.0, 0.5, 1.0, 0.5};
+    std::vector<int> uniform_best = Genetic_Optimization(50, 200, 50, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0,
+                                                         options);
+    UnitFractions plant{{0.2, 0.2, 0.2, 0.2, 0.4}, {0.05, 0.05, 0.05, 0.05, 0.02}};
+    auto performance = [&plant](const std::vector<int> &c) {
+        return Evaluate_Circuit(c, false, 0, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0, plant);
+    };
+    return ok && utils::Check_Validity(best, plant) == 0 && utils::Check_Validity(steady, plant) == 0 &&
+           performance(best) >= performance(uniform_best) - 1e-6;
+}
+
+bool test_Robust_Evaluation()
+{
+    std::vector<int> circuit{0, 1, 2, 2, 0, 3, 4};
+    UnitFractions nominal{{0.2, 0.3, 0.25}, {0.05, 0.04, 0.06}};
+    // an odd number of scenarios, so that the vectorised loops have a remainder
+    ScenarioSet scenarios = Sample_Scenarios(3, 17, 10.0, 100.0, nominal, 0.2, 0.3, 5);
+    std::vector<double> conc_gormanium, conc_waste;
+    std::vector<char> converged;
+    Evaluate_Scenario_Flows(circuit, scenarios, conc_gormanium, conc_waste, converged);
+
+    // the batched flows are those of one Evaluate_Flows per scenario
+    bool ok = scenarios.count == 17 && (int)conc_gormanium.size() == 17;
+    double sum = 0.0, worst = 0.0;
+    for (int k = 0; k < scenarios.count && ok; k++)
+    {
+        std::vector<double> gormanium(5), waste(5);
+        Evaluate_Flows(gormanium, waste, circuit, 1e-4, 1000, 100.0, 500.0, scenarios.feed_gormanium[k],
+                       scenarios.feed_waste[k], scenarios.fractions_of(k));
+        ok = converged[k] && std::abs(conc_gormanium[k] - gormanium[3]) <= 1e-12 * gormanium[3] &&
+             std::abs(conc_waste[k] - waste[3]) <= 1e-12 * waste[3];
+        double performance = Evaluate_Circuit(circuit, false, 0, 1e-4, 1000, 100.0, 500.0, scenarios.feed_gormanium[k],
+                                              scenarios.feed_waste[k], scenarios.fractions_of(k));
+        sum += performance;
+        worst = k == 0 ? performance : std::min(worst, performance);
+    }
+    ok = ok && std::abs(Robust_Performance(circuit, scenarios, 100.0, 500.0, RobustObjective::Expected) - sum / 17) < 1e-6 &&
+         std::abs(Robust_Performance(circuit, scenarios, 100.0, 500.0, RobustObjective::Worst_Case) - worst) < 1e-6;
+
+    // without spread every scenario is the nominal one
+    ScenarioSet fixed = Sample_Scenarios(3, 4, 10.0, 100.0, nominal, 0.0, 0.0, 1);
+    ok = ok && std::abs(Robust_Performance(circuit, fixed, 100.0, 500.0, RobustObjective::Worst_Case) -
+                        Evaluate_Circuit(circuit, false, 0, 1e-4, 1000, 100.0, 500.0, 10.0, 100.0, nominal)) < 1e-9;
+
+    // the scenarios are for a given number of units
+    bool rejected = false;
+    try
+    {
+        Evaluate_Scenario_Flows(std::vector<int>{0, 1, 2, 2, 3}, scenarios, conc_gormanium, conc_waste, converged);
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+
+    // both algorithms optimise the robust performance
+    GeneticOptions options;
+    options.seed = 4;
+    options.robust.scenarios = 8;
+    options.robust.objective = RobustObjective::Worst_Case;
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    std::vector<int> best = Genetic_Optimization(50, 200, 50, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+    adaptive_rate = {1.0, 0.5, 1.0, 0.5};
+    std::vector<int> steady = Steady_State_Optimization(50, 2000, 500, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0,
+                                                        options);
+    ScenarioSet plant = Sample_Scenarios(5, 10.0, 100.0, UnitFractions(), options.robust);
+    return ok && rejected && utils::Check_Validity(best) == 0 && utils::Check_Validity(steady) == 0 &&
+           Robust_Performance(best, plant, 100.0, 500.0, RobustObjective::Worst_Case) > 0.0 &&
+           Robust_Performance(best, plant, 100.0, 500.0, RobustObjective::Worst_Case) <=
+               Robust_Performance(best, plant, 100.0, 500.0, RobustObjective::Expected);
+}
+
+bool test_Performance_Sensitivity()
+{
+    std::vector<int> circuit{0, 1, 2, 2, 0, 3, 4};
+    UnitFractions fractions{{0.2, 0.3, 0.25}, {0.05, 0.04, 0.06}};
+    PerformanceSensitivity sensitivity;
+    Performance_Sensitivity(circuit, sensitivity, 1e-12, 100000, 100.0, 500.0, 10.0, 100.0, fractions);
+
+    // every derivative against a central difference of Evaluate_Circuit
+    auto performance = [&circuit](double price, double cost, double feed_gormanium, double feed_waste,
+                                  const UnitFractions &f) {
+        return Evaluate_Circuit(circuit, false, 0, 1e-12, 100000, price, cost, feed_gormanium, feed_waste, f);
+    };
+    auto close = [](double adjoint, double difference) {
+        return std::abs(adjoint - difference) <= 1e-5 * std::max(1.0, std::abs(difference));
+    };
+    double h = 1e-5;
+    bool ok = close(sensitivity.performance, performance(100.0, 500.0, 10.0, 100.0, fractions)) &&
+              close(sensitivity.price_gormanium,
+                    (performance(100.0 + h, 500.0, 10.0, 100.0, fractions) - performance(100.0 - h, 500.0, 10.0, 100.0, fractions)) / (2 * h)) &&
+              close(sensitivity.cost_waste,
+                    (performance(100.0, 500.0 + h, 10.0, 100.0, fractions) - performance(100.0, 500.0 - h, 10.0, 100.0, fractions)) / (2 * h)) &&
+              close(sensitivity.feed_gormanium,
+                    (performance(100.0, 500.0, 10.0 + h, 100.0, fractions) - performance(100.0, 500.0, 10.0 - h, 100.0, fractions)) / (2 * h)) &&
+              close(sensitivity.feed_waste,
+                    (performance(100.0, 500.0, 10.0, 100.0 + h, fractions) - performance(100.0, 500.0, 10.0, 100.0 - h, fractions)) / (2 * h));
+    for (int i = 0; i < 3; i++)
+    {
+        UnitFractions up = fractions, down = fractions;
+        up.gormanium[i] += h;
+        down.gormanium[i] -= h;
+        ok = ok && close(sensitivity.fraction_gormanium[i],
+                         (performance(100.0, 500.0, 10.0, 100.0, up) - performance(100.0, 500.0, 10.0, 100.0, down)) / (2 * h));
+        up = fractions;
+        down = fractions;
+        up.waste[i] += h;
+        down.waste[i] -= h;
+        ok = ok && close(sensitivity.fraction_waste[i],
+                         (performance(100.0, 500.0, 10.0, 100.0, up) - performance(100.0, 500.0, 10.0, 100.0, down)) / (2 * h));
+        ok = ok && sensitivity.recovery_gormanium[i] > 0.0 && sensitivity.recovery_gormanium[i] < 1.0;
+    }
+
+    // the uniform units of the original problem, and a circuit that does not converge
+    Performance_Sensitivity(circuit, sensitivity);
+    bool not_converged = false;
+    try
+    {
+        Performance_Sensitivity(circuit, sensitivity, 1e-12, 3);
+    }
+    catch (const int error_code)
+    {
+        not_converged = error_code == 1;
+    }
+    return ok && not_converged && std::abs(sensitivity.performance - Evaluate_Circuit(circuit)) < 1e-9 &&
+           sensitivity.fraction_gormanium.size() == 3;
+}
+
+bool test_Single_Precision()
+{
+    // all the scenarios of a circuit screened in float are within the margin of the double ones
+    std::vector<int> circuit{0, 1, 2, 2, 0, 3, 4};
+    ScenarioSet scenarios = Sample_Scenarios(3, 9, 10.0, 100.0, UnitFractions(), 0.2, 0.2, 2);
+    double margin = Screening_Margin(1e-4, 100.0, 500.0,
+                                     *std::max_element(scenarios.feed_gormanium.begin(), scenarios.feed_gormanium.end()),
+                                     *std::max_element(scenarios.feed_waste.begin(), scenarios.feed_waste.end()));
+    bool ok = std::abs(Robust_Performance(circuit, scenarios, 100.0, 500.0, RobustObjective::Expected, true) -
+                       Robust_Performance(circuit, scenarios, 100.0, 500.0, RobustObjective::Expected)) < margin;
+    std::mt19937 rng(9);
+    std::vector<std::vector<int>> population;
+    Generate_Initial(50, population, 10, rng);
+    ScenarioSet wider = Sample_Scenarios(10, 8, 10.0, 100.0, UnitFractions(), 0.1, 0.1, 3);
+    std::vector<double> double_performance, single_performance;
+    Robust_Population_Performance(population, wider, 100.0, 500.0, RobustObjective::Worst_Case, double_performance);
+    Robust_Population_Performance(population, wider, 100.0, 500.0, RobustObjective::Worst_Case, single_performance,
+                                  true);
+    ok = ok && double_performance.size() == 50 && single_performance.size() == 50;
+    // the screening only underestimates by less than the margin, the scenarios that do not
+    // converge included
+    for (int i = 0; i < 50; i++)
+    {
+        ok = ok && single_performance[i] > double_performance[i] - margin;
+    }
+
+    // the best circuit of a screened population has its double precision performance
+    std::vector<double> screened_performance;
+    int refined = Screen_Robust_Population(population, wider, 100.0, 500.0, RobustObjective::Worst_Case,
+                                           screened_performance, margin);
+    ok = ok && refined >= 1 &&
+         *std::max_element(screened_performance.begin(), screened_performance.end()) ==
+             *std::max_element(double_performance.begin(), double_performance.end());
+
+    // the best circuits, the elites and those within the margin of the best, are refined
+    std::vector<int> candidates = Refinement_Candidates({5.0, 100.0, 60.0, 95.0, -3.0}, 1, 10.0);
+    ok = ok && candidates == std::vector<int>{1, 3} &&
+         Refinement_Candidates({5.0, 100.0, 60.0, 95.0, -3.0}, 3, 1.0) == std::vector<int>{1, 3, 2};
+
+    // the best circuit of every generation has its double precision performance
+    HallOfFame hall_of_fame(1);
+    GeneticOptions options;
+    options.seed = 5;
+    options.single_precision = true;
+    options.robust.scenarios = 8;
+    options.hall_of_fame = &hall_of_fame;
+    std::vector<double> adaptive_rate{1.0, 0.5, 1.0, 0.5};
+    std::vector<int> best = Genetic_Optimization(30, 50, 20, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0, options);
+    std::vector<int> famous;
+    double famous_performance = hall_of_fame.Best(famous);
+    ScenarioSet sampled = Sample_Scenarios(5, 10.0, 100.0, UnitFractions(), options.robust);
+    options.hall_of_fame = nullptr;
+    adaptive_rate = {1.0, 0.5, 1.0, 0.5};
+    std::vector<int> steady = Steady_State_Optimization(30, 500, 200, adaptive_rate, 5, 10.0, 100.0, 100.0, 500.0,
+                                                        options);
+    return ok && utils::Check_Validity(best) == 0 && utils::Check_Validity(steady) == 0 &&
+           famous_performance == Robust_Performance(famous, sampled, 100.0, 500.0, RobustObjective::Expected);
+}
+
 void print_Result(bool result, std::string title)
 {
     std::cout << title;
@@ -166,4 +1242,34 @@ int main(int argc, char *argv[])
     print_Result(test_Performance(), "Performance Test");
     print_Result(test_Fitness(), "Fitness Test");
     print_Result(test_Probability(), "Probability Test");
+    print_Result(test_Reprice_Population(), "Reprice_Population Test");
+    print_Result(test_Non_Dominated_Sort(), "Non_Dominated_Sort Test");
+    print_Result(test_Pareto_Optimization(), "Pareto_Optimization Test");
+    print_Result(test_Local_Search(), "Local_Search Test");
+    print_Result(test_Local_Search_Random_Order(), "Local_Search Random Order Test");
+    print_Result(test_Genetic_Optimization_Local_Search(), "Genetic_Optimization Local Search Test");
+    print_Result(test_Exhaustive_Optimization(), "Exhaustive_Optimization Test");
+    print_Result(test_Genetic_Optimization_Canonical(), "Genetic_Optimization Canonical Labels Test");
+    print_Result(test_Mutation_Rate(), "Mutation Rate Test");
+    print_Result(test_Steady_State_Optimization(), "Steady_State_Optimization Test");
+    print_Result(test_Hall_Of_Fame(), "Hall_Of_Fame Test");
+    print_Result(test_Checkpoint_Resume(), "Checkpoint Resume Test");
+    print_Result(test_Genetic_Optimization_Archive(), "Genetic_Optimization Archive Test");
+    print_Result(test_Generation_Log(), "Generation Log Test");
+    print_Result(test_Initial_Circuits(), "Initial Circuits Test");
+    print_Result(test_Config(), "Config Test");
+    print_Result(test_Sweep_Optimization(), "Sweep_Optimization Test");
+    print_Result(test_Evaluation_Database(), "Evaluation Database Test");
+    print_Result(test_Grow_Circuit(), "Grow_Circuit Test");
+    print_Result(test_Design_Index(), "Design Index Test");
+    print_Result(test_Circuit_Server(), "Circuit Server Test");
+    print_Result(test_Bulk_Evaluate(), "Bulk_Evaluate Test");
+    print_Result(test_Gormanium_C_Interface(), "Gormanium C Interface Test");
+    print_Result(test_Gormanium_Exports((std::filesystem::path(argv[0]).parent_path() / ".." / ".." / "bin" /
+                                         "libgormanium.so").string()),
+                 "Gormanium Exports Test");
+    print_Result(test_Unit_Fractions(), "Unit Fractions Test");
+    print_Result(test_Robust_Evaluation(), "Robust Evaluation Test");
+    print_Result(test_Performance_Sensitivity(), "Performance Sensitivity Test");
+    print_Result(test_Single_Precision(), "Single Precision Test");
 }
@@ -1,11 +1,16 @@
 // local includes
 #include "CUnit.h"
 #include "utils.h"
+#include "Archive.h"
+#include "Background_Writer.h"
+#include "Evaluation_Database.h"
 // system includes
 #include <assert.h>
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <cstdio>
+#include <thread>
 
 // The purpose of these tests are to test the file writing functions.
 // Having this test ensures we can easily maintain the cross platform
@@ -48,4 +53,269 @@ int main(int argc, char *argv[])
         assert(contents[0][j] == *std::to_string(schematic[i]).c_str());
     }
     assert(contents[3] == std::to_string(perf));
-}
\ No newline at end of file
+
+    // binary archive: write a few records, in two sessions, read them back in place
+    std::string archive_path = data_dir + utils::File_Sep() + "test_archive.bin";
+    std::remove(archive_path.c_str());
+    std::vector<double> unit_flows(flows.begin(), flows.begin() + n + 2);
+    {
+        ArchiveWriter writer(archive_path, n, 2);
+        writer.Append(schematic, perf, 7, iter, unit_flows, unit_flows);
+        writer.Append(schematic, -1.5, 7, iter + 1);
+        writer.Append(std::vector<int>{0, 3, 1, 2, 4, 2, 1}, 2.25, 8, 3);
+        assert(writer.size() == 3);
+    }
+    {
+        ArchiveWriter writer(archive_path, n);
+        assert(writer.size() == 3);
+        writer.Append(schematic, 4.0, 9, 1);
+    }
+    {
+        ArchiveReader reader(archive_path);
+        assert(reader.size() == 4);
+        assert(reader.num_units() == n);
+        assert(reader[0].Circuit() == schematic);
+        assert(reader[0].performance() == perf);
+        assert(reader[0].has_flows());
+        assert(reader[0].Gormanium() == unit_flows && reader[0].Waste() == unit_flows);
+        assert(reader[0].run() == 7 && reader[0].generation() == iter);
+        assert(!reader[1].has_flows() && reader[1].performance() == -1.5);
+        assert(reader[2].gene(1) == 3 && reader[2].run() == 8);
+        assert(reader[3].performance() == 4.0);
+    }
+    // an archive for other circuits cannot be appended to
+    bool refused = false;
+    try
+    {
+        ArchiveWriter writer(archive_path, n + 1);
+    }
+    catch (const BadArchive &e)
+    {
+        refused = true;
+    }
+    assert(refused);
+
+    // conversion of run 8 to the text format
+    assert(Archive_To_Text(archive_path, data_dir, 8) == 1);
+    std::ifstream converted(data_dir + utils::File_Sep() + "circuit_3_3.txt");
+    assert(std::getline(converted, line) && line == "0, 3, 1, 2, 4, 2, 1");
+    converted.close();
+    std::remove((data_dir + utils::File_Sep() + "circuit_3_3.txt").c_str());
+
+    // and of all the records to a DOT file
+    std::string dot_path = data_dir + utils::File_Sep() + "test_archive.dot";
+    assert(Archive_To_Dot(archive_path, dot_path) == 4);
+    std::ifstream dot_file(dot_path);
+    int graphs = 0;
+    while (std::getline(dot_file, line))
+    {
+        graphs += line.rfind("digraph \"run_", 0) == 0;
+    }
+    dot_file.close();
+    assert(graphs == 4);
+    std::remove(dot_path.c_str());
+
+    // an archive whose record size does not match its number of units is not read
+    {
+        std::fstream corrupted(archive_path, std::ios::in | std::ios::out | std::ios::binary);
+        std::uint32_t record_size = 8;
+        corrupted.seekp(16);
+        corrupted.write(reinterpret_cast<const char *>(&record_size), sizeof(record_size));
+    }
+    refused = false;
+    try
+    {
+        ArchiveReader reader(archive_path);
+    }
+    catch (const BadArchive &e)
+    {
+        refused = true;
+    }
+    assert(refused);
+    std::remove(archive_path.c_str());
+
+    // DOT description, with flow labels only when the flows are known
+    std::string dot;
+    utils::Append_Dot(dot, schematic, unit_flows, unit_flows, iter, perf);
+    assert(dot.rfind("digraph \"circuit\" {", 0) == 0);
+    assert(dot.find("\"Unit 1\" -> \"Unit 0\"") != std::string::npos);
+    assert(dot.find("label=\"G: ") != std::string::npos);
+    std::string plain;
+    utils::Append_Dot(plain, schematic);
+    assert(plain.find("label=") == std::string::npos);
+    assert(plain.find("\"Unit 2\" -> \"Tailings\" [color=red, style=dashed") != std::string::npos);
+    utils::Print_Circuits_To_Dot(data_dir + utils::File_Sep() + "test_circuits.dot", {schematic, schematic}, {unit_flows}, {unit_flows}, {1, 2});
+    std::ifstream dot_circuits(data_dir + utils::File_Sep() + "test_circuits.dot");
+    std::stringstream dot_contents;
+    dot_contents << dot_circuits.rdbuf();
+    dot_circuits.close();
+    assert(dot_contents.str().find("digraph \"circuit_3_1\"") == 0);
+    assert(dot_contents.str().find("digraph \"circuit_3_2\"") != std::string::npos);
+    std::remove((data_dir + utils::File_Sep() + "test_circuits.dot").c_str());
+
+    // background writer: same file as Print_Circuit_To_File
+    std::ifstream direct(filename);
+    std::stringstream expected;
+    expected << direct.rdbuf();
+    direct.close();
+    std::remove(filename.c_str());
+    {
+        BackgroundWriter writer;
+        writer.Write_Circuit(data_dir, schematic, flows, flows, iter, perf);
+        writer.Flush();
+        std::ifstream background(filename);
+        std::stringstream written;
+        written << background.rdbuf();
+        assert(written.str() == expected.str());
+    }
+
+    // units with their own fractions: two more lines, from both writers
+    UnitFractions fractions{{0.3, 0.2, 0.25}, {0.04, 0.05, 0.06}};
+    utils::Print_Circuit_To_File(data_dir, schematic, flows, flows, iter, perf, fractions);
+    std::ifstream direct_fractions(filename);
+    std::stringstream expected_fractions;
+    expected_fractions << direct_fractions.rdbuf();
+    direct_fractions.close();
+    assert(expected_fractions.str() == expected.str() + "\n0.3, 0.2, 0.25\n0.04, 0.05, 0.06");
+    {
+        BackgroundWriter writer;
+        writer.Write_Circuit(data_dir, schematic, flows, flows, iter, perf, fractions);
+        writer.Flush();
+        std::ifstream background(filename);
+        std::stringstream written;
+        written << background.rdbuf();
+        assert(written.str() == expected_fractions.str());
+    }
+
+    // values that need rounding get the same digits from both writers
+    std::vector<double> long_flows{1.0 / 3.0, 2.123456789, 1e-7 / 3.0, 123456789.0, 0.0};
+    double long_perf = -1234.56789;
+    utils::Print_Circuit_To_File(data_dir, schematic, long_flows, long_flows, iter, long_perf);
+    std::ifstream direct_long(filename);
+    std::stringstream expected_long;
+    expected_long << direct_long.rdbuf();
+    direct_long.close();
+    assert(expected_long.str().find("0.333333, 2.12346, 3.33333e-08, 1.23457e+08, 0\n") != std::string::npos);
+    {
+        BackgroundWriter writer;
+        writer.Write_Circuit(data_dir, schematic, long_flows, long_flows, iter, long_perf);
+        writer.Flush();
+        std::ifstream background(filename);
+        std::stringstream written;
+        written << background.rdbuf();
+        assert(written.str() == expected_long.str());
+    }
+
+    // many threads appending lines through a small queue, nothing is lost
+    std::string log_path = data_dir + utils::File_Sep() + "test_writer.log";
+    std::remove(log_path.c_str());
+    WriterStats stats;
+    {
+        BackgroundWriter writer(8);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&writer, &log_path, t] {
+                for (int i = 0; i < 2000; i++)
+                {
+                    writer.Append_Line(log_path, std::to_string(t) + " " + std::to_string(i));
+                }
+            });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        // the destructor flushes
+        stats = writer.Stats();
+    }
+    std::ifstream log(log_path);
+    int lines = 0;
+    while (std::getline(log, line))
+    {
+        lines++;
+    }
+    log.close();
+    assert(lines == 8000);
+    assert(stats.submitted == 8000);
+    assert(stats.max_depth <= 8);
+    std::remove(log_path.c_str());
+
+    // evaluation database: stored flows survive reopening, and two handles on the same
+    // file, used by several threads at once, see each other's circuits
+    std::string database_path = data_dir + utils::File_Sep() + "test_evaluations.db";
+    std::remove(database_path.c_str());
+    {
+        EvaluationDatabase database(database_path, n, 64);
+        CircuitFlows found;
+        assert(database.capacity() == 64 && database.size() == 0);
+        assert(!database.Lookup(schematic, 10.0, 100.0, 0.2, 0.05, found));
+        assert(database.Insert(schematic, 10.0, 100.0, 0.2, 0.05, {1.5, 2.5, 8.5, 97.5, true}));
+        assert(database.Insert(schematic, 10.0, 100.0, 0.2, 0.05, {1.5, 2.5, 8.5, 97.5, true}));
+        assert(database.size() == 1);
+        // a circuit of another size is not stored
+        assert(!database.Insert({0, 1, 2}, 10.0, 100.0, 0.2, 0.05, found));
+    }
+    {
+        EvaluationDatabase first(database_path, n);
+        EvaluationDatabase second(database_path, n);
+        CircuitFlows found;
+        assert(first.capacity() == 64);
+        assert(first.Lookup(schematic, 10.0, 100.0, 0.2, 0.05, found));
+        assert(found.conc_gormanium == 1.5 && found.tail_waste == 97.5 && found.converged);
+        // any other feed rate or fraction is another key
+        assert(!first.Lookup(schematic, 10.0, 100.0, 0.2, 0.06, found));
+        assert(!first.Lookup(schematic, 20.0, 100.0, 0.2, 0.05, found));
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&first, &second, t] {
+                EvaluationDatabase &database = t % 2 == 0 ? first : second;
+                for (int i = 0; i < 100; i++)
+                {
+                    // 40 distinct keys, each inserted by two threads
+                    double feed = 101.0 + (t / 2 * 20 + i % 20);
+                    database.Insert({0, 1, 2, 2, 0, 3, 4}, feed, 100.0, 0.2, 0.05, {feed, 0.0, 0.0, 0.0, true});
+                }
+            });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        assert(first.size() >= 41 && second.size() == first.size() && first.size() <= 48);
+        for (int k = 0; k < 40; k++)
+        {
+            assert(second.Lookup(schematic, 101.0 + k, 100.0, 0.2, 0.05, found) && found.conc_gormanium == 101.0 + k);
+        }
+        // three quarters full, nothing more is added
+        for (int k = 200; k < 300; k++)
+        {
+            first.Insert(schematic, k, 100.0, 0.2, 0.05, found);
+        }
+        assert(first.size() == 48);
+    }
+    // another number of units or tolerance is refused
+    refused = false;
+    try
+    {
+        EvaluationDatabase wrong(database_path, n + 1);
+    }
+    catch (const BadEvaluationDatabase &e)
+    {
+        refused = true;
+    }
+    assert(refused);
+    refused = false;
+    try
+    {
+        EvaluationDatabase wrong(database_path, n, 64, 1e-6);
+    }
+    catch (const BadEvaluationDatabase &e)
+    {
+        refused = true;
+    }
+    assert(refused);
+    std::remove(database_path.c_str());
+}
@@ -0,0 +1,140 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "Selection.h"
+
+// The purpose of these tests is to check that the parent selection schemes
+// draw the circuits with the expected frequencies.
+
+bool test_Alias_Table()
+{
+    std::vector<double> weights{5, 15, 20, 25, 15, 5, 15, 0};
+    AliasTable table(weights);
+    std::mt19937 rng(42);
+
+    int draws = 1000000;
+    std::vector<int> counts(weights.size(), 0);
+    for (int i = 0; i < draws; i++)
+    {
+        counts[table.Sample(rng)]++;
+    }
+    // frequencies within a few standard deviations of the weights
+    for (size_t i = 0; i < weights.size(); i++)
+    {
+        double expected = draws * weights[i] / 100.0;
+        if (std::abs(counts[i] - expected) > 5 * std::sqrt(expected) + 1)
+        {
+            return false;
+        }
+    }
+    return counts.back() == 0;
+}
+
+bool test_Alias_Table_Uniform()
+{
+    // all weights zero, every index equally likely
+    AliasTable table(std::vector<double>(4, 0.0));
+    std::mt19937 rng(1);
+    std::vector<int> counts(4, 0);
+    for (int i = 0; i < 40000; i++)
+    {
+        counts[table.Sample(rng)]++;
+    }
+    for (int count : counts)
+    {
+        if (std::abs(count - 10000) > 500)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool test_Stochastic_Universal_Sampling()
+{
+    std::vector<double> fitness{10, 30, 0, 40, 20};
+    std::mt19937 rng(7);
+    std::vector<int> selected;
+    Stochastic_Universal_Sampling(fitness, 20, selected, rng);
+
+    if (selected.size() != 20)
+    {
+        return false;
+    }
+    // every circuit gets either the floor or the ceiling of its expected number of copies
+    std::vector<int> counts(fitness.size(), 0);
+    for (int index : selected)
+    {
+        counts[index]++;
+    }
+    for (size_t i = 0; i < fitness.size(); i++)
+    {
+        double expected = 20 * fitness[i] / 100.0;
+        if (counts[i] < std::floor(expected) || counts[i] > std::ceil(expected))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool test_Tournament_Selection()
+{
+    std::vector<double> fitness{1, 2, 3, 4};
+    std::mt19937 rng(3);
+    // a tournament of one is uniform, a huge tournament almost surely finds the best
+    bool uniform_ok = true;
+    std::vector<int> counts(4, 0);
+    for (int i = 0; i < 40000; i++)
+    {
+        counts[Tournament_Selection(fitness, 1, rng)]++;
+    }
+    for (int count : counts)
+    {
+        uniform_ok = uniform_ok && std::abs(count - 10000) < 500;
+    }
+    return uniform_ok && Tournament_Selection(fitness, 200, rng) == 3;
+}
+
+bool test_Parent_Selector()
+{
+    std::vector<double> fitness{1, 2, 3, 4};
+    std::mt19937 rng(11);
+    for (SelectionMethod method : {SelectionMethod::Roulette, SelectionMethod::Alias,
+                                   SelectionMethod::Stochastic_Universal, SelectionMethod::Tournament})
+    {
+        ParentSelector selector(fitness, method);
+        for (int i = 0; i < 100; i++)
+        {
+            int index = selector.Next(rng);
+            if (index < 0 || index >= 4)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void print_Result(bool result, std::string title)
+{
+    std::cout << title;
+    if (result)
+    {
+        std::cout << ": pass\n";
+    }
+    else
+    {
+        std::cout << ": fail\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    print_Result(test_Alias_Table(), "Alias Table Test");
+    print_Result(test_Alias_Table_Uniform(), "Alias Table Uniform Test");
+    print_Result(test_Stochastic_Universal_Sampling(), "Stochastic Universal Sampling Test");
+    print_Result(test_Tournament_Selection(), "Tournament Selection Test");
+    print_Result(test_Parent_Selector(), "Parent Selector Test");
+}
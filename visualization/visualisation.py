@@ -16,7 +16,10 @@ Group members:
     Jie Zhu
 """
 
+import argparse
+import json
 import os
+import time
 import graphviz
 import numpy as np
 
@@ -44,10 +47,13 @@ class Circuit_diagram:
     :type  performance: number (optional), default to -np.nan
     :param output_file: file name of the output image file
     :type  output_file: string (optional), default to "gormanium"
-    :param g_frac: fraction of the gormanium going to concentration outflow
-    :type  g_frac: number (optional), default to 0.2
-    :param w_frac: fraction of the waste going to concentration outflow
-    :type  w_frac: number (optional), default to 0.05
+    :param g_frac: fraction of the gormanium going to concentration outflow,
+                   for every unit or of each unit, replaced by the fractions
+                   of the data file if it has them
+    :type  g_frac: number or list of numbers (optional), default to 0.2
+    :param w_frac: fraction of the waste going to concentration outflow,
+                   as for g_frac
+    :type  w_frac: number or list of numbers (optional), default to 0.05
     :param g_in: the gormanium volume flow into the circuit (kg/s)
     :type  g_in: number (optional), default to 10
     :param w_in: the waste volume flow into the circuit (kg/s)
@@ -61,6 +67,7 @@ class Circuit_diagram:
                  g_in=10, w_in=100):
 
         self.input_file = file
+        self.file_fractions = None
         if file == "":
             # taking in the attributes directly from the constructor
             self.gene = genetic_code
@@ -74,6 +81,8 @@ class Circuit_diagram:
             self.read_data(file)
         self.g_frac = g_frac
         self.w_frac = w_frac
+        if self.file_fractions is not None:
+            self.g_frac, self.w_frac = self.file_fractions
         self.g_in = g_in
         self.w_in = w_in
         self.make_graph()
@@ -115,6 +124,14 @@ class Circuit_diagram:
                     self.performance = float(perf)
                 else:
                     self.performance = -np.nan
+                # fractions of each unit, optional
+                g_frac = np.fromstring(f.readline(), dtype=float, sep=",")
+                w_frac = np.fromstring(f.readline(), dtype=float, sep=",")
+                if len(g_frac) > 0:
+                    if (len(g_frac) != (len(self.gene)-1)/2 or
+                            len(w_frac) != len(g_frac)):
+                        raise ValueError("invalid data file")
+                    self.file_fractions = (g_frac, w_frac)
             # extract the other information from the file name
             self.iteration = file.split(".")[-2].split("_")[-1]
             # base the output image file name on the input data file name
@@ -208,6 +225,9 @@ class Circuit_diagram:
             # flow ratio, 0=100% -> discretised and rounded to 11 integers 0-10
             flow_ratios = np.empty_like(self.gene)
             flow_ratios[0] = round(self.g_in / (self.g_in + self.w_in), 1)*10
+            # the same fractions for every unit, or one per unit
+            g_frac = np.broadcast_to(self.g_frac, conc_g.shape)
+            w_frac = np.broadcast_to(self.w_frac, conc_w.shape)
 
             for i in range(0, len(self.gormanium)-2):
                 # first value is just the feed, which can be plot by itself
@@ -215,10 +235,10 @@ class Circuit_diagram:
                 # last two values are inflows to the two sinks
                 # which can also be ignored as they are derived through
                 # this conversion
-                conc_g[i] = round(self.g_frac*self.gormanium[i], 2)
-                tail_g[i] = round((1-self.g_frac)*self.gormanium[i], 2)
-                conc_w[i] = round(self.w_frac*self.waste[i], 2)
-                tail_w[i] = round((1-self.w_frac)*self.waste[i], 2)
+                conc_g[i] = round(g_frac[i]*self.gormanium[i], 2)
+                tail_g[i] = round((1-g_frac[i])*self.gormanium[i], 2)
+                conc_w[i] = round(w_frac[i]*self.waste[i], 2)
+                tail_w[i] = round((1-w_frac[i])*self.waste[i], 2)
 
                 # in the gene array, first value of each cell is the conc
                 # outflow, second value is the tailings outflow
@@ -293,17 +313,95 @@ class Circuit_diagram:
                           cleanup=True, format="png")
 
 
-if __name__ == "__main__":
-    # if this script is run directly, by default it will visualise
-    # all circuit located in the data/ folder, and export it to the
-    # visualization/figures folder
-
-    for data in os.listdir(os.path.join(os.path.dirname(__file__),
-                                        "..", "data")):
-        if (data.endswith(".txt") & data.startswith("circuit")):
-            try:
-                graph = Circuit_diagram(file=os.path.join(
-                    os.path.dirname(__file__), "..", "data", data))
-                graph.draw()
-            except ValueError:
+
+"""
+Read the circuits of a generation log (written by the solver with
+`--log FILE`) as they are appended, without reading the file again.
+Each line is a JSON object with the keys "run", "generation",
+"performance", "circuit" and, if known, "gormanium" and "waste".
+
+:param file: path of the log
+:type  file: string
+:param poll_interval: seconds to wait before looking for new lines
+:type  poll_interval: number (optional), default to 0.5
+:param from_start: whether to also read the lines already in the file
+:type  from_start: bool (optional), default to True
+:param wait: whether to wait for new lines at the end of the file,
+        rather than stopping
+:type  wait: bool (optional), default to True
+:return: generator of the records, as dictionaries
+"""
+
+
+def follow_log(file, poll_interval=0.5, from_start=True, wait=True):
+    while not os.path.isfile(file):
+        # the solver may not have written anything yet
+        if not wait:
+            return
+        time.sleep(poll_interval)
+    with open(file) as f:
+        if not from_start:
+            f.seek(0, os.SEEK_END)
+        partial = ""
+        while True:
+            line = f.readline()
+            if line == "":
+                if not wait:
+                    return
+                time.sleep(poll_interval)
+                continue
+            partial += line
+            if not partial.endswith("\n"):
+                # the rest of the line has not been written yet
                 continue
+            record = json.loads(partial)
+            partial = ""
+            yield record
+
+
+"""
+Make the diagram of a record of a generation log
+
+:param record: a record returned by follow_log
+:type  record: dictionary
+:return: the diagram, drawn as run_[run]_generation_[generation]
+"""
+
+
+def diagram_from_record(record):
+    return Circuit_diagram(
+        genetic_code=np.array(record["circuit"], dtype=int),
+        gormanium=np.array(record.get("gormanium", []), dtype=float),
+        waste=np.array(record.get("waste", []), dtype=float),
+        iteration=record["generation"],
+        performance=record["performance"],
+        output_file="run_{}_generation_{}".format(record["run"],
+                                                  record["generation"]))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--follow", metavar="LOG", default="",
+                        help="draw the circuits of a generation log as "
+                             "the solver appends them")
+    parser.add_argument("--no-wait", action="store_true",
+                        help="with --follow, stop at the end of the log")
+    args = parser.parse_args()
+
+    if args.follow != "":
+        for record in follow_log(args.follow, wait=not args.no_wait):
+            diagram_from_record(record).draw()
+    else:
+        # if this script is run directly, by default it will visualise
+        # all circuit located in the data/ folder, and export it to the
+        # visualization/figures folder
+
+        for data in os.listdir(os.path.join(os.path.dirname(__file__),
+                                            "..", "data")):
+            if (data.endswith(".txt") & data.startswith("circuit")):
+                try:
+                    graph = Circuit_diagram(file=os.path.join(
+                        os.path.dirname(__file__), "..", "data", data))
+                    graph.draw()
+                except ValueError:
+                    continue